@@ -81,16 +81,98 @@
 	*/
 //#	define USE_TIMESTAMP_IMUNOTMOVING true
 
+	/*	DONT_USE_SIMD
+	**	use scalar code instead of SSE2/NEON for batch conversion of raw sensor values
+	*/
+//#	define DONT_USE_SIMD true
+
 	/*	TESTLOCATION
 	**	latitude,longitude,height,name
 	*/
 #	define TESTLOCATION (+49.964608),(+9.146783),(+145),("Aschaffenburg")
 
+	/*	IMU_BUFFER_SIZE
+	**	samples kept per sensor (ring buffer), power of two
+	**	limits the low pass filter window
+	*/
+#	define IMU_BUFFER_SIZE 1024
+	/*	IMU_FIR_MAXTAPS
+	**	maximum number of taps of IMU_Data FIR filter
+	*/
+#	define IMU_FIR_MAXTAPS 64
+
+	/*	TELESCOPE_ORIENTATION_SIZE
+	**	orientation history entries kept by MHTelescope (ring buffer), power of two
+	*/
+#	define TELESCOPE_ORIENTATION_SIZE 1024
+
+	/*	TELESCOPE_POLL_(...)
+	**	adaptive polling of RTIMULib sensor, rates in Hz, slewing polls at sensor rate
+	**	idle after seconds without motion, slewing after consecutive samples above
+	**	motion threshold (radians per second), tracking again after hold seconds
+	**	backoff doubles up to maximum milli seconds after failed polls
+	*/
+#	define TELESCOPE_POLL_TRACKING 50
+#	define TELESCOPE_POLL_IDLE 2
+#	define TELESCOPE_POLL_IDLEAFTER 30
+#	define TELESCOPE_POLL_SLEWMOTION 0.2
+#	define TELESCOPE_POLL_SLEWSAMPLES 3
+#	define TELESCOPE_POLL_SLEWHOLD 2
+#	define TELESCOPE_POLL_BACKOFF 256
+
+	/*	THREAD_(...)
+	**	default real time configuration of sensor polling threads
+	**	priority 0 for default scheduling, otherwise SCHED_FIFO 1..99
+	**	CPU -1 for any, otherwise number of CPU to pin thread to
+	**	jitter histogram buckets, last bucket 2^(n-2) micro seconds and more
+	*/
+#	define THREAD_PRIORITY 0
+#	define THREAD_CPU -1
+#	define THREAD_JITTER_BUCKETS 16
+	/*	METRICS_(...)
+	**	linear sub buckets per power of two in instrumentation histograms, power of two
+	**	seconds between metrics dumps of polling thread into log file
+	*/
+#	define METRICS_SUBBUCKETS 8
+#	define METRICS_DUMP_INTERVAL 60
+
 	/*	I2C_BUFFER_(...)
 	**	configuration of buffer size for i2c communication
 	**	unnecessary if RTIMULib is used
 	*/
 #	define I2C_BUFFER_MAXPAGE 4
 #	define I2C_BUFFER_PAGESIZE 256
+	/*	I2C_FIFO_(...)
+	**	LSM9DS1 FIFO depth and watermark level for FIFO continuous mode
+	**	reading thread wakes up once per watermark level samples
+	*/
+#	define I2C_FIFO_DEPTH 32
+#	define I2C_FIFO_WATERMARK 28
+	/*	I2C_DRDY_TIMEOUT
+	**	milli seconds to wait for data ready interrupt, before reading anyway
+	*/
+#	define I2C_DRDY_TIMEOUT 100
+	/*	I2C_REGISTER_REFRESH
+	**	seconds between readings of configuration registers, if not invalidated before
+	**	notices sensor reset or configuration by other bus masters
+	*/
+#	define I2C_REGISTER_REFRESH 60
+	/*	I2C_BUS_(...)
+	**	sensors attached to one I2Cbus reading thread
+	**	output registers of sensors due within window micro seconds are read together
+	*/
+#	define I2C_BUS_DEVICES 8
+#	define I2C_BUS_WINDOW 500
+
+	/*	SIDEREAL_CACHE_SPAN
+	**	seconds between exact LMST anchors of MHLocation, linear interpolation in between
+	**	at most 3600, interpolation error stays far below 1e-9 degrees
+	*/
+#	define SIDEREAL_CACHE_SPAN 600
+	/*	PRECESSION_CACHE_SPAN
+	**	seconds between calculations of precession and nutation rotations
+	**	within one minute nutation changes less than 0.0001 arcsec
+	*/
+#	define PRECESSION_CACHE_SPAN 60
 
 #endif
@@ -27,7 +27,7 @@
 #include <cstdlib>
 //#include <cstring>
 #include <cstdio>
-//#include <cmath>
+#include <cmath>
 //#include <climits>
 //#include <exception>
 //#include <stdexcept>
@@ -42,6 +42,7 @@ namespace piScope
 	MHAstroTime::MHAstroTime(MHAstroTime* ts)
 	{
 		this->UTC = ts->UTC;
+		this->J2000ns = ts->J2000ns;
 		this->TimeLocation = ts->TimeLocation;
 	}
 	MHAstroTime::MHAstroTime(time_t ts, MHLocation* loc)
@@ -57,15 +58,7 @@ namespace piScope
 
 	time_t MHAstroTime::Set(time_t ts)
 	{
-		if(1 == ts)
-		{
-			this->UTC = time(NULL);
-		}
-		else
-		{
-			this->UTC = ts;
-		}
-		return(this->UTC);
+		return(MHTimeStamp::Set(ts));
 	}
 
 	MHLocation* MHAstroTime::SetLocation(MHLocation* loc)
@@ -86,39 +79,97 @@ namespace piScope
 	time_t MHAstroTime::Get(int type) const
 	{
 		//	get time stamp (-1=UTC, 0=LMST, 1=GMST, 2=JD, 3=MJD)
-		if(0 == type)
-		{
-			time_t LMST;
-			J2000_UTC2LMST(this->UTC, LMST, this->TimeLocation->GetLongitude());
-			return(LMST);
-		}
-		else if(1 == type)
+		if(0 == type || 1 == type)
 		{
-			time_t GMST;
-			J2000_UTC2LMST(this->UTC, GMST, 0);
-			return(GMST);
+			//	sidereal seconds = angle * (86400s / 360)
+			time_t MST = this->GetAngleMST(1 == type) * (EARTH_SECONDSPERDAY / FULLCIRCLE_DEGREE);
+			return(MST);
 		}
-		else if(2 == type)
+		else if(2 == type || 3 == type)
 		{
-			double JD = TIME_UTC2JD(this->UTC);
+			double JD = this->GetJulianDate(3 == type);
 			return(JD);
 		}
-		else if(3 == type)
-		{
-			double MJD = TIME_UTC2MJD(this->UTC);
-			return(MJD);
-		}
 		return(this->UTC);
 	}
 
 	double MHAstroTime::GetAngleMST(int GMST) const
 	{
-		double mst;
-		//	get Mean Sidereal Time angle in seconds
-		J2000_UTC2LMST(this->UTC, mst, (GMST ?0 :this->TimeLocation->GetLongitude()));
-		//	angle = seconds / (86400s / 360)
-		mst /= EARTH_ROTATIONSPD;
-		return(mst);
+		//	get Mean Sidereal Time angle, Local from interpolation cache of location
+		if(!GMST)
+		{
+			return(this->TimeLocation->GetAngleLMST(this->J2000ns));
+		}
+		return(MHAstroTime::AngleGMST(this->J2000ns));
+	}
+	double MHAstroTime::AngleGMST(int64_t ns)
+	{
+		/*	GMST = 280.46061837 + 360.98564736629 * d + 0.000387933 * t^2 - t^3 / 38710000
+		**	d = days since J2000.0 (UT1), t = d / 36525 (IAU 1982, Meeus 12.4)
+		**	whole days add full circles, only day fraction and 0.98564736629 per day remain,
+		**	so no large angle swallows the sub-second part
+		*/
+		int64_t days = ns / TIME_NSPERDAY;
+		int64_t rest = ns % TIME_NSPERDAY;
+		if(0 > rest)
+		{
+			rest += TIME_NSPERDAY;
+			--days;
+		}
+		double fraction = (double)rest / TIME_NSPERDAY;
+		double d = (double)days + fraction;
+		double t = d / (JULIAN_DAYSPERYEAR * 100);
+		double gmst = 280.46061837 + (360.0 * fraction) + (0.98564736629 * d) + (t * t * (0.000387933 - (t / 38710000.0)));
+		gmst = fmod(gmst, FULLCIRCLE_DEGREE);
+		if(0 > gmst)
+		{
+			gmst += FULLCIRCLE_DEGREE;
+		}
+		return(gmst);
+	}
+	void MHAstroTime::AngleGMST(const int64_t* ns, double* gmst, size_t count)
+	{
+		if(0 == count)
+		{
+			return;
+		}
+		//	first time stamp exact, others by small difference in days (no int64 division in loop)
+		const int64_t origin = ns[0];
+		const double base = MHAstroTime::AngleGMST(origin);
+		const double t0 = J2000_NS2DAYS(origin) / (JULIAN_DAYSPERYEAR * 100);
+		const double term0 = t0 * t0 * (0.000387933 - (t0 / 38710000.0));
+		for(size_t index=0; count>index; ++index)
+		{
+			double delta = J2000_NS2DAYS(ns[index] - origin);
+			double t = t0 + (delta / (JULIAN_DAYSPERYEAR * 100));
+			double angle = base + (360.98564736629 * delta) + (t * t * (0.000387933 - (t / 38710000.0))) - term0;
+			gmst[index] = DEGREE_WRAP(angle);
+		}
+	}
+	void MHAstroTime::AngleLMST(const int64_t* ns, const double* lon, double* lmst, size_t count)
+	{
+		MHAstroTime::AngleGMST(ns, lmst, count);
+		for(size_t index=0; count>index; ++index)
+		{
+			double angle = lmst[index] + lon[index];
+			lmst[index] = DEGREE_WRAP(angle);
+		}
+	}
+	void MHAstroTime::HourAngle(const double* lmst, const double* ra, double* ha, size_t count)
+	{
+		for(size_t index=0; count>index; ++index)
+		{
+			double angle = lmst[index] - ra[index];
+			ha[index] = DEGREE_WRAP(angle);
+		}
+	}
+	void MHAstroTime::HourAngle(double lmst, const double* ra, double* ha, size_t count)
+	{
+		for(size_t index=0; count>index; ++index)
+		{
+			double angle = lmst - ra[index];
+			ha[index] = DEGREE_WRAP(angle);
+		}
 	}
 
 	MHLocation* MHAstroTime::GetLocation(void) const
@@ -36,6 +36,7 @@
 #	include "Location.hpp"
 
 #	include <ctime>
+#	include <cstddef>
 
 namespace piScope
 {
@@ -61,6 +62,11 @@ namespace piScope
 		//	public access methods
 		time_t Get(int type =-1) const;	/*!< get time stamp (-1=UTC, 0=LMST, 1=GMST) */
 		double GetAngleMST(int GMST=true) const;	/*!< get hour angle of time stamp in Local or Greenwich Mean Sidereal Time */
+		static double AngleGMST(int64_t ns);	/*!< get Greenwich Mean Sidereal angle in degrees at nano seconds since J2000.0 (UT1) */
+		static void AngleGMST(const int64_t* ns, double* gmst, size_t count);	/*!< batch of GMST angles, degrees */
+		static void AngleLMST(const int64_t* ns, const double* lon, double* lmst, size_t count);	/*!< batch of LMST angles for east longitudes, degrees */
+		static void HourAngle(const double* lmst, const double* ra, double* ha, size_t count);	/*!< batch of hour angles 0..360 from LMST and right ascension, degrees */
+		static void HourAngle(double lmst, const double* ra, double* ha, size_t count);	/*!< batch of hour angles of a catalog at one LMST, degrees */
 		MHLocation* GetLocation(void) const;	/*!< get location of time stamp */
 		const char* ToString(int type =-1) const;	/*!< get time stamp (-1=UTC, 0=LMST, 1=GMST) */
 	};
@@ -74,6 +74,9 @@ namespace piScope
 	}
 	MHAstroVector::~MHAstroVector()
 	{
+		//	time stamp and base offset are always owned, location may be shared
+		delete(this->TS);
+		delete(this->BaseOffset);
 	}
 
 	MHLocation* MHAstroVector::SetLocation(MHLocation* loc)
@@ -119,6 +122,16 @@ namespace piScope
 		return(this->TS);
 	}
 
+	MHAstroTime* MHAstroVector::SetTimeJ2000(int64_t ns)
+	{
+		if(NULL == this->TS)
+		{
+			this->TS = new MHAstroTime(1,this->LocationOffset);
+		}
+		this->TS->SetJ2000(ns);
+		return(this->TS);
+	}
+
 	const char* MHAstroVector::ToString(void) const
 	{
 		return(MHVector3D::ToString());
@@ -147,16 +160,8 @@ namespace piScope
 			this->TS->SetLocation(this->LocationOffset);
 		}*/
 		//	calculate hour angle
-		double angle = this->TS->GetAngleMST() - RAD2DEG(this->Z);
-		while(360 < angle)
-		{
-			angle -= 360;
-		}
-		while(0 > angle)
-		{
-			angle += 360;
-		}
-		return(angle);	//	angle from Local Mean Sidereal Time
+		double angle = this->TS->GetAngleMST(false) - RAD2DEG(this->Z);
+		return(DEGREE_WRAP(angle));	//	angle from Local Mean Sidereal Time
 	}
 
 };
@@ -75,6 +75,7 @@ namespace piScope
 		MHLocation* SetLocation(double latX, double lonY, double heightZ);	/*!< set new Location */
 		MHVector3D* SetBase(double vecX, double vecY, double vecZ, double vecLen);	/*!< set new Base Offset */
 		MHAstroTime* SetTime(time_t ts =1);	/*!< set new time stamp */
+		MHAstroTime* SetTimeJ2000(int64_t ns);	/*!< set new time stamp in nano seconds since J2000.0 */
 
 		//	public access methods
 		const char* ToString(void) const;	/*!< simple data output */
@@ -0,0 +1,255 @@
+/*	I2Cbackend
+ *	file descriptor layer of I2C bus communication
+ *	linux i2c-dev access, loopback register simulation and combined I2C_RDWR transactions
+ */
+
+#include "I2Cbackend.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+
+#include <sys/ioctl.h>
+#include <fcntl.h>
+
+using namespace std;
+namespace rpiScope
+{
+
+	I2Cbackend::I2Cbackend()
+	{
+	}
+	I2Cbackend::~I2Cbackend()
+	{
+	}
+	int I2Cbackend::Open(const char* i2cbusdevice)
+	{
+		return(open(i2cbusdevice, O_RDWR));
+	}
+	int I2Cbackend::Close(int fd)
+	{
+		return(close(fd));
+	}
+	int I2Cbackend::Ioctl(int fd, unsigned long request, void* argument)
+	{
+		return(ioctl(fd, request, argument));
+	}
+	I2Cbackend* I2Cbackend::Linux(void)
+	{
+		static I2Cbackend i2cdev;
+		return(&i2cdev);
+	}
+
+	I2Cloopback::I2Cloopback(unsigned long i2cfuncs)
+		: count_ioctl(0), count_funcs(0), count_tenbit(0), count_slave(0), count_smbus(0), count_rdwr(0), count_bytes(0)
+		, funcs(i2cfuncs), fdopen(0), slave(-1)
+	{
+		if(0 == this->funcs)
+		{
+			//	plain I2C and the SMBus calls used by I2Cdevice
+			this->funcs = I2C_FUNC_I2C | I2C_FUNC_SMBUS_READ_BYTE_DATA | I2C_FUNC_SMBUS_WRITE_BYTE_DATA
+				| I2C_FUNC_SMBUS_READ_I2C_BLOCK | I2C_FUNC_SMBUS_WRITE_I2C_BLOCK;
+		}
+		memset(&this->pointer[0], 0x00, sizeof(this->pointer));
+		memset(&this->registers[0][0], 0x00, sizeof(this->registers));
+		memset(&this->selfclear[0][0], 0x00, sizeof(this->selfclear));
+		memset(&this->subaddress[0], 0x00, sizeof(this->subaddress));
+	}
+	I2Cloopback::~I2Cloopback()
+	{
+	}
+
+	int I2Cloopback::Open(const char* i2cbusdevice)
+	{
+		//	any positive number is a valid file descriptor for I2Cdevice
+		return(1000 + this->fdopen++);
+	}
+	int I2Cloopback::Close(int fd)
+	{
+		this->slave = -1;
+		return(0);
+	}
+
+	int I2Cloopback::Ioctl(int fd, unsigned long request, void* argument)
+	{
+		++this->count_ioctl;
+		if(I2C_FUNCS == request)
+		{
+			++this->count_funcs;
+			*((unsigned long*)argument) = this->funcs;
+			return(0);
+		}
+		else if(I2C_TENBIT == request)
+		{
+			++this->count_tenbit;
+			return(0 == argument ?0 :-1);
+		}
+		else if(I2C_SLAVE == request || I2C_SLAVE_FORCE == request)
+		{
+			++this->count_slave;
+			this->slave = ((uintptr_t)argument) &0x7F;
+			return(0);
+		}
+		else if(I2C_SMBUS == request)
+		{
+			++this->count_smbus;
+			struct i2c_smbus_ioctl_data* args = (struct i2c_smbus_ioctl_data*)argument;
+			if(0 > this->slave || NULL == args->data)
+			{
+				errno = ENXIO;
+				return(-1);
+			}
+			unsigned char address = this->slave;
+			if(I2C_SMBUS_BYTE_DATA == args->size)
+			{
+				if(I2C_SMBUS_READ == args->read_write)
+					args->data->byte = this->ReadRegister(address, args->command);
+				else
+					this->WriteRegister(address, args->command, args->data->byte);
+				++this->count_bytes;
+				return(0);
+			}
+			else if(I2C_SMBUS_I2C_BLOCK_DATA == args->size)
+			{
+				int length = (I2C_SMBUS_BLOCK_MAX < args->data->block[0] ?I2C_SMBUS_BLOCK_MAX :args->data->block[0]);
+				unsigned char step = this->Increment(address, args->command);
+				for(int pos=0; length>pos; ++pos)
+				{
+					if(I2C_SMBUS_READ == args->read_write)
+						args->data->block[1+pos] = this->ReadRegister(address, args->command +pos*step);
+					else
+						this->WriteRegister(address, args->command +pos*step, args->data->block[1+pos]);
+				}
+				args->data->block[0] = length;
+				this->count_bytes += length;
+				return(0);
+			}
+			errno = EINVAL;
+			return(-1);
+		}
+		else if(I2C_RDWR == request)
+		{
+			++this->count_rdwr;
+			struct i2c_rdwr_ioctl_data* rdwr = (struct i2c_rdwr_ioctl_data*)argument;
+			if(I2C_RDRW_IOCTL_MAX_MSGS < rdwr->nmsgs)
+			{
+				errno = EINVAL;
+				return(-1);
+			}
+			for(unsigned int msg=0; rdwr->nmsgs>msg; ++msg)
+			{
+				unsigned char address = rdwr->msgs[msg].addr &0x7F;
+				unsigned char* buffer = (unsigned char*)rdwr->msgs[msg].buf;
+				int length = rdwr->msgs[msg].len;
+				if(0 != (rdwr->msgs[msg].flags & I2C_M_RD))
+				{
+					unsigned char step = this->Increment(address, this->pointer[address]);
+					for(int pos=0; length>pos; ++pos, this->pointer[address] += step)
+						buffer[pos] = this->ReadRegister(address, this->pointer[address]);
+					this->count_bytes += length;
+				}
+				else if(0 < length)
+				{
+					//	first byte is the register address, following bytes are written
+					this->pointer[address] = buffer[0];
+					unsigned char step = this->Increment(address, this->pointer[address]);
+					for(int pos=1; length>pos; ++pos, this->pointer[address] += step)
+						this->WriteRegister(address, this->pointer[address], buffer[pos]);
+					this->count_bytes += length -1;
+				}
+			}
+			return(rdwr->nmsgs);
+		}
+		errno = ENOTTY;
+		return(-1);
+	}
+
+	void I2Cloopback::Preset(unsigned char i2caddress, unsigned char reg, unsigned char value, unsigned char selfclearing)
+	{
+		this->registers[i2caddress &0x7F][reg &0x7F] = value;
+		this->selfclear[i2caddress &0x7F][reg &0x7F] = selfclearing;
+	}
+	unsigned char I2Cloopback::Register(unsigned char i2caddress, unsigned char reg) const
+	{
+		return(this->registers[i2caddress &0x7F][reg &0x7F]);
+	}
+	void I2Cloopback::Subaddress(unsigned char i2caddress, bool increment)
+	{
+		this->subaddress[i2caddress &0x7F] = increment;
+	}
+	unsigned char I2Cloopback::Increment(unsigned char i2caddress, unsigned char reg) const
+	{
+		//	without bit 7 set, the register pointer stays and the same register is repeated
+		return((this->subaddress[i2caddress &0x7F] && 0 == (reg &0x80)) ?0 :1);
+	}
+	unsigned char I2Cloopback::ReadRegister(unsigned char i2caddress, unsigned char reg)
+	{
+		return(this->registers[i2caddress &0x7F][reg &0x7F]);
+	}
+	void I2Cloopback::WriteRegister(unsigned char i2caddress, unsigned char reg, unsigned char value)
+	{
+		this->registers[i2caddress &0x7F][reg &0x7F] = value & ~this->selfclear[i2caddress &0x7F][reg &0x7F];
+	}
+
+	I2Cbatch::I2Cbatch()
+	{
+		this->Clear();
+	}
+	void I2Cbatch::Clear(void)
+	{
+		this->transfer.msgs = &this->messages[0];
+		this->transfer.nmsgs = 0;
+	}
+	bool I2Cbatch::Read(unsigned char i2caddress, unsigned char reg, unsigned char* value, int length)
+	{
+		if(2 > this->Space() || 0 >= length)
+		{
+			return(false);
+		}
+		int pos = this->transfer.nmsgs;
+		//	write register address, repeated start, read data
+		this->registers[pos][0] = reg;
+		this->messages[pos].addr = i2caddress;
+		this->messages[pos].flags = 0;
+		this->messages[pos].len = 1;
+		this->messages[pos].buf = (decltype(this->messages[pos].buf))&this->registers[pos][0];
+		this->messages[pos+1].addr = i2caddress;
+		this->messages[pos+1].flags = I2C_M_RD;
+		this->messages[pos+1].len = length;
+		this->messages[pos+1].buf = (decltype(this->messages[pos+1].buf))value;
+		this->transfer.nmsgs += 2;
+		return(true);
+	}
+	bool I2Cbatch::Write(unsigned char i2caddress, unsigned char reg, unsigned char value)
+	{
+		if(1 > this->Space())
+		{
+			return(false);
+		}
+		int pos = this->transfer.nmsgs;
+		this->registers[pos][0] = reg;
+		this->registers[pos][1] = value;
+		this->messages[pos].addr = i2caddress;
+		this->messages[pos].flags = 0;
+		this->messages[pos].len = 2;
+		this->messages[pos].buf = (decltype(this->messages[pos].buf))&this->registers[pos][0];
+		this->transfer.nmsgs += 1;
+		return(true);
+	}
+	int I2Cbatch::Count(void) const
+	{
+		return(this->transfer.nmsgs);
+	}
+	int I2Cbatch::Space(void) const
+	{
+		return(I2C_RDRW_IOCTL_MAX_MSGS - this->transfer.nmsgs);
+	}
+	struct i2c_rdwr_ioctl_data* I2Cbatch::Transfer(void)
+	{
+		this->transfer.msgs = &this->messages[0];
+		return(&this->transfer);
+	}
+
+};
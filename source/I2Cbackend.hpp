@@ -0,0 +1,125 @@
+/*	I2Cbackend
+ *	file descriptor layer of I2C bus communication
+ *	linux i2c-dev access, loopback register simulation and combined I2C_RDWR transactions
+**
+**	piScope project https://github.com/march42/piScope
+**	(C) Copyright 2017 by Marc Hefter
+**
+**	This program is free software; you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation; either version 3 of the License, or
+**	(at your option) any later version.
+**
+**	This program is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with this program; if not, write to the Free Software
+**	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+**	MA 02110-1301 USA.
+ */
+
+/*!	\brief	class I2Cbackend, class I2Cloopback, class I2Cbatch
+ *
+ *	Declaration of class, members and methods.
+ *	All open/close/ioctl calls of I2Cdevice go through an I2Cbackend,
+ *	so the bus can be replaced by a simulation for testing without hardware.
+ */
+
+#ifndef _I2CBACKEND_HPP_
+#define _I2CBACKEND_HPP_
+
+#include "../config.h"
+
+#include <cstdlib>
+#include <cstddef>
+#include <stdint.h>
+
+#if !defined(USE_LINUX_I2CDEV)
+#	include "i2c-dev.h"
+#else
+#	include <linux/i2c-dev.h>
+#	include <linux/i2c.h>
+#endif
+
+using namespace std;
+namespace rpiScope
+{
+
+	class I2Cbackend
+	{
+		public:
+			I2Cbackend();
+			virtual ~I2Cbackend();
+			virtual int Open(const char* i2cbusdevice);
+			virtual int Close(int fd);
+			virtual int Ioctl(int fd, unsigned long request, void* argument);
+			static I2Cbackend* Linux(void);	//	shared default backend, using the i2c-dev kernel interface
+		protected:
+		private:
+	};
+
+	/*	I2Cloopback
+	 *	simulated bus with a register file for every 7-bit device address
+	 *	handles I2C_FUNCS, I2C_TENBIT, I2C_SLAVE, I2C_SMBUS (byte and i2c block data) and I2C_RDWR
+	 *	register address bit 7 is ignored (auto increment flag of ST sensors), reads and writes auto increment
+	 *	devices set with Subaddress() only auto increment with bit 7 of the register address set, like the LSM9DS1 magnetometer
+	 */
+	class I2Cloopback : public I2Cbackend
+	{
+		public:
+			I2Cloopback(unsigned long i2cfuncs=0);
+			virtual ~I2Cloopback();
+			virtual int Open(const char* i2cbusdevice);
+			virtual int Close(int fd);
+			virtual int Ioctl(int fd, unsigned long request, void* argument);
+			void Preset(unsigned char i2caddress, unsigned char reg, unsigned char value, unsigned char selfclearing=0x00);
+			unsigned char Register(unsigned char i2caddress, unsigned char reg) const;
+			void Subaddress(unsigned char i2caddress, bool increment=true);	//	auto increment only with register address bit 7 set
+			//	statistics
+			unsigned long count_ioctl;	//	all ioctl calls
+			unsigned long count_funcs;	//	I2C_FUNCS calls
+			unsigned long count_tenbit;	//	I2C_TENBIT calls
+			unsigned long count_slave;	//	I2C_SLAVE calls
+			unsigned long count_smbus;	//	I2C_SMBUS calls
+			unsigned long count_rdwr;	//	I2C_RDWR calls
+			unsigned long count_bytes;	//	data bytes transferred (without register addresses)
+		protected:
+			virtual unsigned char ReadRegister(unsigned char i2caddress, unsigned char reg);
+			virtual void WriteRegister(unsigned char i2caddress, unsigned char reg, unsigned char value);
+			unsigned char Increment(unsigned char i2caddress, unsigned char reg) const;
+			unsigned long funcs;	//	reported I2C_FUNCS
+			int fdopen;	//	count of opened file descriptors
+			int slave;	//	address selected with I2C_SLAVE
+			unsigned char pointer[0x80];	//	register pointer per device
+			unsigned char registers[0x80][0x80];	//	register file per device
+			unsigned char selfclear[0x80][0x80];	//	bits cleared right after writing (reboot, reset)
+			bool subaddress[0x80];	//	auto increment needs register address bit 7
+		private:
+	};
+
+	/*	I2Cbatch
+	 *	message set for one combined I2C_RDWR transaction (one STOP only)
+	 *	every register read needs two messages, register address write and data read
+	 */
+	class I2Cbatch
+	{
+		public:
+			I2Cbatch();
+			void Clear(void);
+			bool Read(unsigned char i2caddress, unsigned char reg, unsigned char* value, int length);
+			bool Write(unsigned char i2caddress, unsigned char reg, unsigned char value);
+			int Count(void) const;
+			int Space(void) const;
+			struct i2c_rdwr_ioctl_data* Transfer(void);
+		protected:
+			struct i2c_msg messages[I2C_RDRW_IOCTL_MAX_MSGS];
+			unsigned char registers[I2C_RDRW_IOCTL_MAX_MSGS][2];
+			struct i2c_rdwr_ioctl_data transfer;
+		private:
+	};
+
+};
+#endif	/* _I2CBACKEND_HPP_ */
@@ -0,0 +1,306 @@
+/*	I2Cbus
+ *	one file descriptor and one reading thread per I2C bus
+ *	deadline scheduling of all attached sensors, combined I2C_RDWR transactions
+ */
+
+#include "I2Cbus.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <cmath>
+#include <unistd.h>
+#include <time.h>
+
+using namespace std;
+namespace rpiScope
+{
+
+	I2Cbus::I2Cbus(const char* i2cbusdevice, I2Cbackend* i2cbackend)
+		: I2Cdevice(-1, i2cbusdevice, i2cbackend), transactions(0), samples(0), count(0), combined(false)
+	{
+#		if defined(DEBUG4)
+		//	function, step, extra
+		printf("\t%s\t%s\t%s\n", "I2Cbus", "constructor begin", "");
+#		endif
+		memset(&this->devices[0], 0x00, sizeof(this->devices));
+		pthread_mutex_init(&this->mutex, NULL);
+		this->pthread_stopping = true;
+		this->pthread_config.Priority = THREAD_PRIORITY;
+		this->pthread_config.CPU = THREAD_CPU;
+		this->pthread_config.LockMemory = false;
+		//	combined transactions, if supported by the adapter
+		if(0 <= this->fdbus && 0 <= this->backend->Ioctl(this->fdbus, I2C_FUNCS, &this->i2cfuncs))
+		{
+			this->i2cprobed = true;
+			this->combined = (0 != (this->i2cfuncs & I2C_FUNC_I2C));
+		}
+		else
+		{
+			perror("I2Cbus probing I2C_FUNCS failed");
+		}
+	}
+	I2Cbus::~I2Cbus()
+	{
+#		if defined(DEBUG4)
+		//	function, step, extra
+		printf("\t%s\t%s\t%s\n", "I2Cbus", "destructor", "");
+#		endif
+		this->pthread_stopp();
+		while(0 < this->count)
+		{
+			this->Detach(this->devices[0].sensor);
+		}
+		pthread_mutex_destroy(&this->mutex);
+	}
+
+	bool I2Cbus::Attach(I2Csensor* sensor)
+	{
+		if(NULL == sensor || !sensor->pthread_stopping || sensor->backend != this->backend)
+		{
+			perror("I2Cbus attach needs stopped sensor on same backend");
+			return(false);
+		}
+		pthread_mutex_lock(&this->mutex);
+		for(int index=0; this->count>index; ++index)
+		{
+			if(sensor == this->devices[index].sensor)
+			{
+				pthread_mutex_unlock(&this->mutex);
+				return(true);
+			}
+		}
+		if(I2C_BUS_DEVICES <= this->count)
+		{
+			pthread_mutex_unlock(&this->mutex);
+			perror("I2Cbus has no space for sensor");
+			return(false);
+		}
+		sensor->I2Cshare(this);
+		I2Cbusdevice& device = this->devices[this->count++];
+		device.sensor = sensor;
+		device.readrate = 10;	//	until register buffer is read
+		device.period = 1000000000 / device.readrate;
+		device.deadline = Metrics_Loop::Now();
+		device.samples = 0;
+		pthread_mutex_unlock(&this->mutex);
+#		if defined(DEBUG4)
+		//	function, step, extra
+		printf("\t%s\t%d\t%s\n", "I2Cbus", this->count, "attached");
+#		endif
+		return(true);
+	}
+	void I2Cbus::Detach(I2Csensor* sensor)
+	{
+		pthread_mutex_lock(&this->mutex);
+		for(int index=0; this->count>index; ++index)
+		{
+			if(sensor == this->devices[index].sensor)
+			{
+				sensor->I2Cshare(NULL);
+				this->devices[index] = this->devices[--this->count];
+				break;
+			}
+		}
+		pthread_mutex_unlock(&this->mutex);
+	}
+	int I2Cbus::Devices(void) const
+	{
+		return(this->count);
+	}
+
+	void I2Cbus::Reschedule(I2Cbusdevice& device, uint64_t now)
+	{
+		device.deadline += device.period;
+		if(device.deadline <= now)
+		{
+			//	skip missed deadlines, keep phase
+			uint64_t skipped = (now - device.deadline) / device.period +1;
+			device.deadline += skipped * device.period;
+			device.sensor->metrics.Missed.Add(skipped);
+		}
+	}
+	void I2Cbus::Transfer(I2Cbatch& batch, I2Csensor** batched, int& sensors, uint64_t start)
+	{
+		if(0 == sensors)
+		{
+			return;
+		}
+		if(this->I2Ctransfer(batch))
+		{
+			++this->transactions;
+			this->metrics.Reads.Add();
+			this->metrics.QueueDepth.Record(sensors);
+			for(int index=0; sensors>index; ++index)
+			{
+				batched[index]->I2Ccomplete(start);
+			}
+		}
+		else
+		{
+			//	adapter rejects combined transaction, sensors read themselves from now on
+			this->combined = false;
+			this->metrics.Failures.Add();
+			for(int index=0; sensors>index; ++index)
+			{
+				batched[index]->I2Ccombined = false;	//	no own I2C_RDWR, SMBus reading
+				batched[index]->I2Creadimu();
+			}
+		}
+		batch.Clear();
+		sensors = 0;
+	}
+	int I2Cbus::Poll(uint64_t now)
+	{
+		pthread_mutex_lock(&this->mutex);
+		uint64_t start = Metrics_Loop::Now();
+		this->metrics.Loop(start);
+		I2Cbatch batch;
+		I2Csensor* batched[I2C_BUS_DEVICES];
+		int sensors = 0;
+		int read = 0;
+		for(int index=0; this->count>index; ++index)
+		{
+			I2Cbusdevice& device = this->devices[index];
+			if(device.deadline > now + (uint64_t)I2C_BUS_WINDOW *1000)
+			{
+				continue;
+			}
+			I2Csensor* sensor = device.sensor;
+			sensor->metrics.Loop(now);
+			if(sensor->FIFOenabled())
+			{
+				//	FIFO continuous mode, wake up when threshold level is reached
+				sensor->FIFOdrain();
+				device.period = (uint64_t)(1000000000.0 * sensor->fifo_watermark / (10<sensor->fifo_rate ?sensor->fifo_rate :10));
+			}
+			else if(0 == (device.samples % device.readrate))
+			{
+				//	register buffer, status and configuration (1Hz interval)
+				sensor->I2Cread2buffer();
+				device.readrate = round(10<sensor->datarate ?sensor->datarate :10);
+				device.period = 1000000000 / device.readrate;
+			}
+			else if(this->combined && sensor->I2Ccombined)
+			{
+				if(!sensor->I2Cprepare(batch))
+				{
+					//	transaction full, read prepared sensors first
+					this->Transfer(batch, &batched[0], sensors, start);
+					if(this->combined)
+						sensor->I2Cprepare(batch);
+				}
+				if(this->combined)
+				{
+					batched[sensors++] = sensor;
+				}
+				else
+				{
+					//	adapter rejected the transaction just now
+					sensor->I2Ccombined = false;
+					sensor->I2Creadimu();
+				}
+			}
+			else
+			{
+				sensor->I2Creadimu();
+			}
+			++device.samples;
+			++read;
+			this->Reschedule(device, now);
+		}
+		if(this->combined)
+		{
+			this->Transfer(batch, &batched[0], sensors, start);
+		}
+		this->samples += read;
+		this->metrics.ReadDuration.Record(Metrics_Loop::Now() - start);
+		pthread_mutex_unlock(&this->mutex);
+		return(read);
+	}
+	uint64_t I2Cbus::NextDeadline(void) const
+	{
+		uint64_t deadline = 0;
+		pthread_mutex_lock(&this->mutex);
+		for(int index=0; this->count>index; ++index)
+		{
+			if(0 == deadline || this->devices[index].deadline < deadline)
+				deadline = this->devices[index].deadline;
+		}
+		pthread_mutex_unlock(&this->mutex);
+		return(deadline);
+	}
+
+	void I2Cbus::pthread_configure(const Thread_Config& config)
+	{
+		this->pthread_config = config;
+	}
+	void I2Cbus::pthread_I2Creading(void)
+	{
+#		if defined(DEBUG4)
+		//	function, step, extra
+		printf("\t%s\t%s\t%s\n", "I2Cbus", "pthread_I2Creading", "");
+#		endif
+		if(!this->pthread_stopping)
+		{
+			return;
+		}
+		//	deadlines start now, Poll may have been called with other clock
+		pthread_mutex_lock(&this->mutex);
+		uint64_t now = Metrics_Loop::Now();
+		for(int index=0; this->count>index; ++index)
+		{
+			this->devices[index].deadline = now;
+		}
+		pthread_mutex_unlock(&this->mutex);
+		this->pthread_stopping = false;
+		int rc = Thread_Create(&this->pthread_read, &this->pthread_attributes, this->pthread_config, pthread_BusReading, (void *)this);
+		if(0 != rc)
+		{
+			errno = rc;
+			perror("pthread_create failed (pthread_BusReading)");
+			pthread_attr_destroy(&this->pthread_attributes);
+			this->pthread_stopping = true;
+		}
+	}
+	void I2Cbus::pthread_stopp(void)
+	{
+		if(this->pthread_stopping)
+		{
+			return;
+		}
+		this->pthread_stopping = true;
+		pthread_attr_destroy(&this->pthread_attributes);
+		pthread_join(this->pthread_read, NULL);
+	}
+
+	void *pthread_BusReading(void *data)
+	{
+		I2Cbus* mother = (I2Cbus*)data;
+#		if defined(DEBUG4)
+		//	function, step, extra
+		printf("\t%s\t%d\t%s\n", "pthread_BusReading", mother->Devices(), "sensors");
+#		endif
+		while(!mother->pthread_stopping)
+		{
+			uint64_t deadline = mother->NextDeadline();
+			if(0 == deadline)
+			{
+				usleep(100000);	//	no sensor attached
+				continue;
+			}
+			//	sleep until earliest deadline, no drift from reading time
+			struct timespec wake;
+			wake.tv_sec = deadline /1000000000;
+			wake.tv_nsec = deadline %1000000000;
+			while(EINTR == clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL));
+			mother->Poll(Metrics_Loop::Now());
+		}
+#		if defined(DEBUG4)
+		//	function, step, extra
+		printf("\t%s\t%s\t%s\n", "pthread_BusReading", "stopping", "");
+#		endif
+		pthread_exit(NULL);
+	}
+
+};
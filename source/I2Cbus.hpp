@@ -0,0 +1,95 @@
+/*	I2Cbus
+ *	one file descriptor and one reading thread per I2C bus
+ *	deadline scheduling of all attached sensors, combined I2C_RDWR transactions
+**
+**	piScope project https://github.com/march42/piScope
+**	(C) Copyright 2017 by Marc Hefter
+**
+**	This program is free software; you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation; either version 3 of the License, or
+**	(at your option) any later version.
+**
+**	This program is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with this program; if not, write to the Free Software
+**	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+**	MA 02110-1301 USA.
+ */
+
+/*!	\brief	class I2Cbus
+ *
+ *	Declaration of class, members and methods.
+ *	Attached sensors share the file descriptor of the bus and are read by
+ *	the bus thread instead of their own pthread_DataReading. Every sensor
+ *	has its own period and deadline, output registers of all sensors due
+ *	within I2C_BUS_WINDOW are read with one combined transaction.
+ *	Register buffer (I2Cread2buffer) and FIFO reading stay per sensor.
+ *	Sensors have to be detached before they are destroyed.
+ */
+
+#ifndef _I2CBUS_HPP_
+#define _I2CBUS_HPP_
+
+#include "../config.h"
+#include "I2Csensor.hpp"
+#include "I2Cbackend.hpp"
+#include "Pacer.hpp"
+#include "Metrics.hpp"
+
+#include <cstdlib>
+#include <cstddef>
+#include <stdint.h>
+#include <pthread.h>
+using namespace std;
+namespace rpiScope
+{
+
+	typedef struct I2Cbusdevice
+	{
+		I2Csensor* sensor;
+		uint64_t period;	//	nano seconds
+		uint64_t deadline;	//	CLOCK_MONOTONIC nano seconds
+		unsigned long samples;	//	samples read, every readrate-th reads register buffer
+		int readrate;	//	samples per second, at least 10
+	}	I2Cbusdevice;
+
+	class I2Cbus : public I2Cdevice
+	{
+		public:
+			I2Cbus(const char* i2cbusdevice="/dev/i2c-1", I2Cbackend* i2cbackend=NULL);
+			~I2Cbus();
+			bool Attach(I2Csensor* sensor);	//	shares bus file descriptor, false if sensor thread is running or bus is full
+			void Detach(I2Csensor* sensor);	//	sensor opens own file descriptor again
+			int Devices(void) const;
+			int Poll(uint64_t now);	//	read all sensors due at now (nano seconds), returns number of samples
+			uint64_t NextDeadline(void) const;	//	earliest deadline of attached sensors, 0 for none
+			void pthread_configure(const Thread_Config& config);	//	before pthread_I2Creading
+			void pthread_I2Creading(void);
+			void pthread_stopp(void);
+			unsigned long transactions;	//	combined transactions of output registers
+			unsigned long samples;	//	sensor samples read
+			Metrics_Loop metrics;	//	bus round duration, number of sensors per transaction
+		protected:
+			I2Cbusdevice devices[I2C_BUS_DEVICES];
+			int count;	//	attached devices
+			bool combined;	//	adapter supports I2C_RDWR
+			mutable pthread_mutex_t mutex;	//	attaching against polling
+			//	threading
+			bool pthread_stopping;
+			pthread_t pthread_read;
+			pthread_attr_t pthread_attributes;
+			Thread_Config pthread_config;
+			void Reschedule(I2Cbusdevice& device, uint64_t now);
+			void Transfer(I2Cbatch& batch, I2Csensor** batched, int& sensors, uint64_t start);	//	combined transaction of prepared sensors
+			friend void *pthread_BusReading(void *data);
+		private:
+	};
+	void *pthread_BusReading(void *data);
+
+};
+#endif	/* _I2CBUS_HPP_ */
@@ -5,12 +5,15 @@
  */
 
 #include "I2Csensor.hpp"
-#define BUFFER_I2CREAD_BLOCK(regpage,regfirst,reglast) this->I2Cread(regfirst, &(this->DataBuffer[(regpage*I2C_BUFFER_PAGESIZE) +regfirst]), (reglast-regfirst) +1)
+//	LSM9DS1 magnetometer (page 1) only auto increments with MSB of sub address set
+#define BUFFER_SUBADDRESS(regpage,regaddr) ((I2C_LSM9DS1 == this->sensortype && 1 == regpage) ?(0x80|regaddr) :regaddr)
+#define BUFFER_I2CREAD_BLOCK(regpage,regfirst,reglast) this->I2Cread(BUFFER_SUBADDRESS(regpage,regfirst), &(this->DataBuffer[(regpage*I2C_BUFFER_PAGESIZE) +regfirst]), (reglast-regfirst) +1)
 #define BUFFER_REGISTER(regpage,regaddr) (this->DataBuffer[((regpage*I2C_BUFFER_PAGESIZE) +regaddr)])
 
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <cerrno>
 #include <unistd.h>
 
 #if !defined(USE_LINUX_I2CDEV)
@@ -20,31 +23,84 @@
 #endif
 #include <sys/ioctl.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <cmath>
 #include <climits>
 #include <cassert>
 
-#if defined(USE_MADGWICK_AHRS)
-	namespace Madgwick { extern "C" {
-#		include "../MadgwickAHRS/MadgwickAHRS.h"
-	}};
-#endif // defined
-
 using namespace std;
 namespace rpiScope
 {
 
-	I2Cdevice::I2Cdevice(const int i2cdeviceaddress, const char* i2cbusdevice)
+	//	CLOCK_MONOTONIC in micro seconds, for sample time stamps
+	static uint64_t I2Cmicroseconds(void)
+	{
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		return((uint64_t)now.tv_sec *1000000 + now.tv_nsec /1000);
+	}
+	//	16bit value from sensor register pair
+	static inline int16_t I2Cvalue(const unsigned char* buffer, bool bigendian)
+	{
+		return(bigendian ?(int16_t)((buffer[0] <<8) | buffer[1]) :(int16_t)((buffer[1] <<8) | buffer[0]));
+	}
+
+	/*	register map LSM9DS1, page 0 acc/gyro and page 1 mag
+	 *	ranges in address order, adjacent ranges are read together
+	 */
+	static const I2Cregisterrange I2Cregistermap_LSM9DS1[] =
+	{
+		{0,0x04,0x0D,I2C_CONFIG},	//	ACT_THS..INT2_CTRL
+		{0,0x0F,0x0F,I2C_STATIC},	//	WHO_AM_I
+		{0,0x10,0x14,I2C_CONFIG},	//	CTRL_REG1_G..ORIENT_CFG_G
+		{0,0x15,0x17,I2C_STATUS},	//	INT_GEN_SRC_G, OUT_TEMP
+		{0,0x18,0x1D,I2C_DATA},	//	OUT_X_G..OUT_Z_G
+		{0,0x1E,0x24,I2C_CONFIG},	//	CTRL_REG4..CTRL_REG10
+		{0,0x26,0x27,I2C_STATUS},	//	INT_GEN_SRC_XL, STATUS_REG
+		{0,0x28,0x2D,I2C_DATA},	//	OUT_X_XL..OUT_Z_XL
+		{0,0x2E,0x2E,I2C_CONFIG},	//	FIFO_CTRL
+		{0,0x2F,0x2F,I2C_STATUS},	//	FIFO_SRC
+		{0,0x30,0x37,I2C_CONFIG},	//	INT_GEN_CFG_G..INT_GEN_DUR_G
+		{1,0x05,0x0A,I2C_CONFIG},	//	OFFSET_X_REG_L_M..OFFSET_Z_REG_H_M
+		{1,0x0F,0x0F,I2C_STATIC},	//	WHO_AM_I_M
+		{1,0x20,0x24,I2C_CONFIG},	//	CTRL_REG1_M..CTRL_REG5_M
+		{1,0x27,0x27,I2C_STATUS},	//	STATUS_REG_M
+		{1,0x28,0x2D,I2C_DATA},	//	OUT_X_L_M..OUT_Z_H_M
+		{1,0x30,0x30,I2C_CONFIG},	//	INT_CFG_M
+		{1,0x31,0x31,I2C_STATUS},	//	INT_SRC_M
+		{1,0x32,0x33,I2C_CONFIG},	//	INT_THS_L_M, INT_THS_H_M
+	};
+	/*	register map BNO055, register pages 0 and 1
+	 *	sensor is left on page 0, page 1 only read with configuration
+	 */
+	static const I2Cregisterrange I2Cregistermap_BNO055[] =
+	{
+		{0,0x00,0x07,I2C_STATIC},	//	CHIP_ID..PAGE_ID
+		{0,0x08,0x34,I2C_DATA},	//	ACC_DATA..GRV_DATA, TEMP
+		{0,0x35,0x3A,I2C_STATUS},	//	CALIB_STAT..SYS_ERR
+		{0,0x3B,0x42,I2C_CONFIG},	//	UNIT_SEL..AXIS_MAP_SIGN
+		{0,0x55,0x6A,I2C_CONFIG},	//	ACC_OFFSET..MAG_RADIUS
+		{1,0x08,0x1F,I2C_CONFIG},	//	ACC_CONFIG..GYR_AM_SET
+		{1,0x50,0x5F,I2C_STATIC},	//	UNIQUE_ID
+	};
+
+	I2Cdevice::I2Cdevice(const int i2cdeviceaddress, const char* i2cbusdevice, I2Cbackend* i2cbackend)
 	{
 #		if defined(DEBUG4)
 		//	function, step, extra
 		printf("\t%s\t%s\t%s\n", "I2Cdevice", "constructor begin", "");
 #		endif
 		//	start with invalid values
+		this->backend = (NULL != i2cbackend ?i2cbackend :I2Cbackend::Linux());
 		this->fdbus = -1;
 		this->devbus = NULL;
 		this->i2caddress = 0x00;
 		this->i2cfuncs = 0;
+		this->i2cprobed = false;
+		this->i2cselected = -1;
+		this->i2csaved = 0;
+		clock_gettime(CLOCK_MONOTONIC, &this->i2csavedsince);
+		this->i2cshared = NULL;
 		//	initialize I2C bus
 		this->I2Copen(i2cbusdevice);
 		//	remember device address
@@ -87,7 +143,17 @@ namespace rpiScope
 		{
 			this->devbus = i2cbusdevice;
 		}
-		this->fdbus = open(this->devbus, O_RDWR);
+		if(NULL != this->i2cshared)
+		{
+			//	file descriptor of bus owner, slave address selected there
+			this->fdbus = this->i2cshared->I2Copen(NULL)->fdbus;
+			this->i2cprobed = false;
+			return(this);
+		}
+		this->fdbus = this->backend->Open(this->devbus);
+		//	new file descriptor, capabilities and slave address unknown
+		this->i2cprobed = false;
+		this->i2cselected = -1;
 		if(0 >= this->fdbus)
 		{
 			perror("I2C bus device open failed");
@@ -105,15 +171,23 @@ namespace rpiScope
 		//	function, step, extra
 		printf("\t%s\t%s\t%s\n", "I2Cclose", "begin", "");
 #		endif
-		if(-1 != this->fdbus)
+		if(-1 != this->fdbus && NULL != this->i2cshared)
+		{
+			//	owner closes shared file descriptor
+			this->fdbus = -1;
+			this->i2cprobed = false;
+		}
+		else if(-1 != this->fdbus)
 		{
-			if(0 > close(this->fdbus))
+			if(0 > this->backend->Close(this->fdbus))
 			{
 				perror("I2C bus device close failed");
 			}
 			else
 			{
 				this->fdbus = -1;
+				this->i2cprobed = false;
+				this->i2cselected = -1;
 			}
 #		if defined(DEBUG4)
 			//	function, step, extra
@@ -138,13 +212,15 @@ namespace rpiScope
 		{
 			this->I2Copen(this->devbus);
 		}
+		//	slave address is selected per file descriptor
+		int& selected = (NULL != this->i2cshared ?this->i2cshared->i2cselected :this->i2cselected);
 		//	check address
 		if (0 == this->i2caddress)
 		{
 			perror("I2C no slave address");
 		}
-		// check I2C functions
-		else if( 0 > ioctl(this->fdbus, I2C_FUNCS, &this->i2cfuncs) )
+		// check I2C functions, once per opened bus
+		else if( !this->i2cprobed && 0 > this->backend->Ioctl(this->fdbus, I2C_FUNCS, &this->i2cfuncs) )
 		{
 			perror("I2C ioctl I2C_FUNCS failed");
 		}
@@ -152,18 +228,33 @@ namespace rpiScope
 		{
 			perror("I2C_FUNC_I2C not supported");
 		}
-		// set to 7-bit addr
-		else if ( I2C_FUNC_10BIT_ADDR == (this->i2cfuncs & I2C_FUNC_10BIT_ADDR) && 0 > ioctl(this->fdbus, I2C_TENBIT, 0) )
+		// set to 7-bit addr, once per opened bus
+		else if ( !this->i2cprobed && I2C_FUNC_10BIT_ADDR == (this->i2cfuncs & I2C_FUNC_10BIT_ADDR) && 0 > this->backend->Ioctl(this->fdbus, I2C_TENBIT, (void*)0) )
 		{
 			perror("I2C ioctl I2C_TENBIT failed");
 		}
-		// set the address
-		else if ( 0 > ioctl(this->fdbus, I2C_SLAVE, this->i2caddress) )
+		// set the address, if not selected already
+		else if ( selected != this->i2caddress && 0 > this->backend->Ioctl(this->fdbus, I2C_SLAVE, (void*)(uintptr_t)this->i2caddress) )
 		{
+			selected = -1;
 			perror("I2C ioctl I2C_SLAVE failed");
 		}
-#		if defined(DEBUG4)
 		else
+		{
+			//	count skipped ioctl calls
+			if(this->i2cprobed)
+			{
+				this->i2csaved += (I2C_FUNC_10BIT_ADDR == (this->i2cfuncs & I2C_FUNC_10BIT_ADDR) ?2 :1);
+			}
+			if(selected == this->i2caddress)
+			{
+				this->i2csaved += 1;
+			}
+			this->i2cprobed = true;
+			selected = this->i2caddress;
+		}
+#		if defined(DEBUG4)
+		if(selected == this->i2caddress)
 		{
 			//	function, step, extra
 			printf("\t%s\t0x%02X\tI2C_FUNCS =0x%08lX\n", "I2Cselect", this->i2caddress, this->i2cfuncs);
@@ -195,7 +286,9 @@ namespace rpiScope
 	I2Cdevice* I2Cdevice::I2Cwrite(char address, const int value)
 	{
 		//	write buffer to device
-		if(-1 == i2c_smbus_write_byte_data(this->fdbus, address, (unsigned char)value))
+		union i2c_smbus_data data;
+		data.byte = (unsigned char)value;
+		if(-1 == this->I2Csmbus(I2C_SMBUS_WRITE, address, I2C_SMBUS_BYTE_DATA, &data))
 		{
 			char message[100];
 			sprintf(message, "i2c_smbus_write_byte_data failed [I2Cwrite %02X=%02X]", address, value);
@@ -215,7 +308,9 @@ namespace rpiScope
 		buffer[0] = address;
 		buffer[1] = *value;
 		//	write buffer to device
-		if(-1 == i2c_smbus_write_byte_data(this->fdbus, buffer[0], buffer[1]))
+		union i2c_smbus_data data;
+		data.byte = buffer[1];
+		if(-1 == this->I2Csmbus(I2C_SMBUS_WRITE, buffer[0], I2C_SMBUS_BYTE_DATA, &data))
 		//if(1 != i2c_smbus_write_byte_data(this->fdbus, address, *value))
 		{
 			char message[100];
@@ -232,14 +327,14 @@ namespace rpiScope
 
 	I2Cdevice* I2Cdevice::I2Cread(char address, unsigned char* value)
 	{
-		int buffer = i2c_smbus_read_byte_data(this->fdbus, address);
-		if(0 > buffer)
+		union i2c_smbus_data data;
+		if(0 > this->I2Csmbus(I2C_SMBUS_READ, address, I2C_SMBUS_BYTE_DATA, &data))
 		{
 			perror("i2c_smbus_read_byte_data (I2Cread) failed");
 		}
 		else
 		{
-			*value = buffer &0xFF;
+			*value = data.byte &0xFF;
 		}
 #		if defined(DEBUG4)
 		//	function, step, extra
@@ -255,14 +350,18 @@ namespace rpiScope
 		while(0 < togo)
 		{
 			int rbytes = 0;
+			union i2c_smbus_data data;
 			//	limit read to 32 Bytes, to comply with SMBus
-			if(0 > (rbytes = i2c_smbus_read_i2c_block_data(this->fdbus, address, (32<togo ?32 :togo), pos)))
+			data.block[0] = (I2C_SMBUS_BLOCK_MAX<togo ?I2C_SMBUS_BLOCK_MAX :togo);
+			if(0 > this->I2Csmbus(I2C_SMBUS_READ, address, I2C_SMBUS_I2C_BLOCK_DATA, &data) || 0 >= (rbytes = data.block[0]))
 			{
 				perror("i2c_smbus_read_i2c_block_data failed");
 				break;
 			}
+			memcpy(pos, &data.block[1], rbytes);
 			pos += rbytes;
 			togo -= rbytes;
+			address += rbytes;	//	continue after last register read
 		}
 #		if defined(DEBUG4)
 		//	function, step, extra
@@ -272,6 +371,64 @@ namespace rpiScope
 		return(this);
 	}
 
+	void I2Cdevice::I2Cshare(I2Cdevice* owner)
+	{
+		if(owner == this->i2cshared || owner == this)
+		{
+			return;
+		}
+		//	close own or release shared file descriptor, reopened with next access
+		this->I2Cclose();
+		this->i2cshared = owner;
+	}
+
+	unsigned long I2Cdevice::I2CioctlsSaved(void) const
+	{
+		return(this->i2csaved);
+	}
+	double I2Cdevice::I2CioctlsSavedRate(void) const
+	{
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		double seconds = (now.tv_sec - this->i2csavedsince.tv_sec) + (now.tv_nsec - this->i2csavedsince.tv_nsec) /1e9;
+		return(0 < seconds ?this->i2csaved / seconds :0.0);
+	}
+
+	bool I2Cdevice::I2Ctransfer(I2Cbatch& batch)
+	{
+		//	check bus is opened
+		if(-1 == this->fdbus)
+		{
+			this->I2Copen(this->devbus);
+		}
+		if(0 == batch.Count())
+		{
+			return(true);
+		}
+		//	all messages in one transaction, repeated start between them
+		if(batch.Count() != this->backend->Ioctl(this->fdbus, I2C_RDWR, batch.Transfer()))
+		{
+			perror("I2C ioctl I2C_RDWR failed");
+			return(false);
+		}
+#		if defined(DEBUG4)
+		//	function, step, extra
+		printf("\t%s\t%d\t%s\n", "I2Ctransfer", batch.Count(), "messages");
+#		endif
+		return(true);
+	}
+
+	int I2Cdevice::I2Csmbus(char read_write, unsigned char command, int size, union i2c_smbus_data* data)
+	{
+		//	same as i2c_smbus_access, but through the backend
+		struct i2c_smbus_ioctl_data args;
+		args.read_write = read_write;
+		args.command = command;
+		args.size = size;
+		args.data = data;
+		return(this->backend->Ioctl(this->fdbus, I2C_SMBUS, &args));
+	}
+
 	bool I2Cdevice::I2Cready(void)
 	{
 #		if defined(DEBUG4)
@@ -281,8 +438,12 @@ namespace rpiScope
 		return (0 < this->fdbus);
 	}
 
-	I2Csensor::I2Csensor(I2Csensortype i2csensor, const int i2cdeviceaddress, const char* i2cbusdevice)
-		: I2Cdevice(i2cdeviceaddress, i2cbusdevice), datarate(0)
+	I2Csensor::I2Csensor(I2Csensortype i2csensor, const int i2cdeviceaddress, const char* i2cbusdevice, I2Cbackend* i2cbackend)
+		: I2Cdevice(i2cdeviceaddress, i2cbusdevice, i2cbackend), sensortype(i2csensor), I2Ccombined(true)
+		, register_bytes(0), register_saved(0), fifo_overruns(0), fifo_samples(0)
+		, drdy_events(0), drdy_timeouts(0)
+		, datarate(0), fifo_rate(0), fifo_enabled(false), fifo_watermark(I2C_FIFO_WATERMARK), fifo_lasttime(0)
+		, drdy_fd(-1), drdy_sysfs(false), drdy_owned(false)
 	{
 #		if defined(DEBUG4)
 		//	function, step, extra
@@ -290,8 +451,14 @@ namespace rpiScope
 #		endif
 		this->i2caddress_gyro = this->i2caddress_acc = this->i2caddress_mag = 0;
 		memset(&this->DataBuffer[0], 0x00, sizeof(this->DataBuffer));
+		this->registers_stale = (1 << I2C_STATIC) | (1 << I2C_CONFIG);
+		this->registers_refreshed = 0;
+		this->calibration = 0;
 		//	prepare pthread
 		this->pthread_stopping = true;
+		this->pthread_config.Priority = THREAD_PRIORITY;
+		this->pthread_config.CPU = THREAD_CPU;
+		this->pthread_config.LockMemory = false;
 		//	prepare and test I2C
 		if(-1 != i2cdeviceaddress)
 		{
@@ -307,6 +474,7 @@ namespace rpiScope
 			if(this->Identify_BNO055())
 			{
 				this->sensortype = I2C_BNO055;
+				this->I2Cinitialize();
 			}
 			else if(this->Identify_LSM9DS1())
 			{
@@ -349,146 +517,269 @@ namespace rpiScope
 		}
 		//	stop and clean threads
 		this->pthread_stopp();
+		this->DRDYdetach();
 	}
 
 	void I2Csensor::I2Cread2buffer(void)
 	{
+		uint64_t start = Metrics_Loop::Now();
 		this->I2Copen();
+		//	configuration only if invalidated or refresh interval passed
+		if(I2Cmicroseconds() - this->registers_refreshed >= (uint64_t)I2C_REGISTER_REFRESH *1000000)
+		{
+			this->registers_stale |= (1 << I2C_CONFIG);
+		}
+		unsigned char classes = this->registers_stale | (1 << I2C_STATUS) | (1 << I2C_DATA);
+		bool configuration = (0 != (classes & (1 << I2C_CONFIG)));
 		if(I2C_LSM9DS1 == this->sensortype)
 		{
-			this->I2Cselect(this->i2caddress_acc);
-			BUFFER_I2CREAD_BLOCK(0,0x04,0x0D);
-			BUFFER_I2CREAD_BLOCK(0,0x0F,0x17);
-			BUFFER_I2CREAD_BLOCK(0,0x18,0x1D);	// gyro, should restart at 0x18 afterwards
-			BUFFER_I2CREAD_BLOCK(0,0x1E,0x24);
-			BUFFER_I2CREAD_BLOCK(0,0x26,0x27);
-			BUFFER_I2CREAD_BLOCK(0,0x28,0x2D);	// acc, should restart at 0x28 afterwards
-			BUFFER_I2CREAD_BLOCK(0,0x2E,0x37);
-			assert(0 != (BUFFER_REGISTER(0,0x10) &0b11100000));	//	000==powerdown
-			assert(0 != (BUFFER_REGISTER(0,0x20) &0b11100000));	//	000==powerdown
-			this->I2Cselect(this->i2caddress_mag);
-			BUFFER_I2CREAD_BLOCK(1,0x05,0x0A);
-			BUFFER_I2CREAD_BLOCK(1,0x0F,0x0F);
-			BUFFER_I2CREAD_BLOCK(1,0x20,0x24);
-			BUFFER_I2CREAD_BLOCK(1,0x27,0x27);
-			BUFFER_I2CREAD_BLOCK(1,0x28,0x2D);	// mag, should restart at 0x28 afterwards
-			BUFFER_I2CREAD_BLOCK(1,0x30,0x33);
-			assert(0 == (BUFFER_REGISTER(1,0x22) &0b00000010));	//	10/11==powerdown
-			//	set full scale
-			float gyro = 1.0;	// dps/LSB
-			if(0b00000000 == (BUFFER_REGISTER(0,0x10) &0b00011000))
-				gyro = 0.00875;//245.0/32768;
-			else if(0b00001000 == (BUFFER_REGISTER(0,0x10) &0b00011000))
-				gyro = 0.01750;//500.0/32768;
-			else if(0b00011000 == (BUFFER_REGISTER(0,0x10) &0b00011000))
-				gyro = 0.07;//2000.0/32768;
-			float acc = 1.0;	// G/LSB
-			if(0b00000000 == (BUFFER_REGISTER(0,0x20) &0b00011000))
-				acc = 0.000061;//2.0/32768;
-			else if(0b00001000 == (BUFFER_REGISTER(0,0x20) &0b00011000))
-				acc = 0.000732;//16.0/32768;
-			else if(0b00010000 == (BUFFER_REGISTER(0,0x20) &0b00011000))
-				acc = 0.000122;//4.0/32768;
-			else if(0b00011000 == (BUFFER_REGISTER(0,0x20) &0b00011000))
-				acc = 0.000244;//8.0/32768;
-			float mag = 1.0;	// gauss/LSB
-			if(0b00000000 == (BUFFER_REGISTER(1,0x21) &0b01100000))
-				mag = 0.00014;//4.0/32768;
-			else if(0b00100000 == (BUFFER_REGISTER(1,0x21) &0b01100000))
-				mag = 0.00029;//8.0/32768;
-			else if(0b01000000 == (BUFFER_REGISTER(1,0x21) &0b01100000))
-				mag = 0.00043;//12.0/32768;
-			else if(0b01100000 == (BUFFER_REGISTER(1,0x21) &0b01100000))
-				mag = 0.00058;//16.0/32768;
-			this->IMUvalue.SetFullScale(gyro, acc, mag);
-			//	sample frequency
-			float ODRG = 0.0;
-			switch(BUFFER_REGISTER(0,0x10) &0b11100000)
-			{
-				//case 0b00000000:	ODRG = 0; break;	//	power down
-				case 0b00100000:	ODRG = 14.9; break;
-				case 0b01000000:	ODRG = 59.5; break;
-				case 0b01100000:	ODRG = 119; break;
-				case 0b10000000:	ODRG = 238; break;
-				case 0b10100000:	ODRG = 476; break;
-				case 0b11000000:	ODRG = 952; break;
-			}
-			float ODRA = 0.0;
-			switch(BUFFER_REGISTER(0,0x20) &0b11100000)
-			{
-				//case 0b00000000:	ODRA = 0; break;	//	power down
-				case 0b00100000:	ODRA = 10; break;
-				case 0b01000000:	ODRA = 50; break;
-				case 0b01100000:	ODRA = 119; break;
-				case 0b10000000:	ODRA = 238; break;
-				case 0b10100000:	ODRA = 476; break;
-				case 0b11000000:	ODRA = 952; break;
-			}
-			float ODRM = 0.0;
-			switch(BUFFER_REGISTER(1,0x20) &0b00011100)
-			{
-				case 0b00000000:	ODRG = 0.625; break;
-				case 0b00000100:	ODRG = 1.25; break;
-				case 0b00001000:	ODRG = 2.5; break;
-				case 0b00001100:	ODRG = 5; break;
-				case 0b00010000:	ODRG = 10; break;
-				case 0b00010100:	ODRG = 20; break;
-				case 0b00011000:	ODRG = 40; break;
-				case 0b00011100:	ODRG = 80; break;
-			}
-			this->datarate = ((ODRG>ODRA ?ODRA=ODRG :ODRG=ODRA)>ODRM ?ODRM=ODRG :ODRG=ODRM);	//	find maximum
-			//if(10 > this->datarate) this->datarate = 10;
+			this->I2Creadmap(&I2Cregistermap_LSM9DS1[0], sizeof(I2Cregistermap_LSM9DS1) /sizeof(I2Cregistermap_LSM9DS1[0]), classes);
+			if(configuration)
+			{
+				//	full scale and data rate only change with configuration
+				assert(0 != (BUFFER_REGISTER(0,0x10) &0b11100000));	//	000==powerdown
+				assert(0 != (BUFFER_REGISTER(0,0x20) &0b11100000));	//	000==powerdown
+				assert(0 == (BUFFER_REGISTER(1,0x22) &0b00000010));	//	10/11==powerdown
+				//	set full scale
+				float gyro = 1.0;	// dps/LSB
+				if(0b00000000 == (BUFFER_REGISTER(0,0x10) &0b00011000))
+					gyro = 0.00875;//245.0/32768;
+				else if(0b00001000 == (BUFFER_REGISTER(0,0x10) &0b00011000))
+					gyro = 0.01750;//500.0/32768;
+				else if(0b00011000 == (BUFFER_REGISTER(0,0x10) &0b00011000))
+					gyro = 0.07;//2000.0/32768;
+				float acc = 1.0;	// G/LSB
+				if(0b00000000 == (BUFFER_REGISTER(0,0x20) &0b00011000))
+					acc = 0.000061;//2.0/32768;
+				else if(0b00001000 == (BUFFER_REGISTER(0,0x20) &0b00011000))
+					acc = 0.000732;//16.0/32768;
+				else if(0b00010000 == (BUFFER_REGISTER(0,0x20) &0b00011000))
+					acc = 0.000122;//4.0/32768;
+				else if(0b00011000 == (BUFFER_REGISTER(0,0x20) &0b00011000))
+					acc = 0.000244;//8.0/32768;
+				float mag = 1.0;	// gauss/LSB
+				if(0b00000000 == (BUFFER_REGISTER(1,0x21) &0b01100000))
+					mag = 0.00014;//4.0/32768;
+				else if(0b00100000 == (BUFFER_REGISTER(1,0x21) &0b01100000))
+					mag = 0.00029;//8.0/32768;
+				else if(0b01000000 == (BUFFER_REGISTER(1,0x21) &0b01100000))
+					mag = 0.00043;//12.0/32768;
+				else if(0b01100000 == (BUFFER_REGISTER(1,0x21) &0b01100000))
+					mag = 0.00058;//16.0/32768;
+				this->IMUvalue.SetFullScale(gyro, acc, mag);
+				//	sample frequency
+				float ODRG = 0.0;
+				switch(BUFFER_REGISTER(0,0x10) &0b11100000)
+				{
+					//case 0b00000000:	ODRG = 0; break;	//	power down
+					case 0b00100000:	ODRG = 14.9; break;
+					case 0b01000000:	ODRG = 59.5; break;
+					case 0b01100000:	ODRG = 119; break;
+					case 0b10000000:	ODRG = 238; break;
+					case 0b10100000:	ODRG = 476; break;
+					case 0b11000000:	ODRG = 952; break;
+				}
+				float ODRA = 0.0;
+				switch(BUFFER_REGISTER(0,0x20) &0b11100000)
+				{
+					//case 0b00000000:	ODRA = 0; break;	//	power down
+					case 0b00100000:	ODRA = 10; break;
+					case 0b01000000:	ODRA = 50; break;
+					case 0b01100000:	ODRA = 119; break;
+					case 0b10000000:	ODRA = 238; break;
+					case 0b10100000:	ODRA = 476; break;
+					case 0b11000000:	ODRA = 952; break;
+				}
+				float ODRM = 0.0;
+				switch(BUFFER_REGISTER(1,0x20) &0b00011100)
+				{
+					case 0b00000000:	ODRM = 0.625; break;
+					case 0b00000100:	ODRM = 1.25; break;
+					case 0b00001000:	ODRM = 2.5; break;
+					case 0b00001100:	ODRM = 5; break;
+					case 0b00010000:	ODRM = 10; break;
+					case 0b00010100:	ODRM = 20; break;
+					case 0b00011000:	ODRM = 40; break;
+					case 0b00011100:	ODRM = 80; break;
+				}
+				this->fifo_rate = (0 < ODRG ?ODRG :ODRA);	//	FIFO is filled with gyroscope data rate, if active
+				this->datarate = ((ODRG>ODRA ?ODRA=ODRG :ODRG=ODRA)>ODRM ?ODRM=ODRG :ODRG=ODRM);	//	find maximum
+				//if(10 > this->datarate) this->datarate = 10;
+			}
 		}
 		else if(I2C_BNO055 == this->sensortype)
 		{
-			unsigned char pagebuffer[I2C_BUFFER_PAGESIZE];
-			memset(&pagebuffer[0], 0x00, sizeof(pagebuffer));
-			this->I2Cselect(this->i2caddress_acc);
-			this->I2Cread(0x00, &pagebuffer[0], 0x7F-0x00 +1);
-			memcpy(&(this->DataBuffer[(pagebuffer[0x07] *I2C_BUFFER_PAGESIZE)]), &pagebuffer[0], 0x7F-0x00 +1);
-			pagebuffer[0x07] ^= 0x01;
-			this->I2Cwrite(0x07, &pagebuffer[0x07]);
-			this->I2Cread(0x00, &(this->DataBuffer[(pagebuffer[0x07] *I2C_BUFFER_PAGESIZE)]), 0x7F-0x00 +1);
+			this->I2Creadmap(&I2Cregistermap_BNO055[0], sizeof(I2Cregistermap_BNO055) /sizeof(I2Cregistermap_BNO055[0]), classes);
 		}
 		else
 		{
 			perror("I2Cread2buffer needs a known sensor type");
 		}
-#		if defined(USE_MADGWICK_AHRS)
-		Madgwick::sampleFreq = this->datarate;
-#		endif
+		this->IMUvalue.SetSampleRate(this->datarate);
+		this->DataPublish();
+		uint64_t read = Metrics_Loop::Now();
+		this->metrics.ReadDuration.Record(read - start);
+		this->metrics.Reads.Add();
 		this->IMUvalueUpdate();
+		this->metrics.FusionTime.Record(Metrics_Loop::Now() - read);
 #		if defined(DEBUG4)
 		//	function, step, extra
 		printf("\t%s\t%s\t%s\n", "I2Cread2buffer", "done", "");
 #		endif
 	}
 
-	void I2Csensor::I2Creadimu(void)
+	int I2Csensor::I2Creadmap(const I2Cregisterrange* map, int ranges, unsigned char classes)
 	{
-		this->I2Copen();
-		if(I2C_LSM9DS1 == this->sensortype)
+		int bytes = 0;
+		int full = 0;
+		int page = -1;
+		if(I2C_BNO055 == this->sensortype)
 		{
+			//	BNO055 is kept on page 0, page 1 costs two PAGE_ID writes
 			this->I2Cselect(this->i2caddress_acc);
-			BUFFER_I2CREAD_BLOCK(0,0x18,0x1D);	// should restart at 0x18 afterwards
-			BUFFER_I2CREAD_BLOCK(0,0x28,0x2D);	// should restart at 0x28 afterwards
-			this->I2Cselect(this->i2caddress_mag);
-			BUFFER_I2CREAD_BLOCK(1,0x28,0x2D);	// should restart at 0x28 afterwards
+			page = 0;
+			full += 2;
 		}
-		else if(I2C_BNO055 == this->sensortype)
+		for(int range=0; ranges>range; ++range)
+		{
+			full += map[range].last - map[range].first +1;
+			if(0 == (classes & (1 << map[range].volatility)))
+			{
+				continue;
+			}
+			//	extend over adjacent ranges due for reading
+			int last = range;
+			while(ranges > last +1 && map[last +1].page == map[range].page && map[last +1].first == map[last].last +1 && 0 != (classes & (1 << map[last +1].volatility)))
+			{
+				++last;
+				full += map[last].last - map[last].first +1;
+			}
+			if(page != map[range].page)
+			{
+				page = map[range].page;
+				if(I2C_BNO055 == this->sensortype)
+				{
+					unsigned char pageid = page;
+					this->I2Cwrite(0x07, &pageid);
+					++bytes;
+				}
+				else
+				{
+					this->I2Cselect(0 == page ?this->i2caddress_acc :this->i2caddress_mag);
+				}
+			}
+			BUFFER_I2CREAD_BLOCK(page, map[range].first, map[last].last);
+			bytes += map[last].last - map[range].first +1;
+			range = last;
+		}
+		if(I2C_BNO055 == this->sensortype && 0 != page)
 		{
-			this->I2Cread2buffer();
+			unsigned char pageid = 0;
+			this->I2Cwrite(0x07, &pageid);
+			++bytes;
 		}
-		else
+		if(0 != (classes & (1 << I2C_CONFIG)))
 		{
-			this->I2Cread2buffer();
+			this->registers_refreshed = I2Cmicroseconds();
 		}
-		this->IMUvalueUpdate();
+		this->registers_stale &= ~classes;
+		this->register_bytes += bytes;
+		this->register_saved += full - bytes;
+#		if defined(DEBUG4)
+		//	function, step, extra
+		printf("\t%s\t%d\t%s\n", "I2Creadmap", bytes, "bytes");
+#		endif
+		return(bytes);
+	}
+	void I2Csensor::I2Cinvalidate(I2Cvolatility volatility)
+	{
+		this->registers_stale |= (1 << volatility);
+	}
+
+	void I2Csensor::I2Creadimu(void)
+	{
+		uint64_t start = Metrics_Loop::Now();
+		this->I2Copen();
+		I2Cbatch batch;
+		bool combined = false;
+		if(this->I2Ccombined && 0 != (this->i2cfuncs & I2C_FUNC_I2C) && this->I2Cprepare(batch))
+		{
+			combined = this->I2Ctransfer(batch);
+			if(!combined)
+			{
+				//	adapter rejects combined transaction, SMBus reading from now on (starting with this one)
+				this->I2Ccombined = false;
+				this->metrics.Failures.Add();
+			}
+		}
+		if(!combined)
+		{
+			if(I2C_LSM9DS1 == this->sensortype)
+			{
+				this->I2Cselect(this->i2caddress_acc);
+				BUFFER_I2CREAD_BLOCK(0,0x18,0x1D);	// should restart at 0x18 afterwards
+				BUFFER_I2CREAD_BLOCK(0,0x28,0x2D);	// should restart at 0x28 afterwards
+				this->I2Cselect(this->i2caddress_mag);
+				BUFFER_I2CREAD_BLOCK(1,0x28,0x2D);	// should restart at 0x28 afterwards
+			}
+			else if(I2C_BNO055 == this->sensortype)
+			{
+				this->I2Cselect(this->i2caddress_acc);
+				BUFFER_I2CREAD_BLOCK(0,0x20,0x35);
+			}
+			else
+			{
+				perror("I2Creadimu needs a known sensor type");
+				this->metrics.Failures.Add();
+				return;
+			}
+		}
+		this->I2Ccomplete(start);
 #		if defined(DEBUG4)
 		//	function, step, extra
 		printf("\t%s\t%s\t%s\n", "I2Creadimu", "done", "");
 #		endif
 	}
+	bool I2Csensor::I2Cprepare(I2Cbatch& batch)
+	{
+		if(I2C_LSM9DS1 == this->sensortype && 6 <= batch.Space())
+		{
+			//	gyro, acc and mag with one ioctl, instead of 3 I2C_SLAVE and 3 I2C_SMBUS calls
+			batch.Read(this->i2caddress_gyro, 0x18, &BUFFER_REGISTER(0,0x18), 0x1D-0x18 +1);
+			batch.Read(this->i2caddress_acc, 0x28, &BUFFER_REGISTER(0,0x28), 0x2D-0x28 +1);
+			batch.Read(this->i2caddress_mag, BUFFER_SUBADDRESS(1,0x28), &BUFFER_REGISTER(1,0x28), 0x2D-0x28 +1);	//	MSB of sub address enables auto increment
+			return(true);
+		}
+		else if(I2C_BNO055 == this->sensortype && 2 <= batch.Space())
+		{
+			//	NDOF fusion output, quaternion, linear acceleration, gravity, temperature and calibration status in one burst
+			batch.Read(this->i2caddress_acc, 0x20, &BUFFER_REGISTER(0,0x20), 0x35-0x20 +1);
+			return(true);
+		}
+		return(false);
+	}
+	void I2Csensor::I2Ccomplete(uint64_t start)
+	{
+		uint64_t read = Metrics_Loop::Now();
+		this->DataPublish();
+		this->metrics.ReadDuration.Record(read - start);
+		this->metrics.Reads.Add();
+		this->IMUvalueUpdate();
+		this->metrics.FusionTime.Record(Metrics_Loop::Now() - read);
+	}
+
+	void I2Csensor::DataPublish(void)
+	{
+		this->DataPublished.Write(*(const I2Cregisters*)&this->DataBuffer[0]);
+	}
+	void I2Csensor::DataSnapshot(I2Cregisters& registers) const
+	{
+		this->DataPublished.Read(registers);
+	}
+	unsigned long I2Csensor::DataVersion(void) const
+	{
+		return(this->DataPublished.Version());
+	}
 
 	void I2Csensor::IMUvalueUpdate(void)
 	{
@@ -497,6 +788,10 @@ namespace rpiScope
 		int16_t Z = 0;
 		if(I2C_LSM9DS1 == this->sensortype)
 		{
+			IMU_LogRecord record;
+			memset(&record, 0x00, sizeof(record));
+			record.Timestamp = I2Cmicroseconds();
+			this->IMUvalue.SetSampleTime(record.Timestamp);
 			if(0 == (BUFFER_REGISTER(0,0x22) &0b00000010))	// BLE selection
 			{
 				X = (this->DataBuffer[((0*I2C_BUFFER_PAGESIZE) +0x19)] <<8) | (this->DataBuffer[((0*I2C_BUFFER_PAGESIZE) +0x18)]);
@@ -510,6 +805,9 @@ namespace rpiScope
 				Z = (this->DataBuffer[((0*I2C_BUFFER_PAGESIZE) +0x1C)] <<8) | (this->DataBuffer[((0*I2C_BUFFER_PAGESIZE) +0x1D)]);
 			}
 			this->IMUvalue.PushGyroscope(X,Y,Z);
+			record.Gyroscope.X = X;
+			record.Gyroscope.Y = Y;
+			record.Gyroscope.Z = Z;
 			if(0 == (BUFFER_REGISTER(0,0x22) &0b00000010))	// BLE selection
 			{
 				X = (this->DataBuffer[((0*I2C_BUFFER_PAGESIZE) +0x29)] <<8) | (this->DataBuffer[((0*I2C_BUFFER_PAGESIZE) +0x28)]);
@@ -523,6 +821,9 @@ namespace rpiScope
 				Z = (this->DataBuffer[((0*I2C_BUFFER_PAGESIZE) +0x2C)] <<8) | (this->DataBuffer[((0*I2C_BUFFER_PAGESIZE) +0x2D)]);
 			}
 			this->IMUvalue.PushAcceleration(X,Y,Z);
+			record.Acceleration.X = X;
+			record.Acceleration.Y = Y;
+			record.Acceleration.Z = Z;
 			if(0 == (BUFFER_REGISTER(1,0x23) &0b00000010))	// BLE selection
 			{
 				X = (this->DataBuffer[((1*I2C_BUFFER_PAGESIZE) +0x29)] <<8) | (this->DataBuffer[((1*I2C_BUFFER_PAGESIZE) +0x28)]);
@@ -536,16 +837,344 @@ namespace rpiScope
 				Z = (this->DataBuffer[((1*I2C_BUFFER_PAGESIZE) +0x2C)] <<8) | (this->DataBuffer[((1*I2C_BUFFER_PAGESIZE) +0x2D)]);
 			}
 			this->IMUvalue.PushMagnetometer(X,Y,Z);
+			record.Magnetometer.X = X;
+			record.Magnetometer.Y = Y;
+			record.Magnetometer.Z = Z;
+			this->IMUvalue.MadgwickAHRSupdate();
+			this->recorder.Append(record);
 		}
 		else if(I2C_BNO055 == this->sensortype)
 		{
-			this->I2Cread2buffer();
+			//	NDOF fusion output, no host fusion
+			this->IMUvalue.SetSampleTime(I2Cmicroseconds());
+			this->IMUvalue.PushAcceleration(I2Cvalue(&BUFFER_REGISTER(0,0x2E), false), I2Cvalue(&BUFFER_REGISTER(0,0x30), false), I2Cvalue(&BUFFER_REGISTER(0,0x32), false));	//	gravity vector
+			this->IMUvalue.PushLinearAcceleration(I2Cvalue(&BUFFER_REGISTER(0,0x28), false), I2Cvalue(&BUFFER_REGISTER(0,0x2A), false), I2Cvalue(&BUFFER_REGISTER(0,0x2C), false));
+			this->IMUvalue.PushQuaternion(I2Cvalue(&BUFFER_REGISTER(0,0x20), false) /16384.0, I2Cvalue(&BUFFER_REGISTER(0,0x22), false) /16384.0
+				, I2Cvalue(&BUFFER_REGISTER(0,0x24), false) /16384.0, I2Cvalue(&BUFFER_REGISTER(0,0x26), false) /16384.0);	//	1 quaternion unit = 2^14 LSB
+			this->calibration = BUFFER_REGISTER(0,0x35);
 		}
-		else
+	}
+
+	bool I2Csensor::FIFOstart(int watermark)
+	{
+		if(I2C_LSM9DS1 != this->sensortype)
+		{
+			perror("FIFOstart needs LSM9DS1 sensor");
+			return(false);
+		}
+		//	read configuration, full scale and data rate
+		this->I2Cread2buffer();
+		//	threshold level 1..31
+		this->fifo_watermark = (1 > watermark ?1 :(I2C_FIFO_DEPTH-1 < watermark ?I2C_FIFO_DEPTH-1 :watermark));
+		this->fifo_lasttime = 0;
+		unsigned char valNow = 0;
+		this->I2Cselect(this->i2caddress_acc);
+		this->I2Cread(0x23, &valNow);
+		this->I2Cwrite(0x23, valNow | 0b00000010);	//	FIFO_EN
+		this->I2Cwrite(0x2E, 0b11000000 | (this->fifo_watermark &0b00011111));	//	FIFO continuous mode, threshold level
+		this->fifo_enabled = true;
+		this->I2Cinvalidate(I2C_CONFIG);
+		if(this->DRDYattached())
+		{
+			this->DRDYenable(true);
+		}
+#		if defined(DEBUG4)
+		//	function, step, extra
+		printf("\t%s\t%d\t%s\n", "FIFOstart", this->fifo_watermark, "watermark");
+#		endif
+		return(true);
+	}
+	void I2Csensor::FIFOstop(void)
+	{
+		if(!this->fifo_enabled)
+		{
+			return;
+		}
+		unsigned char valNow = 0;
+		this->I2Cselect(this->i2caddress_acc);
+		this->I2Cwrite(0x2E, 0b00000000);	//	FIFO bypass mode
+		this->I2Cread(0x23, &valNow);
+		this->I2Cwrite(0x23, valNow & ~0b00000010);	//	FIFO disabled
+		this->fifo_enabled = false;
+		this->I2Cinvalidate(I2C_CONFIG);
+		if(this->DRDYattached())
+		{
+			this->DRDYenable(true);
+		}
+	}
+	bool I2Csensor::FIFOenabled(void) const
+	{
+		return(this->fifo_enabled);
+	}
+
+	int I2Csensor::FIFOdrain(I2Cfifosample* samples)
+	{
+		if(!this->fifo_enabled)
+		{
+			return(-1);
+		}
+		uint64_t start = Metrics_Loop::Now();
+		//	FIFO_SRC, number of unread samples
+		I2Cbatch batch;
+		unsigned char fifosrc = 0;
+		batch.Read(this->i2caddress_acc, 0x2F, &fifosrc, 1);
+		if(!this->I2Ctransfer(batch))
+		{
+			this->metrics.Failures.Add();
+			return(-1);
+		}
+		uint64_t now = I2Cmicroseconds();
+		if(0 != (fifosrc & 0b01000000))
+		{
+			++this->fifo_overruns;
+			this->metrics.Missed.Add();
+		}
+		int count = (fifosrc & 0b00111111);
+		if(I2C_FIFO_DEPTH < count)
+		{
+			count = I2C_FIFO_DEPTH;
+		}
+		//	burst read all samples, each FIFO slot is gyro (0x18-0x1D) and acc (0x28-0x2D)
+		//	a transaction takes 10 samples, magnetometer is added to the last one
+		//	gyro and acc triples are collected separately, for batch conversion with IMU_Data::Convert
+		unsigned char buffer[2][I2C_FIFO_DEPTH*6];
+		int pos = 0;
+		bool magnetometer = false;
+		while(!magnetometer)
+		{
+			batch.Clear();
+			while(count > pos && 4 <= batch.Space())
+			{
+				batch.Read(this->i2caddress_gyro, 0x18, &buffer[0][pos*6], 6);
+				batch.Read(this->i2caddress_acc, 0x28, &buffer[1][pos*6], 6);
+				++pos;
+			}
+			if(count <= pos && 2 <= batch.Space())
+			{
+				batch.Read(this->i2caddress_mag, BUFFER_SUBADDRESS(1,0x28), &BUFFER_REGISTER(1,0x28), 0x2D-0x28 +1);	//	MSB of sub address enables auto increment
+				magnetometer = true;
+			}
+			if(!this->I2Ctransfer(batch))
+			{
+				this->metrics.Failures.Add();
+				return(-1);
+			}
+		}
+		//	newest slot as output registers
+		if(0 < count)
+		{
+			memcpy(&BUFFER_REGISTER(0,0x18), &buffer[0][(count -1)*6], 6);
+			memcpy(&BUFFER_REGISTER(0,0x28), &buffer[1][(count -1)*6], 6);
+		}
+		this->DataPublish();
+		uint64_t read = Metrics_Loop::Now();
+		this->metrics.ReadDuration.Record(read - start);
+		this->metrics.QueueDepth.Record(count);
+		this->metrics.Reads.Add();
+		//	reconstruct time stamps, newest sample is now and samples are spaced by FIFO data rate
+		double period = 1000000.0 / (0 < this->fifo_rate ?this->fifo_rate :1);
+		double first = now - (count -1) *period;
+		if(0 != this->fifo_lasttime && first < this->fifo_lasttime + period /2 && 0 < count)
+		{
+			//	keep time stamps strictly increasing, when reading is faster than FIFO filling (or ODR above nominal)
+			//	spread samples over (last,now], so newest sample never passes now (1us apart at least)
+			period = (now > this->fifo_lasttime + count ?(double)(now - this->fifo_lasttime) / count :1.0);
+			first = this->fifo_lasttime + period;
+		}
+		bool bigendian = (0 != (BUFFER_REGISTER(0,0x22) &0b00000010));	// BLE selection
+		IMU_LogRecord record;
+		memset(&record, 0x00, sizeof(record));
+		record.Magnetometer.X = I2Cvalue(&BUFFER_REGISTER(1,0x28), 0 != (BUFFER_REGISTER(1,0x23) &0b00000010));
+		record.Magnetometer.Y = I2Cvalue(&BUFFER_REGISTER(1,0x2A), 0 != (BUFFER_REGISTER(1,0x23) &0b00000010));
+		record.Magnetometer.Z = I2Cvalue(&BUFFER_REGISTER(1,0x2C), 0 != (BUFFER_REGISTER(1,0x23) &0b00000010));
+		this->IMUvalue.PushMagnetometer(record.Magnetometer.X, record.Magnetometer.Y, record.Magnetometer.Z);
+		//	magnetometer is read once per drain, first slot carries it
+		record.Flags = IMU_LOG_FIFO | (0 != (fifosrc & 0b01000000) ?IMU_LOG_OVERRUN :0);
+		//	scale all slots at once (dps and g), every slot is fused with its own values
+		float gyro[3][I2C_FIFO_DEPTH];
+		float acc[3][I2C_FIFO_DEPTH];
+		this->IMUvalue.ConvertGyroscope(&buffer[0][0], count, bigendian, &gyro[0][0], &gyro[1][0], &gyro[2][0]);
+		this->IMUvalue.ConvertAcceleration(&buffer[1][0], count, bigendian, &acc[0][0], &acc[1][0], &acc[2][0]);
+		for(pos=0; count>pos; ++pos)
+		{
+			I2Cfifosample sample;
+			sample.timestamp = (uint64_t)(first + pos *period + 0.5);
+			for(int axis=0; 3>axis; ++axis)
+			{
+				sample.gyro[axis] = I2Cvalue(&buffer[0][pos*6 +axis*2], bigendian);
+				sample.acc[axis] = I2Cvalue(&buffer[1][pos*6 +axis*2], bigendian);
+				sample.gyroscaled[axis] = gyro[axis][pos];
+				sample.accscaled[axis] = acc[axis][pos];
+			}
+			this->IMUvalue.SetSampleTime(sample.timestamp);
+			this->IMUvalue.PushGyroscope(sample.gyro[0], sample.gyro[1], sample.gyro[2]);
+			this->IMUvalue.PushAcceleration(sample.acc[0], sample.acc[1], sample.acc[2]);
+			this->IMUvalue.MadgwickAHRSupdate(gyro[0][pos], gyro[1][pos], gyro[2][pos], acc[0][pos], acc[1][pos], acc[2][pos]);
+			if(NULL != samples)
+			{
+				samples[pos] = sample;
+			}
+			if(this->recorder.Opened())
+			{
+				record.Timestamp = sample.timestamp;
+				record.Gyroscope.X = sample.gyro[0];
+				record.Gyroscope.Y = sample.gyro[1];
+				record.Gyroscope.Z = sample.gyro[2];
+				record.Acceleration.X = sample.acc[0];
+				record.Acceleration.Y = sample.acc[1];
+				record.Acceleration.Z = sample.acc[2];
+				this->recorder.Append(record);
+				record.Flags = IMU_LOG_FIFO | IMU_LOG_MAGNETOMETER_HELD;
+			}
+			this->fifo_lasttime = sample.timestamp;
+		}
+		this->fifo_samples += count;
+		this->metrics.FusionTime.Record(Metrics_Loop::Now() - read);
+#		if defined(DEBUG4)
+		//	function, step, extra
+		printf("\t%s\t%d\t%s\n", "FIFOdrain", count, "samples");
+#		endif
+		return(count);
+	}
+
+	bool I2Csensor::IMUrecordStart(const char* logfile)
+	{
+		if(I2C_LSM9DS1 != this->sensortype)
+		{
+			return(false);
+		}
+		IMU_LogHeader header;
+		memset(&header, 0x00, sizeof(header));
+		header.SampleRate = (this->fifo_enabled ?this->fifo_rate :this->datarate);
+		this->IMUvalue.GetFullScale(header.FullScaleGyroscope, header.FullScaleAcceleration, header.FullScaleMagnetometer);
+		return(this->recorder.Open(logfile, header));
+	}
+	void I2Csensor::IMUrecordStop(void)
+	{
+		this->recorder.Close();
+	}
+	size_t I2Csensor::IMUrecorded(void) const
+	{
+		return(this->recorder.Records());
+	}
+
+	bool I2Csensor::DRDYattach(const char* gpiovalue)
+	{
+		this->DRDYdetach();
+		//	set edge of sysfs gpio, value file and edge file are in the same directory
+		char edge[256];
+		const char* slash = strrchr(gpiovalue, '/');
+		if(NULL != slash && sizeof(edge) > (size_t)(slash - gpiovalue) + sizeof("/edge"))
+		{
+			snprintf(edge, sizeof(edge), "%.*s/edge", (int)(slash - gpiovalue), gpiovalue);
+			int fdedge = open(edge, O_WRONLY);
+			if(0 <= fdedge)
+			{
+				if(0 > write(fdedge, "rising", 6))
+				{
+					perror("DRDYattach setting gpio edge failed");
+				}
+				close(fdedge);
+			}
+		}
+		int fd = open(gpiovalue, O_RDONLY | O_NONBLOCK);
+		if(0 > fd)
+		{
+			perror("DRDYattach opening gpio value failed");
+			return(false);
+		}
+		//	read current value, so poll waits for the next edge
+		char value[8];
+		if(0 > read(fd, value, sizeof(value)))
+		{
+			perror("DRDYattach reading gpio value failed");
+		}
+		this->drdy_fd = fd;
+		this->drdy_sysfs = true;
+		this->drdy_owned = true;
+		this->DRDYenable(true);
+		return(true);
+	}
+	bool I2Csensor::DRDYattach(int eventfd)
+	{
+		this->DRDYdetach();
+		if(0 > eventfd)
+		{
+			return(false);
+		}
+		this->drdy_fd = eventfd;
+		this->drdy_sysfs = false;
+		this->drdy_owned = false;
+		this->DRDYenable(true);
+		return(true);
+	}
+	void I2Csensor::DRDYdetach(void)
+	{
+		if(0 > this->drdy_fd)
+		{
+			return;
+		}
+		this->DRDYenable(false);
+		if(this->drdy_owned)
+		{
+			close(this->drdy_fd);
+		}
+		this->drdy_fd = -1;
+		this->drdy_owned = false;
+	}
+	bool I2Csensor::DRDYattached(void) const
+	{
+		return(0 <= this->drdy_fd);
+	}
+	void I2Csensor::DRDYenable(bool enable)
+	{
+		if(I2C_LSM9DS1 != this->sensortype)
+		{
+			return;
+		}
+		//	INT1_CTRL, threshold interrupt in FIFO mode, gyroscope data ready otherwise
+		this->I2Cselect(this->i2caddress_acc);
+		this->I2Cwrite(0x0C, (!enable ?0b00000000 :(this->fifo_enabled ?0b00001000 :0b00000010)));
+		this->I2Cinvalidate(I2C_CONFIG);
+	}
+
+	int I2Csensor::DRDYwait(int timeout)
+	{
+		if(0 > this->drdy_fd)
+		{
+			return(-1);
+		}
+		struct pollfd event;
+		event.fd = this->drdy_fd;
+		event.events = (this->drdy_sysfs ?(POLLPRI | POLLERR) :POLLIN);
+		event.revents = 0;
+		int rc = poll(&event, 1, timeout);
+		if(0 > rc)
+		{
+			if(EINTR != errno)
+			{
+				perror("DRDYwait poll failed");
+			}
+			return(-1);
+		}
+		else if(0 == rc)
+		{
+			++this->drdy_timeouts;
+			return(0);
+		}
+		//	consume event, one reading for all pending interrupts
+		char buffer[64];
+		if(this->drdy_sysfs)
+		{
+			lseek(this->drdy_fd, 0, SEEK_SET);
+		}
+		if(0 > read(this->drdy_fd, buffer, sizeof(buffer)) && EAGAIN != errno)
 		{
-			this->I2Cread2buffer();
+			perror("DRDYwait reading event failed");
+			return(-1);
 		}
-		this->IMUvalue.MadgwickAHRSupdate();
+		++this->drdy_events;
+		return(1);
 	}
 
 	void I2Csensor::I2Cinitialize(void)
@@ -615,11 +1244,26 @@ namespace rpiScope
 		}
 		else if(I2C_BNO055 == this->sensortype)
 		{
+			//	NDOF mode, sensor fusion on chip, configuration only in CONFIGMODE
+			this->I2Cselect(this->i2caddress_acc);
+			this->I2Cwrite(0x07, 0x00);	//	PAGE_ID 0
+			this->I2Cwrite(0x3D, 0x00);	//	OPR_MODE CONFIGMODE
+			usleep(25000);	//	19ms switching from any operation mode
+			this->I2Cwrite(0x3E, 0x00);	//	PWR_MODE normal
+			this->I2Cwrite(0x3B, 0x00);	//	UNIT_SEL m/s^2, dps, degrees, Celsius, windows orientation
+			this->I2Cwrite(0x3D, 0x0C);	//	OPR_MODE NDOF
+			usleep(10000);	//	7ms switching from CONFIGMODE
+			this->datarate = 100;	//	fusion output data rate
+			//	gyro 16LSB/dps, acc 100LSB/(m/s^2), mag 16LSB/uT
+			this->IMUvalue.SetFullScale(1.0/16, 1.0/(100*9.80665), 0.01/16);
 		}
 		else
 		{
 			perror("I2Cinitialize needs a known sensor type");
 		}
+		//	sensor rebooted and configured
+		this->I2Cinvalidate(I2C_STATIC);
+		this->I2Cinvalidate(I2C_CONFIG);
 #		if defined(DEBUG4)
 		//	function, step, extra
 		printf("\t%s\t%s\t%s\n", "I2Cread2buffer", "done", "");
@@ -829,14 +1473,14 @@ namespace rpiScope
 #		endif
 		//	clear stop flag
 		this->pthread_stopping = false;
-		//	prepare thread attributes
-		pthread_attr_init(&this->pthread_attributes);
-		pthread_attr_setdetachstate(&this->pthread_attributes, PTHREAD_CREATE_JOINABLE);
-		//	start thread
-		int rc = pthread_create(&this->pthread_read, &this->pthread_attributes, pthread_DataReading, (void *)this);
-		if(0 > rc)
+		//	start thread, with scheduling and affinity in attributes
+		int rc = Thread_Create(&this->pthread_read, &this->pthread_attributes, this->pthread_config, pthread_DataReading, (void *)this);
+		if(0 != rc)
 		{
+			errno = rc;
 			perror("pthread_create failed (pthread_DataReading)");
+			pthread_attr_destroy(&this->pthread_attributes);
+			this->pthread_stopping = true;
 		}
 		else
 		{
@@ -849,6 +1493,11 @@ namespace rpiScope
 		//	function, step, extra
 		printf("\t%s\t%s\t%s\n", "pthread_stopp", "starting", "");
 #		endif
+		//	check thread was started
+		if(this->pthread_stopping)
+		{
+			return;
+		}
 		//	set stopp flags
 		this->pthread_stopping = true;
 		//	destroy attribute
@@ -856,6 +1505,14 @@ namespace rpiScope
 		//	wait for thread completion
 		pthread_join(this->pthread_read, NULL);
 	}
+	void I2Csensor::pthread_configure(const Thread_Config& config)
+	{
+		this->pthread_config = config;
+	}
+	void I2Csensor::pthread_jitter(Thread_Jitter& jitter) const
+	{
+		this->pthread_pacer.Snapshot(jitter);
+	}
 
 	void *pthread_DataReading(void *data)
 	{
@@ -868,8 +1525,12 @@ namespace rpiScope
 		//	start preparation
 		int read_counter = 0;
 		int readrate = 32;
+		//	absolute deadlines, no drift from reading time
+		mother->pthread_pacer.SetPeriod(1000000000 / readrate);
+		mother->pthread_pacer.Start();
 		while(!mother->pthread_stopping)
 		{
+			mother->metrics.Loop(Metrics_Loop::Now());
 			if(rpiScope::I2C_NoSensor == mother->sensortype)
 			{
 				read_counter = 0;
@@ -877,6 +1538,38 @@ namespace rpiScope
 				//mother->I2Cinitialize();
 				continue;
 			}
+			//	data ready interrupt, read once per new sample (or FIFO threshold)
+			if(mother->DRDYattached())
+			{
+				if(0 > mother->DRDYwait())
+				{
+					usleep(1000);
+					continue;
+				}
+				if(mother->FIFOenabled())
+				{
+					mother->FIFOdrain();
+				}
+				else if(0 == (read_counter++ %readrate))
+				{
+					mother->I2Cread2buffer();
+					readrate = round(10<mother->datarate ?mother->datarate :10);
+				}
+				else
+				{
+					mother->I2Creadimu();
+				}
+				continue;
+			}
+			//	FIFO continuous mode, wake up when threshold level is reached
+			if(mother->FIFOenabled())
+			{
+				mother->FIFOdrain();
+				mother->pthread_pacer.SetPeriod((uint64_t)(1000000000.0 * mother->fifo_watermark / (10<mother->fifo_rate ?mother->fifo_rate :10)));
+				if(!mother->pthread_pacer.Wait())
+					mother->metrics.Missed.Add();
+				continue;
+			}
 			//	count reading (1Hz interval for complete buffer)
 			if(0 == (read_counter++ %readrate))
 			{
@@ -890,7 +1583,9 @@ namespace rpiScope
 			{
 				mother->I2Creadimu();
 			}
-			usleep(1000000 / readrate);	//	10Hz reading minimum
+			mother->pthread_pacer.SetPeriod(1000000000 / readrate);	//	10Hz reading minimum
+			if(!mother->pthread_pacer.Wait())
+				mother->metrics.Missed.Add();
 		}
 #		if defined(DEBUG4)
 		//	function, step, extra
@@ -901,15 +1596,18 @@ namespace rpiScope
 
 	void I2Csensor::DebugDataBuffer(void)
 	{
+		I2Cregisters registers;
+		this->DataSnapshot(registers);
+		const unsigned char* data = &registers.Register[0];
 		for(int page=0; 2>page; ++page)
 		{
-			for(int line=0x00; 0x80>line; line+=0x10)
+			for(int line=(page*I2C_BUFFER_PAGESIZE); (page*I2C_BUFFER_PAGESIZE +0x80)>line; line+=0x10)
 			{
-				fprintf(stderr, "  %d %02X\t%02X %02X %02X %02X %02X %02X %02X %02X  %02X %02X %02X %02X %02X %02X %02X %02X\n", page, line
-					,BUFFER_REGISTER(page,line+0x00),BUFFER_REGISTER(page,line+0x01),BUFFER_REGISTER(page,line+0x02),BUFFER_REGISTER(page,line+0x03)
-					,BUFFER_REGISTER(page,line+0x04),BUFFER_REGISTER(page,line+0x05),BUFFER_REGISTER(page,line+0x06),BUFFER_REGISTER(page,line+0x07)
-					,BUFFER_REGISTER(page,line+0x08),BUFFER_REGISTER(page,line+0x09),BUFFER_REGISTER(page,line+0x0A),BUFFER_REGISTER(page,line+0x0B)
-					,BUFFER_REGISTER(page,line+0x0C),BUFFER_REGISTER(page,line+0x0D),BUFFER_REGISTER(page,line+0x0E),BUFFER_REGISTER(page,line+0x0F));
+				fprintf(stderr, "  %d %02X\t%02X %02X %02X %02X %02X %02X %02X %02X  %02X %02X %02X %02X %02X %02X %02X %02X\n", page, line %I2C_BUFFER_PAGESIZE
+					,data[line+0x00],data[line+0x01],data[line+0x02],data[line+0x03]
+					,data[line+0x04],data[line+0x05],data[line+0x06],data[line+0x07]
+					,data[line+0x08],data[line+0x09],data[line+0x0A],data[line+0x0B]
+					,data[line+0x0C],data[line+0x0D],data[line+0x0E],data[line+0x0F]);
 			}
 		}
 	}
@@ -26,6 +26,9 @@
  *
  *	Declaration of class, members and methods.
  *	I2C communication data and methods, for handling of IMU sensor.
+ *	DataBuffer belongs to the reading thread, after every reading the
+ *	register image is published and other threads take a consistent
+ *	copy with DataSnapshot, without blocking the reading thread.
  */
 
 #ifndef _I2CSENSOR_HPP_
@@ -33,10 +36,16 @@
 
 #include "../config.h"
 #include "IMU.hpp"
+#include "IMUreplay.hpp"
+#include "I2Cbackend.hpp"
+#include "Pacer.hpp"
+#include "Metrics.hpp"
+#include "SeqLock.hpp"
 
 #include <cstdlib>
 #include <cstddef>
 #include <pthread.h>
+#include <time.h>
 using namespace std;
 namespace rpiScope
 {
@@ -44,13 +53,22 @@ namespace rpiScope
 	class I2Cdevice
 	{
 		public:
-			I2Cdevice(const int i2cdeviceaddress=-1, const char* i2cbusdevice=NULL);
+			I2Cdevice(const int i2cdeviceaddress=-1, const char* i2cbusdevice=NULL, I2Cbackend* i2cbackend=NULL);
 			~I2Cdevice();
+			unsigned long I2CioctlsSaved(void) const;	//	ioctl calls skipped by probe and address caching
+			double I2CioctlsSavedRate(void) const;	//	ioctl calls skipped per second
+			void I2Cshare(I2Cdevice* owner);	//	use bus file descriptor of owner (I2Cbus), NULL for own
 		protected:
+			I2Cbackend* backend;	//	open/close/ioctl implementation (linux i2c-dev by default)
 			int fdbus;	//	i2c bus device file descriptor
 			const char* devbus;	//	i2c bus device file
 			unsigned char i2caddress;	//	i2c device address
 			unsigned long i2cfuncs;	//	supported i2c device functions
+			bool i2cprobed;	//	i2cfuncs probed for opened fdbus
+			int i2cselected;	//	slave address set on opened fdbus, -1 for none
+			unsigned long i2csaved;	//	ioctl calls skipped
+			struct timespec i2csavedsince;	//	start of counting skipped ioctl calls
+			I2Cdevice* i2cshared;	//	owner of shared bus file descriptor and selected slave address, NULL for own
 			I2Cdevice* I2Copen(const char* i2cbusdevice="/dev/i2c-1");
 			I2Cdevice* I2Cclose(void);
 			I2Cdevice* I2Cselect(const int i2cdeviceaddress=-1);
@@ -58,8 +76,10 @@ namespace rpiScope
 			I2Cdevice* I2Cwrite(char address, const unsigned char* value);
 			I2Cdevice* I2Cread(char address, unsigned char* value);
 			I2Cdevice* I2Cread(char address, unsigned char* value, int length);
+			bool I2Ctransfer(I2Cbatch& batch);	//	combined transaction, single I2C_RDWR ioctl
 			bool I2Cready(void);
 		private:
+			int I2Csmbus(char read_write, unsigned char command, int size, union i2c_smbus_data* data);
 	};
 
 	typedef enum I2Csensortype
@@ -69,10 +89,45 @@ namespace rpiScope
 		I2C_LSM9DS1,
 		I2C_BNO055,
 	}	I2Csensortype;
+	/*	I2Cvolatility
+	 *	how often registers change, selects reading of register map ranges
+	 */
+	typedef enum I2Cvolatility
+	{
+		I2C_STATIC=0,	//	identification, read after initialization
+		I2C_CONFIG,	//	control registers, read when invalidated or after I2C_REGISTER_REFRESH
+		I2C_STATUS,	//	status and slow data, read with register buffer
+		I2C_DATA,	//	sensor output, read with every sample
+	}	I2Cvolatility;
+	typedef struct I2Cregisterrange
+	{
+		unsigned char page;	//	buffer page (LSM9DS1 0=acc/gyro 1=mag, BNO055 register page)
+		unsigned char first;	//	first register
+		unsigned char last;	//	last register
+		I2Cvolatility volatility;
+	}	I2Cregisterrange;
+	/*	I2Cfifosample
+	 *	one LSM9DS1 FIFO slot, raw and scaled gyroscope and accelerometer data with reconstructed time stamp
+	 */
+	typedef struct I2Cfifosample
+	{
+		uint64_t timestamp;	//	CLOCK_MONOTONIC micro seconds
+		int16_t gyro[3];	//	X,Y,Z
+		int16_t acc[3];	//	X,Y,Z
+		float gyroscaled[3];	//	X,Y,Z degrees per second
+		float accscaled[3];	//	X,Y,Z g
+	}	I2Cfifosample;
+	/*	I2Cregisters
+	 *	register image of all pages, indexed by page*I2C_BUFFER_PAGESIZE +register
+	 */
+	typedef struct I2Cregisters
+	{
+		unsigned char Register[I2C_BUFFER_MAXPAGE*I2C_BUFFER_PAGESIZE];
+	}	I2Cregisters;
 	class I2Csensor : public I2Cdevice
 	{
 		public:
-			I2Csensor(I2Csensortype i2csensor=I2C_AutoIdentify, const int i2cdeviceaddress=-1, const char* i2cbusdevice=NULL);
+			I2Csensor(I2Csensortype i2csensor=I2C_AutoIdentify, const int i2cdeviceaddress=-1, const char* i2cbusdevice=NULL, I2Cbackend* i2cbackend=NULL);
 			~I2Csensor();
 			/*	i2c device addresses
 			 *	0x29	BNO055 9DOF (default address COM3=hi)
@@ -89,26 +144,75 @@ namespace rpiScope
 			 */
 			I2Csensortype sensortype;
 			void I2Cinitialize(void);
-			unsigned char DataBuffer[I2C_BUFFER_MAXPAGE*I2C_BUFFER_PAGESIZE];
-			void I2Cread2buffer(void);
+			void I2Cread2buffer(void);	//	status and data registers, configuration if invalidated
 			void I2Creadimu(void);
-			void IMUvalueUpdate(void);
+			bool I2Ccombined;	//	read all IMU data with one I2C_RDWR transaction, if supported by the adapter
+			void I2Cinvalidate(I2Cvolatility volatility=I2C_CONFIG);	//	read registers of class with next I2Cread2buffer
+			unsigned long register_bytes;	//	bytes transferred by I2Cread2buffer
+			unsigned long register_saved;	//	bytes not transferred, compared to reading whole register map
+			bool I2Cprepare(I2Cbatch& batch);	//	add output register reads to combined transaction, false if no space
+			void I2Ccomplete(uint64_t start);	//	publish and convert output registers read since start
+			void DataSnapshot(I2Cregisters& registers) const;	//	consistent copy of last published register image
+			unsigned long DataVersion(void) const;	//	number of published register images
 			IMU_MARGdata IMUvalue;
+			unsigned char calibration;	//	BNO055 CALIB_STAT, 2 bits each system,gyro,acc,mag (3=calibrated)
+			//	FIFO continuous mode (LSM9DS1)
+			bool FIFOstart(int watermark=I2C_FIFO_WATERMARK);
+			void FIFOstop(void);
+			bool FIFOenabled(void) const;
+			int FIFOdrain(I2Cfifosample* samples=NULL);	//	read all stored samples, returns count or -1
+			unsigned long fifo_overruns;	//	FIFO overrun detected, samples lost
+			unsigned long fifo_samples;	//	samples read from FIFO
+			//	recording of raw samples for IMU_Replay (LSM9DS1), start and stop while reading thread is stopped
+			bool IMUrecordStart(const char* logfile);
+			void IMUrecordStop(void);
+			size_t IMUrecorded(void) const;	//	records appended since start
+			//	data ready interrupt (INT1 line of LSM9DS1 acc/gyro)
+			bool DRDYattach(const char* gpiovalue);	//	sysfs gpio value file, edge is set to rising
+			bool DRDYattach(int eventfd);	//	readable file descriptor (eventfd, pipe, gpiochip line event)
+			void DRDYdetach(void);
+			bool DRDYattached(void) const;
+			int DRDYwait(int timeout=I2C_DRDY_TIMEOUT);	//	returns 1 for interrupt, 0 for timeout, -1 for error
+			unsigned long drdy_events;	//	interrupts received
+			unsigned long drdy_timeouts;	//	waiting timed out
 			void pthread_I2Creading(void);
 			void pthread_stopp(void);
+			void pthread_configure(const Thread_Config& config);	//	before pthread_I2Creading
+			void pthread_jitter(Thread_Jitter& jitter) const;	//	achieved polling period
+			Metrics_Loop metrics;	//	bus read duration, loop period, conversion time, FIFO depth
 		protected:
 			unsigned char i2caddress_gyro;	//	i2c device address, gyroscope
 			unsigned char i2caddress_acc;	//	i2c device address, accelerometer
 			unsigned char i2caddress_mag;	//	i2c device address, geomagnetic
 			bool Identify_LSM9DS1(void);
 			bool Identify_BNO055(void);
+			//	register image, written by reading thread only
+			unsigned char DataBuffer[I2C_BUFFER_MAXPAGE*I2C_BUFFER_PAGESIZE];
+			SeqLock<I2Cregisters> DataPublished;	//	copy of DataBuffer for other threads
+			unsigned char registers_stale;	//	volatility classes to read, bit per I2Cvolatility
+			uint64_t registers_refreshed;	//	time stamp of last configuration reading
+			int I2Creadmap(const I2Cregisterrange* map, int ranges, unsigned char classes);	//	returns bytes transferred
+			void DataPublish(void);
+			void IMUvalueUpdate(void);
+			IMU_Recorder recorder;	//	appended by reading thread, if opened
 			//	threading
 			bool pthread_stopping;
 			pthread_t pthread_read;
 			pthread_attr_t pthread_attributes;
+			Thread_Config pthread_config;
+			Thread_Pacer pthread_pacer;
 			void DebugDataBuffer(void);
 			friend void *pthread_DataReading(void *data);
+			friend class I2Cbus;
 			float datarate;	//	output data rate of sensors
+			float fifo_rate;	//	FIFO data rate (gyroscope or accelerometer output data rate)
+			bool fifo_enabled;	//	FIFO continuous mode active
+			int fifo_watermark;	//	FIFO threshold level
+			uint64_t fifo_lasttime;	//	time stamp of last sample read from FIFO
+			int drdy_fd;	//	data ready interrupt file descriptor
+			bool drdy_sysfs;	//	sysfs gpio value file (POLLPRI), otherwise readable fd (POLLIN)
+			bool drdy_owned;	//	file descriptor opened by DRDYattach
+			void DRDYenable(bool enable);
 		private:
 	};
 	void *pthread_DataReading(void *data);
@@ -13,11 +13,15 @@
 #include <cmath>
 #include <climits>
 
-#if defined(USE_MADGWICK_AHRS)
-	namespace Madgwick { extern "C" {
-#		include "../MadgwickAHRS/MadgwickAHRS.h"
-	}};
-#endif // defined
+#if !defined(DONT_USE_SIMD)
+#	if defined(__SSE2__)
+#		include <emmintrin.h>
+#		define IMU_CONVERT_SSE2 true
+#	elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#		include <arm_neon.h>
+#		define IMU_CONVERT_NEON true
+#	endif
+#endif
 
 using namespace std;
 namespace rpiScope
@@ -188,111 +192,539 @@ namespace rpiScope
 	}
 
 	IMU_Data::IMU_Data()
+		: Head(0), SumX(0), SumY(0), SumZ(0), Count(0), StateX(0.0), StateY(0.0), StateZ(0.0)
 	{
-		this->LPF_MaxValues = 32;
+		this->LPF_Writing.clear();
 		this->FullScale = 1.0;
-		this->InitMutex();
+		memset(&this->Ring[0], 0x00, sizeof(this->Ring));
+		//	moving average of 32 samples
+		memset(&this->LPF_Active, 0x00, sizeof(this->LPF_Active));
+		this->LPF_Active.Type = IMU_FilterMovingAverage;
+		this->LPF_Active.Window = 32;
+		this->LPF_Active.Alpha = 1.0;
+		this->LPF_MaxValues = this->LPF_Active.Window;
+		this->LPF_Pending.Write(this->LPF_Active);
+		this->LPF_Version = this->LPF_Pending.Version();
 	}
 	IMU_Data::~IMU_Data()
 	{
 #		if defined(DEBUG4)
-		printf("\t%s\t%s\t%s\n", "IMU_Data", "destructor", "begin");
-#		endif
-		this->DestroyMutex();
-#		if defined(DEBUG4)
-		printf("\t%s\t%s\t%s\n", "IMU_Data", "destructor", "done");
+		printf("\t%s\t%s\t%s\n", "IMU_Data", "destructor", "");
 #		endif
 	}
+	void IMU_Data::LPF_request(const IMU_FilterConfig& config)
+	{
+		//	applied by producer, filter state belongs to producer thread
+		while(this->LPF_Writing.test_and_set(std::memory_order_acquire))
+			;
+		this->LPF_Pending.Write(config);
+		this->LPF_Writing.clear(std::memory_order_release);
+	}
 	void IMU_Data::LPF_resize(size_t LPFValues)
 	{
-		if(32 < LPFValues)
-			this->LPF_MaxValues = LPFValues;
-		else if(16 < LPFValues)
-			this->LPF_MaxValues = 32;
-		else if(8 < LPFValues)
-			this->LPF_MaxValues = 16;
-		else if(4 < LPFValues)
-			this->LPF_MaxValues = 8;
-		else if(1 < LPFValues)
-			this->LPF_MaxValues = 4;
-		else
-			this->LPF_MaxValues = 1;
+		IMU_FilterConfig config = this->LPF_config();
+		config.Type = IMU_FilterMovingAverage;
+		config.Window = (1 > LPFValues ?1 :LPFValues);
+		if(IMU_BUFFER_SIZE < config.Window)
+			config.Window = IMU_BUFFER_SIZE;
+		this->LPF_request(config);
 	}
-	void IMU_Data::InitMutex(void)
+	void IMU_Data::LPF_IIR(double alpha)
 	{
-		//	init mutex
-		pthread_mutex_init(&this->pthread_mutex, NULL);
+		IMU_FilterConfig config = this->LPF_config();
+		config.Type = IMU_FilterIIR;
+		config.Alpha = (0.0 >= alpha || 1.0 < alpha ?1.0 :alpha);
+		this->LPF_request(config);
 	}
-	void IMU_Data::DestroyMutex(void)
+	bool IMU_Data::LPF_FIR(const double* taps, size_t count)
 	{
-#		if defined(DEBUG4)
-		printf("\t%s\t%s\t%s\n", "IMU_Data", "DestroyMutex", "");
-#		endif
-		//	destroy mutex
-		pthread_mutex_lock(&this->pthread_mutex);
-		pthread_mutex_destroy(&this->pthread_mutex);
+		if(NULL == taps || 0 == count || IMU_FIR_MAXTAPS < count)
+		{
+			return(false);
+		}
+		IMU_FilterConfig config = this->LPF_config();
+		config.Type = IMU_FilterFIR;
+		config.Taps = count;
+		memcpy(&config.Tap[0], taps, count *sizeof(double));
+		this->LPF_request(config);
+		return(true);
 	}
-	IMU_Vector*	IMU_Data::vector(void)
+	IMU_FilterConfig IMU_Data::LPF_config(void) const
 	{
-		//	calculate average
-		double X = 0;
-		double Y = 0;
-		double Z = 0;
-		pthread_mutex_lock(&this->pthread_mutex);
-		size_t count = this->LPF_Values.size();
-		if(0 < count)
+		IMU_FilterConfig config;
+		this->LPF_Pending.Read(config);
+		return(config);
+	}
+	size_t IMU_Data::LPF_lowpass(double* taps, size_t count, double cutoff)
+	{
+		if(NULL == taps || 0 == count || IMU_FIR_MAXTAPS < count || 0.0 >= cutoff || 0.5 < cutoff)
 		{
-			for(size_t pos=0; pos<count; ++pos)
-			{
-				X += this->LPF_Values[pos].X;
-				Y += this->LPF_Values[pos].Y;
-				Z += this->LPF_Values[pos].Z;
-			}
-			X /= count;
-			Y /= count;
-			Z /= count;
+			return(0);
+		}
+		//	sinc with hamming window, normalized to unity gain
+		double sum = 0.0;
+		double center = (count -1) /2.0;
+		for(size_t pos=0; count>pos; ++pos)
+		{
+			double x = pos -center;
+			double sinc = (0.0 == x ?2.0*cutoff :sin(2.0*M_PI*cutoff*x) /(M_PI*x));
+			double window = (1 < count ?0.54 -0.46*cos(2.0*M_PI*pos /(count -1)) :1.0);
+			taps[pos] = sinc *window;
+			sum += taps[pos];
+		}
+		for(size_t pos=0; count>pos; ++pos)
+		{
+			taps[pos] /= sum;
 		}
-		pthread_mutex_unlock(&this->pthread_mutex);
-		IMU_Vector* value = new IMU_Vector(X, Y, Z, this->FullScale);
+		return(count);
+	}
+	IMU_Vector*	IMU_Data::vector(void)
+	{
+		IMU_Vector* value = new IMU_Vector();
+		this->vector(*value);
 		return(value);
 	}
+	IMU_Vector&	IMU_Data::vector(IMU_Vector& value)
+	{
+		IMU_Output output;
+		this->Output.Read(output);
+		return(value.set(output.X, output.Y, output.Z, (0.0 == this->FullScale) ?1.0 :this->FullScale));
+	}
 	int16_t IMU_Data::rawX(void)
 	{
-		return(this->LPF_Values.empty() ?0 :this->LPF_Values.back().X);
+		IMU_Output output;
+		this->Output.Read(output);
+		return(output.Last.X);
 	}
 	double IMU_Data::scaledX(void)
 	{
-		return(this->LPF_Values.empty() ?0.0 :(this->LPF_Values.back().X * this->FullScale));
+		return(this->rawX() * this->FullScale);
 	}
 	int16_t IMU_Data::rawY(void)
 	{
-		return(this->LPF_Values.empty() ?0 :this->LPF_Values.back().Y);
+		IMU_Output output;
+		this->Output.Read(output);
+		return(output.Last.Y);
 	}
 	double IMU_Data::scaledY(void)
 	{
-		return(this->LPF_Values.empty() ?0.0 :(this->LPF_Values.back().Y * this->FullScale));
+		return(this->rawY() * this->FullScale);
 	}
 	int16_t IMU_Data::rawZ(void)
 	{
-		return(this->LPF_Values.empty() ?0 :this->LPF_Values.back().Z);
+		IMU_Output output;
+		this->Output.Read(output);
+		return(output.Last.Z);
 	}
 	double IMU_Data::scaledZ(void)
 	{
-		return(this->LPF_Values.empty() ?0.0 :(this->LPF_Values.back().Z * this->FullScale));
+		return(this->rawZ() * this->FullScale);
+	}
+	void	IMU_Data::LPF_apply(uint64_t head)
+	{
+		this->LPF_Version = this->LPF_Pending.Version();
+		this->LPF_Pending.Read(this->LPF_Active);
+		//	moving average, recalculate sums once
+		this->LPF_MaxValues = this->LPF_Active.Window;
+		this->Count = (head < this->LPF_MaxValues ?head :this->LPF_MaxValues);
+		this->SumX = this->SumY = this->SumZ = 0;
+		for(uint64_t pos=head -this->Count; head>pos; ++pos)
+		{
+			const IMU_Sample& sample = this->Ring[pos &(IMU_BUFFER_SIZE-1)];
+			this->SumX += sample.X;
+			this->SumY += sample.Y;
+			this->SumZ += sample.Z;
+		}
+		//	IIR, continue from published value
+		IMU_Output output;
+		this->Output.Read(output);
+		this->StateX = output.X;
+		this->StateY = output.Y;
+		this->StateZ = output.Z;
 	}
 	void	IMU_Data::Push(int16_t X, int16_t Y, int16_t Z)
 	{
-		IMU_Vector value(X,Y,Z);
-		pthread_mutex_lock(&this->pthread_mutex);
-		this->LPF_Values.push_back(value);
-		while(this->LPF_MaxValues < this->LPF_Values.size())
+		uint64_t head = this->Head.load(std::memory_order_relaxed);
+		//	filter changed by LPF_(...)
+		if(this->LPF_Pending.Version() != this->LPF_Version)
+		{
+			this->LPF_apply(head);
+		}
+		//	oldest sample leaves moving average window
+		if(this->Count == this->LPF_MaxValues)
+		{
+			const IMU_Sample& oldest = this->Ring[(head -this->LPF_MaxValues) &(IMU_BUFFER_SIZE-1)];
+			this->SumX -= oldest.X;
+			this->SumY -= oldest.Y;
+			this->SumZ -= oldest.Z;
+		}
+		else
+		{
+			++this->Count;
+		}
+		IMU_Sample& sample = this->Ring[head &(IMU_BUFFER_SIZE-1)];
+		sample.X = X;
+		sample.Y = Y;
+		sample.Z = Z;
+		this->SumX += X;
+		this->SumY += Y;
+		this->SumZ += Z;
+		this->Head.store(head +1, std::memory_order_release);
+		//	publish filtered value
+		IMU_Output output;
+		if(IMU_FilterIIR == this->LPF_Active.Type)
+		{
+			double alpha = (0 == head ?1.0 :this->LPF_Active.Alpha);
+			this->StateX += alpha *(X -this->StateX);
+			this->StateY += alpha *(Y -this->StateY);
+			this->StateZ += alpha *(Z -this->StateZ);
+			output.X = this->StateX;
+			output.Y = this->StateY;
+			output.Z = this->StateZ;
+		}
+		else if(IMU_FilterFIR == this->LPF_Active.Type)
+		{
+			//	before first samples, oldest sample is repeated
+			output.X = output.Y = output.Z = 0.0;
+			for(size_t tap=0; this->LPF_Active.Taps>tap; ++tap)
+			{
+				const IMU_Sample& value = this->Ring[(tap > head ?0 :head -tap) &(IMU_BUFFER_SIZE-1)];
+				output.X += this->LPF_Active.Tap[tap] *value.X;
+				output.Y += this->LPF_Active.Tap[tap] *value.Y;
+				output.Z += this->LPF_Active.Tap[tap] *value.Z;
+			}
+		}
+		else
+		{
+			output.X = (double)this->SumX / this->Count;
+			output.Y = (double)this->SumY / this->Count;
+			output.Z = (double)this->SumZ / this->Count;
+		}
+		output.Last = sample;
+		this->Output.Write(output);
+	}
+	size_t	IMU_Data::Read(IMU_Sample* samples, size_t maxsamples, uint64_t& position)
+	{
+		uint64_t head = this->Head.load(std::memory_order_acquire);
+		if(head > position +IMU_BUFFER_SIZE)
+		{
+			//	reader too slow, samples lost
+			position = head -IMU_BUFFER_SIZE;
+		}
+		size_t count = (head -position < maxsamples ?head -position :maxsamples);
+		for(size_t pos=0; count>pos; ++pos)
+		{
+			samples[pos] = this->Ring[(position +pos) &(IMU_BUFFER_SIZE-1)];
+		}
+		//	drop samples overwritten while copying, producer may be writing the slot after head
+		std::atomic_thread_fence(std::memory_order_acquire);
+		head = this->Head.load(std::memory_order_relaxed);
+		if(head +1 > position +IMU_BUFFER_SIZE)
+		{
+			size_t lost = head +1 -IMU_BUFFER_SIZE -position;
+			if(lost >= count)
+			{
+				position = head +1 -IMU_BUFFER_SIZE;
+				return(0);
+			}
+			memmove(&samples[0], &samples[lost], (count -lost) *sizeof(IMU_Sample));
+			count -= lost;
+			position += lost;
+		}
+		position += count;
+		return(count);
+	}
+	uint64_t	IMU_Data::Pushed(void) const
+	{
+		return(this->Head.load(std::memory_order_acquire));
+	}
+
+	//	16bit value from sensor register pair
+	static inline int16_t IMU_Value(const unsigned char* buffer, bool bigendian)
+	{
+		return(bigendian ?(int16_t)((buffer[0] <<8) | buffer[1]) :(int16_t)((buffer[1] <<8) | buffer[0]));
+	}
+	size_t	IMU_Data::Convert(const unsigned char* raw, size_t count, bool bigendian, float scale, float* X, float* Y, float* Z)
+	{
+		size_t pos = 0;
+#		if defined(IMU_CONVERT_SSE2)
+		//	8 samples (48 bytes) per step, sign extend to 32bit and deinterleave as float
+		const __m128 factor = _mm_set1_ps(scale);
+		for(; count>=pos +8; pos+=8, raw+=48)
+		{
+			__m128 value[6];
+			for(int part=0; 3>part; ++part)
+			{
+				__m128i word = _mm_loadu_si128((const __m128i*)(raw +16*part));
+				if(bigendian)
+					word = _mm_or_si128(_mm_slli_epi16(word, 8), _mm_srli_epi16(word, 8));
+				value[2*part] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(word, word), 16)), factor);
+				value[2*part+1] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(word, word), 16)), factor);
+			}
+			for(int half=0; 2>half; ++half)
+			{
+				//	a=[x0 y0 z0 x1] b=[y1 z1 x2 y2] c=[z2 x3 y3 z3]
+				const __m128& a = value[3*half];
+				const __m128& b = value[3*half+1];
+				const __m128& c = value[3*half+2];
+				_mm_storeu_ps(&X[pos +4*half], _mm_shuffle_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3,3,0,0)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(1,1,2,2)), _MM_SHUFFLE(2,0,2,0)));
+				_mm_storeu_ps(&Y[pos +4*half], _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0,0,1,1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2,2,3,3)), _MM_SHUFFLE(2,0,2,0)));
+				_mm_storeu_ps(&Z[pos +4*half], _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1,1,2,2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3,3,0,0)), _MM_SHUFFLE(2,0,2,0)));
+			}
+		}
+#		elif defined(IMU_CONVERT_NEON)
+		//	8 samples (48 bytes) per step, vld3 deinterleaves
+		for(; count>=pos +8; pos+=8, raw+=48)
+		{
+			int16x8x3_t word = vld3q_s16((const int16_t*)raw);
+			float* output[3] = {&X[pos], &Y[pos], &Z[pos]};
+			for(int axis=0; 3>axis; ++axis)
+			{
+				if(bigendian)
+					word.val[axis] = vreinterpretq_s16_u8(vrev16q_u8(vreinterpretq_u8_s16(word.val[axis])));
+				vst1q_f32(output[axis], vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(word.val[axis]))), scale));
+				vst1q_f32(output[axis] +4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(word.val[axis]))), scale));
+			}
+		}
+#		endif
+		//	remaining samples, or all without SIMD
+		for(; count>pos; ++pos, raw+=6)
+		{
+			X[pos] = IMU_Value(&raw[0], bigendian) *scale;
+			Y[pos] = IMU_Value(&raw[2], bigendian) *scale;
+			Z[pos] = IMU_Value(&raw[4], bigendian) *scale;
+		}
+		return(count);
+	}
+	size_t	IMU_Data::Convert(const unsigned char* raw, size_t count, bool bigendian, float* X, float* Y, float* Z) const
+	{
+		return(IMU_Data::Convert(raw, count, bigendian, (float)this->FullScale, X, Y, Z));
+	}
+
+	IMU_AHRS::IMU_AHRS(double rate, double gain)
+		: SampleRate(rate), Gain(gain)
+	{
+		this->Reset();
+	}
+	IMU_AHRS::~IMU_AHRS()
+	{
+	}
+	void IMU_AHRS::Reset(void)
+	{
+		this->LastTime = 0;
+		this->State.Q0 = 1.0;
+		this->State.Q1 = this->State.Q2 = this->State.Q3 = 0.0;
+		this->State.Updates = 0;
+		this->Published.Write(this->State);
+	}
+	void IMU_AHRS::SetSampleRate(double rate)
+	{
+		if(0.0 < rate)
+			this->SampleRate = rate;
+	}
+	void IMU_AHRS::SetGain(double gain)
+	{
+		this->Gain = gain;
+	}
+	double IMU_AHRS::GetGain(void) const
+	{
+		return(this->Gain);
+	}
+	void IMU_AHRS::Update(double gx, double gy, double gz, double ax, double ay, double az, double mx, double my, double mz, uint64_t timestamp)
+	{
+		//	integration step from time stamps, nominal rate for first sample and time steps above 1s
+		double dt = 1.0 / this->SampleRate;
+		if(0 != timestamp && 0 != this->LastTime)
+		{
+			if(timestamp <= this->LastTime)
+				return;	//	sample already fused
+			if(1000000 > timestamp -this->LastTime)
+				dt = (timestamp -this->LastTime) /1e6;
+		}
+		this->LastTime = timestamp;
+		//	use IMU algorithm if magnetometer measurement invalid (avoids NaN in magnetometer normalisation)
+		if(0.0 == mx && 0.0 == my && 0.0 == mz)
+			this->UpdateIMU(gx,gy,gz, ax,ay,az, dt);
+		else
+			this->UpdateMARG(gx,gy,gz, ax,ay,az, mx,my,mz, dt);
+		++this->State.Updates;
+		this->Published.Write(this->State);
+	}
+	void IMU_AHRS::UpdateMARG(double gx, double gy, double gz, double ax, double ay, double az, double mx, double my, double mz, double dt)
+	{
+		double q0 = this->State.Q0, q1 = this->State.Q1, q2 = this->State.Q2, q3 = this->State.Q3;
+		double recipNorm;
+		//	rate of change of quaternion from gyroscope
+		double qDot1 = 0.5 * (-q1 * gx - q2 * gy - q3 * gz);
+		double qDot2 = 0.5 * (q0 * gx + q2 * gz - q3 * gy);
+		double qDot3 = 0.5 * (q0 * gy - q1 * gz + q3 * gx);
+		double qDot4 = 0.5 * (q0 * gz + q1 * gy - q2 * gx);
+		//	compute feedback only if accelerometer measurement valid (avoids NaN in accelerometer normalisation)
+		if(!(0.0 == ax && 0.0 == ay && 0.0 == az))
 		{
-			this->LPF_Values.pop_front();
+			//	normalise accelerometer and magnetometer measurement
+			recipNorm = 1.0 / std::sqrt(ax * ax + ay * ay + az * az);
+			ax *= recipNorm;
+			ay *= recipNorm;
+			az *= recipNorm;
+			recipNorm = 1.0 / std::sqrt(mx * mx + my * my + mz * mz);
+			mx *= recipNorm;
+			my *= recipNorm;
+			mz *= recipNorm;
+			//	auxiliary variables to avoid repeated arithmetic
+			double _2q0mx = 2.0 * q0 * mx;
+			double _2q0my = 2.0 * q0 * my;
+			double _2q0mz = 2.0 * q0 * mz;
+			double _2q1mx = 2.0 * q1 * mx;
+			double _2q0 = 2.0 * q0;
+			double _2q1 = 2.0 * q1;
+			double _2q2 = 2.0 * q2;
+			double _2q3 = 2.0 * q3;
+			double _2q0q2 = 2.0 * q0 * q2;
+			double _2q2q3 = 2.0 * q2 * q3;
+			double q0q0 = q0 * q0;
+			double q0q1 = q0 * q1;
+			double q0q2 = q0 * q2;
+			double q0q3 = q0 * q3;
+			double q1q1 = q1 * q1;
+			double q1q2 = q1 * q2;
+			double q1q3 = q1 * q3;
+			double q2q2 = q2 * q2;
+			double q2q3 = q2 * q3;
+			double q3q3 = q3 * q3;
+			//	reference direction of Earth's magnetic field
+			double hx = mx * q0q0 - _2q0my * q3 + _2q0mz * q2 + mx * q1q1 + _2q1 * my * q2 + _2q1 * mz * q3 - mx * q2q2 - mx * q3q3;
+			double hy = _2q0mx * q3 + my * q0q0 - _2q0mz * q1 + _2q1mx * q2 - my * q1q1 + my * q2q2 + _2q2 * mz * q3 - my * q3q3;
+			double _2bx = std::sqrt(hx * hx + hy * hy);
+			double _2bz = -_2q0mx * q2 + _2q0my * q1 + mz * q0q0 + _2q1mx * q3 - mz * q1q1 + _2q2 * my * q3 - mz * q2q2 + mz * q3q3;
+			double _4bx = 2.0 * _2bx;
+			double _4bz = 2.0 * _2bz;
+			//	gradient decent algorithm corrective step
+			double s0 = -_2q2 * (2.0 * q1q3 - _2q0q2 - ax) + _2q1 * (2.0 * q0q1 + _2q2q3 - ay) - _2bz * q2 * (_2bx * (0.5 - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx) + (-_2bx * q3 + _2bz * q1) * (_2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - my) + _2bx * q2 * (_2bx * (q0q2 + q1q3) + _2bz * (0.5 - q1q1 - q2q2) - mz);
+			double s1 = _2q3 * (2.0 * q1q3 - _2q0q2 - ax) + _2q0 * (2.0 * q0q1 + _2q2q3 - ay) - 4.0 * q1 * (1 - 2.0 * q1q1 - 2.0 * q2q2 - az) + _2bz * q3 * (_2bx * (0.5 - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx) + (_2bx * q2 + _2bz * q0) * (_2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - my) + (_2bx * q3 - _4bz * q1) * (_2bx * (q0q2 + q1q3) + _2bz * (0.5 - q1q1 - q2q2) - mz);
+			double s2 = -_2q0 * (2.0 * q1q3 - _2q0q2 - ax) + _2q3 * (2.0 * q0q1 + _2q2q3 - ay) - 4.0 * q2 * (1 - 2.0 * q1q1 - 2.0 * q2q2 - az) + (-_4bx * q2 - _2bz * q0) * (_2bx * (0.5 - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx) + (_2bx * q1 + _2bz * q3) * (_2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - my) + (_2bx * q0 - _4bz * q2) * (_2bx * (q0q2 + q1q3) + _2bz * (0.5 - q1q1 - q2q2) - mz);
+			double s3 = _2q1 * (2.0 * q1q3 - _2q0q2 - ax) + _2q2 * (2.0 * q0q1 + _2q2q3 - ay) + (-_4bx * q3 + _2bz * q1) * (_2bx * (0.5 - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx) + (-_2bx * q0 + _2bz * q2) * (_2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - my) + _2bx * q1 * (_2bx * (q0q2 + q1q3) + _2bz * (0.5 - q1q1 - q2q2) - mz);
+			recipNorm = std::sqrt(s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3);
+			if(0.0 != recipNorm)
+			{
+				//	apply normalised feedback step
+				recipNorm = this->Gain / recipNorm;
+				qDot1 -= recipNorm * s0;
+				qDot2 -= recipNorm * s1;
+				qDot3 -= recipNorm * s2;
+				qDot4 -= recipNorm * s3;
+			}
 		}
-		pthread_mutex_unlock(&this->pthread_mutex);
+		//	integrate rate of change of quaternion, normalise quaternion
+		q0 += qDot1 * dt;
+		q1 += qDot2 * dt;
+		q2 += qDot3 * dt;
+		q3 += qDot4 * dt;
+		recipNorm = 1.0 / std::sqrt(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+		this->State.Q0 = q0 * recipNorm;
+		this->State.Q1 = q1 * recipNorm;
+		this->State.Q2 = q2 * recipNorm;
+		this->State.Q3 = q3 * recipNorm;
+	}
+	void IMU_AHRS::UpdateIMU(double gx, double gy, double gz, double ax, double ay, double az, double dt)
+	{
+		double q0 = this->State.Q0, q1 = this->State.Q1, q2 = this->State.Q2, q3 = this->State.Q3;
+		double recipNorm;
+		//	rate of change of quaternion from gyroscope
+		double qDot1 = 0.5 * (-q1 * gx - q2 * gy - q3 * gz);
+		double qDot2 = 0.5 * (q0 * gx + q2 * gz - q3 * gy);
+		double qDot3 = 0.5 * (q0 * gy - q1 * gz + q3 * gx);
+		double qDot4 = 0.5 * (q0 * gz + q1 * gy - q2 * gx);
+		//	compute feedback only if accelerometer measurement valid (avoids NaN in accelerometer normalisation)
+		if(!(0.0 == ax && 0.0 == ay && 0.0 == az))
+		{
+			//	normalise accelerometer measurement
+			recipNorm = 1.0 / std::sqrt(ax * ax + ay * ay + az * az);
+			ax *= recipNorm;
+			ay *= recipNorm;
+			az *= recipNorm;
+			//	auxiliary variables to avoid repeated arithmetic
+			double _2q0 = 2.0 * q0;
+			double _2q1 = 2.0 * q1;
+			double _2q2 = 2.0 * q2;
+			double _2q3 = 2.0 * q3;
+			double _4q0 = 4.0 * q0;
+			double _4q1 = 4.0 * q1;
+			double _4q2 = 4.0 * q2;
+			double _8q1 = 8.0 * q1;
+			double _8q2 = 8.0 * q2;
+			double q0q0 = q0 * q0;
+			double q1q1 = q1 * q1;
+			double q2q2 = q2 * q2;
+			double q3q3 = q3 * q3;
+			//	gradient decent algorithm corrective step
+			double s0 = _4q0 * q2q2 + _2q2 * ax + _4q0 * q1q1 - _2q1 * ay;
+			double s1 = _4q1 * q3q3 - _2q3 * ax + 4.0 * q0q0 * q1 - _2q0 * ay - _4q1 + _8q1 * q1q1 + _8q1 * q2q2 + _4q1 * az;
+			double s2 = 4.0 * q0q0 * q2 + _2q0 * ax + _4q2 * q3q3 - _2q3 * ay - _4q2 + _8q2 * q1q1 + _8q2 * q2q2 + _4q2 * az;
+			double s3 = 4.0 * q1q1 * q3 - _2q1 * ax + 4.0 * q2q2 * q3 - _2q2 * ay;
+			recipNorm = std::sqrt(s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3);
+			if(0.0 != recipNorm)
+			{
+				//	apply normalised feedback step
+				recipNorm = this->Gain / recipNorm;
+				qDot1 -= recipNorm * s0;
+				qDot2 -= recipNorm * s1;
+				qDot3 -= recipNorm * s2;
+				qDot4 -= recipNorm * s3;
+			}
+		}
+		//	integrate rate of change of quaternion, normalise quaternion
+		q0 += qDot1 * dt;
+		q1 += qDot2 * dt;
+		q2 += qDot3 * dt;
+		q3 += qDot4 * dt;
+		recipNorm = 1.0 / std::sqrt(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+		this->State.Q0 = q0 * recipNorm;
+		this->State.Q1 = q1 * recipNorm;
+		this->State.Q2 = q2 * recipNorm;
+		this->State.Q3 = q3 * recipNorm;
+	}
+	void IMU_AHRS::Set(double q0, double q1, double q2, double q3, uint64_t timestamp)
+	{
+		//	normalise, sensor output is rounded to LSB
+		double norm = std::sqrt(q0*q0 + q1*q1 + q2*q2 + q3*q3);
+		if(0.0 == norm)
+			return;
+		this->State.Q0 = q0 / norm;
+		this->State.Q1 = q1 / norm;
+		this->State.Q2 = q2 / norm;
+		this->State.Q3 = q3 / norm;
+		this->LastTime = timestamp;
+		++this->State.Updates;
+		this->Published.Write(this->State);
+	}
+	void IMU_AHRS::Quaternion(double& q0, double& q1, double& q2, double& q3) const
+	{
+		IMU_Quaternion value;
+		this->Published.Read(value);
+		q0 = value.Q0;
+		q1 = value.Q1;
+		q2 = value.Q2;
+		q3 = value.Q3;
+	}
+	IMU_Vector& IMU_AHRS::Euler(IMU_Vector& value) const
+	{
+		IMU_Quaternion q;
+		this->Published.Read(q);
+		double roll = std::atan2(q.Q0*q.Q1 + q.Q2*q.Q3, 0.5 - q.Q1*q.Q1 - q.Q2*q.Q2);
+		double pitch = std::asin(-2.0 * (q.Q1*q.Q3 - q.Q0*q.Q2));
+		double yaw = std::atan2(q.Q1*q.Q2 + q.Q0*q.Q3, 0.5 - q.Q2*q.Q2 - q.Q3*q.Q3);
+		return(value.set(roll *(180.0 / M_PI), pitch *(180.0 / M_PI), yaw *(180.0 / M_PI), 1.0));
+	}
+	uint64_t IMU_AHRS::Updates(void) const
+	{
+		IMU_Quaternion value;
+		this->Published.Read(value);
+		return(value.Updates);
 	}
 
 	IMU_MARGdata::IMU_MARGdata(size_t LPFValues)
+		: SampleTime(0), SensorFusion(false)
 	{
 		this->LPF_resize(LPFValues);
 	}
@@ -305,21 +737,25 @@ namespace rpiScope
 
 	void IMU_MARGdata::LPF_resize(size_t LPFValues)
 	{
-		size_t LPF_MaxValues = 1;
-		if(32 < LPFValues)
-			LPF_MaxValues = LPFValues;
-		else if(16 < LPFValues)
-			LPF_MaxValues = 32;
-		else if(8 < LPFValues)
-			LPF_MaxValues = 16;
-		else if(4 < LPFValues)
-			LPF_MaxValues = 8;
-		else if(1 < LPFValues)
-			LPF_MaxValues = 4;
 		//	set to childs
-		this->DataMagnetometer.LPF_resize(LPF_MaxValues);
-		this->DataAcceleration.LPF_resize(LPF_MaxValues);
-		this->DataGyroscope.LPF_resize(LPF_MaxValues);
+		this->DataMagnetometer.LPF_resize(LPFValues);
+		this->DataAcceleration.LPF_resize(LPFValues);
+		this->DataGyroscope.LPF_resize(LPFValues);
+		this->DataLinearAcceleration.LPF_resize(LPFValues);
+	}
+	void IMU_MARGdata::LPF_IIR(double alpha)
+	{
+		this->DataMagnetometer.LPF_IIR(alpha);
+		this->DataAcceleration.LPF_IIR(alpha);
+		this->DataGyroscope.LPF_IIR(alpha);
+		this->DataLinearAcceleration.LPF_IIR(alpha);
+	}
+	bool IMU_MARGdata::LPF_FIR(const double* taps, size_t count)
+	{
+		return(this->DataMagnetometer.LPF_FIR(taps, count)
+			&& this->DataAcceleration.LPF_FIR(taps, count)
+			&& this->DataGyroscope.LPF_FIR(taps, count)
+			&& this->DataLinearAcceleration.LPF_FIR(taps, count));
 	}
 
 	IMU_Vector* IMU_MARGdata::Magnetometer(void)
@@ -334,6 +770,26 @@ namespace rpiScope
 	{
 		return(this->DataGyroscope.vector());
 	}
+	IMU_Vector* IMU_MARGdata::LinearAcceleration(void)
+	{
+		return(this->DataLinearAcceleration.vector());
+	}
+	IMU_Vector& IMU_MARGdata::Magnetometer(IMU_Vector& value)
+	{
+		return(this->DataMagnetometer.vector(value));
+	}
+	IMU_Vector& IMU_MARGdata::Acceleration(IMU_Vector& value)
+	{
+		return(this->DataAcceleration.vector(value));
+	}
+	IMU_Vector& IMU_MARGdata::Gyroscope(IMU_Vector& value)
+	{
+		return(this->DataGyroscope.vector(value));
+	}
+	IMU_Vector& IMU_MARGdata::LinearAcceleration(IMU_Vector& value)
+	{
+		return(this->DataLinearAcceleration.vector(value));
+	}
 
 	void IMU_MARGdata::PushMagnetometer(int16_t X, int16_t Y, int16_t Z)
 	{
@@ -347,25 +803,67 @@ namespace rpiScope
 	{
 		this->DataGyroscope.Push(X,Y,Z);
 	}
+	void IMU_MARGdata::PushLinearAcceleration(int16_t X, int16_t Y, int16_t Z)
+	{
+		this->DataLinearAcceleration.Push(X,Y,Z);
+	}
+	void IMU_MARGdata::PushQuaternion(double q0, double q1, double q2, double q3)
+	{
+		this->SensorFusion = true;
+		this->AHRS.Set(q0,q1,q2,q3, this->SampleTime);
+	}
+	size_t IMU_MARGdata::ConvertMagnetometer(const unsigned char* raw, size_t count, bool bigendian, float* X, float* Y, float* Z) const
+	{
+		return(this->DataMagnetometer.Convert(raw, count, bigendian, X, Y, Z));
+	}
+	size_t IMU_MARGdata::ConvertAcceleration(const unsigned char* raw, size_t count, bool bigendian, float* X, float* Y, float* Z) const
+	{
+		return(this->DataAcceleration.Convert(raw, count, bigendian, X, Y, Z));
+	}
+	size_t IMU_MARGdata::ConvertGyroscope(const unsigned char* raw, size_t count, bool bigendian, float* X, float* Y, float* Z) const
+	{
+		return(this->DataGyroscope.Convert(raw, count, bigendian, X, Y, Z));
+	}
 	void IMU_MARGdata::SetFullScale(double gyro, double acc, double mag)
 	{
 		this->DataGyroscope.FullScale = gyro;	//dps (degrees/sec)
 		this->DataAcceleration.FullScale = acc;	//g (1g = 9,8 m/s^2 earth gravity)
+		this->DataLinearAcceleration.FullScale = acc;
 		this->DataMagnetometer.FullScale = mag;	//gauss
 	}
+	void IMU_MARGdata::GetFullScale(double& gyro, double& acc, double& mag) const
+	{
+		gyro = this->DataGyroscope.FullScale;
+		acc = this->DataAcceleration.FullScale;
+		mag = this->DataMagnetometer.FullScale;
+	}
+	void IMU_MARGdata::SetSampleTime(uint64_t timestamp)
+	{
+		this->SampleTime = timestamp;
+	}
+	uint64_t IMU_MARGdata::GetSampleTime(void)
+	{
+		return(this->SampleTime);
+	}
+	void IMU_MARGdata::SetSampleRate(double rate)
+	{
+		this->AHRS.SetSampleRate(rate);
+	}
 
 	void IMU_MARGdata::MadgwickAHRSupdate(void)
+	{
+		double gyroscale = this->DataGyroscope.FullScale;
+		double accscale = this->DataAcceleration.FullScale;
+		this->MadgwickAHRSupdate(gyroscale * this->DataGyroscope.rawX(), gyroscale * this->DataGyroscope.rawY(), gyroscale * this->DataGyroscope.rawZ()
+			, accscale * this->DataAcceleration.rawX(), accscale * this->DataAcceleration.rawY(), accscale * this->DataAcceleration.rawZ());
+	}
+	void IMU_MARGdata::MadgwickAHRSupdate(double gx, double gy, double gz, double ax, double ay, double az)
 	{
 #		if defined(USE_MADGWICK_AHRS)
 		//	need gyro data in radian per second (not dps) =*PI/180
-		double gyroscale = DEG2RAD(this->DataGyroscope.FullScale);
-		double gx = gyroscale * this->DataGyroscope.rawX();
-		double gy = gyroscale * this->DataGyroscope.rawY();
-		double gz = gyroscale * this->DataGyroscope.rawZ();
-		double accscale = this->DataAcceleration.FullScale;
-		double ax = accscale * this->DataAcceleration.rawX();
-		double ay = accscale * this->DataAcceleration.rawY();
-		double az = accscale * this->DataAcceleration.rawZ();
+		gx = DEG2RAD(gx);
+		gy = DEG2RAD(gy);
+		gz = DEG2RAD(gz);
 		double magscale = this->DataMagnetometer.FullScale;
 		double mx = magscale * this->DataMagnetometer.rawX();
 		double my = magscale * this->DataMagnetometer.rawY();
@@ -373,75 +871,80 @@ namespace rpiScope
 		if(0.1 < (gx+gy+gz))
 		{
 			//	2dps=0.035rps, 10dps=0.175rps
-			Madgwick::beta = 0.001;
+			this->AHRS.SetGain(0.001);
 		}
 		else //if(0.1 < (gx+gy+gz))
 		{
-			Madgwick::beta = 0.1;
+			this->AHRS.SetGain(0.1);
 		}
-		Madgwick::MadgwickAHRSupdate(gx,gy,gz, ax,ay,az, mx,my,mz );
+		this->AHRS.Update(gx,gy,gz, ax,ay,az, mx,my,mz, this->SampleTime);
 #		endif
 	}
 
 	IMU_Vector* IMU_MARGdata::Orientation(void)
 	{
+		IMU_Vector* value = new IMU_Vector();
+		this->Orientation(*value);
+		return(value);
+	}
+	IMU_Vector& IMU_MARGdata::Orientation(IMU_Vector& value)
+	{
+		if(this->SensorFusion)
+		{
+			return(this->AHRS.Euler(value));
+		}
 #		if defined(USE_MADGWICK_AHRS)
-		//	q0,q1,q2,q3 orientation quaternion
-		//float getPitch(){return atan2f(2.0f * q2 * q3 - 2.0f * q0 * q1, 2.0f * q0 * q0 + 2.0f * q3 * q3 - 1.0f);};
-		//float getRoll(){return -1.0f * asinf(2.0f * q1 * q3 + 2.0f * q0 * q2);};
-		//float getYaw(){return atan2f(2.0f * q1 * q2 - 2.0f * q0 * q3, 2.0f * q0 * q0 + 2.0f * q1 * q1 - 1.0f);};
-		double roll = std::atan2(Madgwick::q0*Madgwick::q1 + Madgwick::q2*Madgwick::q3, 0.5f - Madgwick::q1*Madgwick::q1 - Madgwick::q2*Madgwick::q2);
-		double pitch = std::asin(-2.0f * (Madgwick::q1*Madgwick::q3 - Madgwick::q0*Madgwick::q2));
-		double yaw = std::atan2(Madgwick::q1*Madgwick::q2 + Madgwick::q0*Madgwick::q3, 0.5f - Madgwick::q2*Madgwick::q2 - Madgwick::q3*Madgwick::q3);
-		roll *= (180.0L / M_PI);
-		pitch *= (180.0L / M_PI);
-		yaw *= (180.0L / M_PI);
-		return(new IMU_Vector(roll,pitch,yaw));
+		//	roll,pitch,yaw from orientation quaternion
+		return(this->AHRS.Euler(value));
 #		else
 		//	get sensor data and normalize
-		IMU_Vector* gyro = this->Gyroscope();
-		gyro->Normalize();
-		IMU_Vector* acc = this->Acceleration();
-		acc->Normalize();
+		IMU_Vector gyro;
+		this->Gyroscope(gyro).Normalize();
+		IMU_Vector acc;
+		this->Acceleration(acc).Normalize();
 		//	calculate
 		double gyroFactor = 0.95L;
-		double valX = (acc->X *(1.0-gyroFactor)) + (gyro->X *gyroFactor);
-		double valY = (acc->Y *(1.0-gyroFactor)) + (gyro->Y *gyroFactor);
-		double valZ = (acc->Z *(1.0-gyroFactor)) + (gyro->Z *gyroFactor);
+		double valX = (acc.X *(1.0-gyroFactor)) + (gyro.X *gyroFactor);
+		double valY = (acc.Y *(1.0-gyroFactor)) + (gyro.Y *gyroFactor);
+		double valZ = (acc.Z *(1.0-gyroFactor)) + (gyro.Z *gyroFactor);
 		double EulerX = atan2( valY, valZ );
 		double EulerY = -atan2( valX, sqrt( (valY*valY) + (valZ*valZ) ) );
-		IMU_Vector* value = new IMU_Vector(EulerX,EulerY,0.0, (180/M_PI) );
-		//	free buffers
-		delete(gyro);
-		delete(acc);
-		//	return
-		return(value);
+		return(value.set(EulerX,EulerY,0.0, (180/M_PI) ));
 #		endif // defined
 	}
 
 	IMU_Vector* IMU_MARGdata::Fusion3D(void)
 	{
-		//	get sensor data an d normalize
-		IMU_Vector* acc = this->Acceleration();
-		acc->Normalize();
-		IMU_Vector* gyro = this->Gyroscope();
-		gyro->Normalize();
-		IMU_Vector* mag = this->Magnetometer();
-		mag->Normalize();
+		IMU_Vector* value = new IMU_Vector();
+		this->Fusion3D(*value);
+		return(value);
+	}
+	IMU_Vector& IMU_MARGdata::Fusion3D(IMU_Vector& value)
+	{
+		if(this->SensorFusion)
+		{
+			return(this->AHRS.Euler(value));
+		}
+		//	get sensor data and normalize
+		IMU_Vector acc;
+		this->Acceleration(acc).Normalize();
+		IMU_Vector gyro;
+		this->Gyroscope(gyro).Normalize();
+		IMU_Vector mag;
+		this->Magnetometer(mag).Normalize();
 		//	Pitch&Roll Euler angle
 		double gyroFactor = 0.95L;
-		double valX = (acc->X *(1.0-gyroFactor)) + (gyro->X *gyroFactor);
-		double valY = (acc->Y *(1.0-gyroFactor)) + (gyro->Y *gyroFactor);
-		double valZ = (acc->Z *(1.0-gyroFactor)) + (gyro->Z *gyroFactor);
+		double valX = (acc.X *(1.0-gyroFactor)) + (gyro.X *gyroFactor);
+		double valY = (acc.Y *(1.0-gyroFactor)) + (gyro.Y *gyroFactor);
+		double valZ = (acc.Z *(1.0-gyroFactor)) + (gyro.Z *gyroFactor);
 		double EulerPitch = std::atan2( valY, valZ );
 		double EulerRoll = -std::atan2( valX, std::sqrt(std::pow(valY,2) + std::pow(valZ,2)) );
 		//	Tilt compensation of Magnetometer
-		double radXH = (mag->X * std::cos(EulerPitch)) + (mag->Y * std::sin(EulerPitch) * std::sin(EulerRoll)) + (mag->Z * std::sin(EulerPitch) * std::cos(EulerRoll));
-		double radYH = (mag->Y * std::cos(EulerRoll)) + (mag->Z * std::sin(EulerRoll));
+		double radXH = (mag.X * std::cos(EulerPitch)) + (mag.Y * std::sin(EulerPitch) * std::sin(EulerRoll)) + (mag.Z * std::sin(EulerPitch) * std::cos(EulerRoll));
+		double radYH = (mag.Y * std::cos(EulerRoll)) + (mag.Z * std::sin(EulerRoll));
 		double MagYaw = std::atan2(-radYH, radXH);
 		//	done
-		IMU_Vector* value = new IMU_Vector(EulerPitch,EulerRoll, MagYaw, (180/M_PI));
-		return(value);
+		return(value.set(EulerPitch,EulerRoll, MagYaw, (180/M_PI)));
 	}
 
 };
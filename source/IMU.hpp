@@ -20,7 +20,7 @@
 **	MA 02110-1301 USA.
  */
 
-/*!	\brief	class IMU_Vector, class IMU_Data, class IMU_MARGdata
+/*!	\brief	class IMU_Vector, class IMU_Data, class IMU_AHRS, class IMU_MARGdata
  *
  *	Declaration of class, members and methods.
  *	Special vector data members and methods, for handling of IMU sensor
@@ -30,10 +30,13 @@
 #ifndef _IMU_HPP_
 #define _IMU_HPP_
 
+#include "../config.h"
+#include "SeqLock.hpp"
+
 #include <cstdlib>
 #include <cstddef>
-#include <deque>
-#include <pthread.h>
+#include <stdint.h>
+#include <atomic>
 using namespace std;
 namespace rpiScope
 {
@@ -63,14 +66,52 @@ namespace rpiScope
 		private:
 	};
 
+	typedef struct IMU_Sample
+	{
+		int16_t X;
+		int16_t Y;
+		int16_t Z;
+	}	IMU_Sample;
+
+	/*	IMU_Filter
+	 *	low pass filter stage of IMU_Data
+	 *	moving average	running sums, any window up to IMU_BUFFER_SIZE
+	 *	IIR	single pole (exponential moving average), y += alpha*(x-y)
+	 *	FIR	precomputed taps, convolution with latest samples
+	 */
+	typedef enum IMU_Filter
+	{
+		IMU_FilterMovingAverage = 0,
+		IMU_FilterIIR,
+		IMU_FilterFIR
+	}	IMU_Filter;
+	typedef struct IMU_FilterConfig
+	{
+		IMU_Filter Type;
+		size_t Window;	//	moving average window
+		double Alpha;	//	IIR coefficient (0..1]
+		size_t Taps;	//	FIR taps used
+		double Tap[IMU_FIR_MAXTAPS];	//	FIR taps, Tap[0] weights latest sample
+	}	IMU_FilterConfig;
+
+	/*	IMU_Data
+	 *	lock free ring buffer, one producer (Push) and any number of readers
+	 *	the producer runs the filter stage and publishes the filtered value,
+	 *	so reading is O(1) and never blocks the producer
+	 */
 	class IMU_Data
 	{
 		friend class IMU_MARGdata;
 		public:
 			IMU_Data();
 			~IMU_Data();
-			void LPF_resize(size_t LPFValues);
+			void LPF_resize(size_t LPFValues);	//	moving average filter, window of LPFValues samples
+			void LPF_IIR(double alpha);	//	single pole IIR filter
+			bool LPF_FIR(const double* taps, size_t count);	//	FIR filter, false if too many taps
+			IMU_FilterConfig LPF_config(void) const;	//	filter requested last
+			static size_t LPF_lowpass(double* taps, size_t count, double cutoff);	//	windowed sinc taps, cutoff relative to sample rate
 			IMU_Vector* vector(void);
+			IMU_Vector& vector(IMU_Vector& value);	//	fill value, without allocation
 			int16_t rawX(void);
 			double scaledX(void);
 			int16_t rawY(void);
@@ -78,37 +119,135 @@ namespace rpiScope
 			int16_t rawZ(void);
 			double scaledZ(void);
 			void	Push(int16_t X, int16_t Y, int16_t Z);
+			size_t	Read(IMU_Sample* samples, size_t maxsamples, uint64_t& position);	//	copy samples pushed since position, advances position
+			uint64_t	Pushed(void) const;	//	number of samples pushed
+			//	count raw XYZ register triples (6 bytes each) to scaled X,Y,Z arrays, SSE2/NEON if available
+			static size_t	Convert(const unsigned char* raw, size_t count, bool bigendian, float scale, float* X, float* Y, float* Z);
+			size_t	Convert(const unsigned char* raw, size_t count, bool bigendian, float* X, float* Y, float* Z) const;	//	scaled by FullScale
 		protected:
-			size_t LPF_MaxValues;
-			std::deque<IMU_Vector> LPF_Values;
-			pthread_mutex_t pthread_mutex;
-			void InitMutex(void);
-			void DestroyMutex(void);
+			typedef struct IMU_Output
+			{
+				double X;	//	filtered value
+				double Y;
+				double Z;
+				IMU_Sample Last;	//	latest raw sample
+			}	IMU_Output;
+			void LPF_apply(uint64_t head);
+			void LPF_request(const IMU_FilterConfig& config);
+			//	filter requested by LPF_(...), applied with next Push
+			SeqLock<IMU_FilterConfig> LPF_Pending;
+			std::atomic_flag LPF_Writing;	//	serializes LPF_(...) callers
 			double FullScale;
+			//	producer data
+			alignas(64) std::atomic<uint64_t> Head;	//	samples pushed, next ring position
+			IMU_FilterConfig LPF_Active;	//	filter in use
+			unsigned long LPF_Version;	//	version of LPF_Pending in use
+			size_t LPF_MaxValues;	//	window of moving average
+			int64_t SumX;	//	running sums of window
+			int64_t SumY;
+			int64_t SumZ;
+			size_t Count;	//	samples in window
+			double StateX;	//	IIR filter state
+			double StateY;
+			double StateZ;
+			alignas(64) IMU_Sample Ring[IMU_BUFFER_SIZE];
+			//	published to readers
+			alignas(64) SeqLock<IMU_Output> Output;
+		private:
+	};
+
+	/*	IMU_AHRS
+	 *	Madgwick AHRS filter (http://www.x-io.co.uk/node/8), state owned by instance
+	 *	one thread updates, any thread reads the published quaternion
+	 *	integration step from sample time stamps, SampleRate only until two time stamps are known
+	 */
+	class IMU_AHRS
+	{
+		public:
+			IMU_AHRS(double rate=512.0, double gain=0.1);
+			~IMU_AHRS();
+			void Reset(void);
+			void SetSampleRate(double rate);	//	Hz, used without time stamps
+			void SetGain(double gain);	//	2 * proportional gain (beta)
+			double GetGain(void) const;
+			//	gyroscope rad/s, accelerometer and magnetometer any unit, time stamp in micro seconds (0 for none)
+			void Update(double gx, double gy, double gz, double ax, double ay, double az, double mx, double my, double mz, uint64_t timestamp);
+			void Set(double q0, double q1, double q2, double q3, uint64_t timestamp);	//	quaternion fused by sensor, replaces filter state
+			void Quaternion(double& q0, double& q1, double& q2, double& q3) const;
+			IMU_Vector& Euler(IMU_Vector& value) const;	//	roll,pitch,yaw in degrees
+			uint64_t Updates(void) const;
+		protected:
+			typedef struct IMU_Quaternion
+			{
+				double Q0;
+				double Q1;
+				double Q2;
+				double Q3;
+				uint64_t Updates;
+			}	IMU_Quaternion;
+			void UpdateIMU(double gx, double gy, double gz, double ax, double ay, double az, double dt);
+			void UpdateMARG(double gx, double gy, double gz, double ax, double ay, double az, double mx, double my, double mz, double dt);
+			double SampleRate;
+			double Gain;
+			uint64_t LastTime;	//	time stamp of last update
+			IMU_Quaternion State;	//	updating thread
+			SeqLock<IMU_Quaternion> Published;	//	readers
 		private:
 	};
 
+	/*	IMU_MARGdata
+	 *	magnetometer, acceleration and gyroscope of one sensor, fused by IMU_AHRS on the host
+	 *	with orientation fused by the sensor (BNO055 NDOF, PushQuaternion):
+	 *	Acceleration	gravity vector of the sensor fusion
+	 *	LinearAcceleration	acceleration without gravity
+	 *	Gyroscope, Magnetometer	not updated, keep their last values (zero if never pushed)
+	 */
 	class IMU_MARGdata
 	{
 		public:
 			IMU_MARGdata(size_t LPFValues=1);
 			~IMU_MARGdata();
 			void LPF_resize(size_t LPFValues);
+			void LPF_IIR(double alpha);
+			bool LPF_FIR(const double* taps, size_t count);
 			IMU_Vector* Magnetometer(void);
 			IMU_Vector* Acceleration(void);
 			IMU_Vector* Gyroscope(void);
+			IMU_Vector* LinearAcceleration(void);
+			//	fill value, without allocation
+			IMU_Vector& Magnetometer(IMU_Vector& value);
+			IMU_Vector& Acceleration(IMU_Vector& value);
+			IMU_Vector& Gyroscope(IMU_Vector& value);
+			IMU_Vector& LinearAcceleration(IMU_Vector& value);
 			void PushMagnetometer(int16_t X, int16_t Y, int16_t Z);
 			void PushAcceleration(int16_t X, int16_t Y, int16_t Z);
+			void PushLinearAcceleration(int16_t X, int16_t Y, int16_t Z);	//	sensor fusion only, same full scale as acceleration
 			void PushGyroscope(int16_t X, int16_t Y, int16_t Z);
+			void PushQuaternion(double q0, double q1, double q2, double q3);	//	orientation fused by sensor (BNO055 NDOF), instead of MadgwickAHRSupdate
 			void SetFullScale(double gyro, double acc, double mag);
-			void MadgwickAHRSupdate(void);
+			void GetFullScale(double& gyro, double& acc, double& mag) const;
+			//	batch conversion of raw register triples, see IMU_Data::Convert
+			size_t ConvertMagnetometer(const unsigned char* raw, size_t count, bool bigendian, float* X, float* Y, float* Z) const;
+			size_t ConvertAcceleration(const unsigned char* raw, size_t count, bool bigendian, float* X, float* Y, float* Z) const;
+			size_t ConvertGyroscope(const unsigned char* raw, size_t count, bool bigendian, float* X, float* Y, float* Z) const;
+			void SetSampleTime(uint64_t timestamp);
+			uint64_t GetSampleTime(void);
+			void SetSampleRate(double rate);
+			void MadgwickAHRSupdate(void);	//	latest filtered values
+			void MadgwickAHRSupdate(double gx, double gy, double gz, double ax, double ay, double az);	//	gyroscope dps, acceleration g, filtered magnetometer
 			//	get calculated values
 			IMU_Vector* Orientation(void);
 			IMU_Vector* Fusion3D(void);
+			IMU_Vector& Orientation(IMU_Vector& value);
+			IMU_Vector& Fusion3D(IMU_Vector& value);
 		protected:
 			IMU_Data DataMagnetometer;
 			IMU_Data DataAcceleration;
 			IMU_Data DataGyroscope;
+			IMU_Data DataLinearAcceleration;	//	sensor fusion output, gravity removed
+			IMU_AHRS AHRS;	//	Madgwick filter of this sensor
+			uint64_t SampleTime;	//	time stamp of latest sample (CLOCK_MONOTONIC micro seconds)
+			bool SensorFusion;	//	quaternion pushed by sensor, Orientation and Fusion3D from AHRS
 		private:
 	};
 
@@ -0,0 +1,324 @@
+/*	IMUreplay
+ *	offline fusion of recorded IMU sample logs, faster than real time
+ */
+
+#include "MACROS.h"
+#include "IMUreplay.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <cmath>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+using namespace std;
+namespace rpiScope
+{
+
+	IMU_Replay::IMU_Replay()
+		: Fusion(IMU_ReplayMadgwick), Gain(0.1), LPFValues(1), Threads(0), Warmup(0), threadsused(0), samplespersecond(0.0)
+		, mapping(NULL), mappingsize(0), header(NULL), records(NULL), samples(0)
+	{
+	}
+	IMU_Replay::~IMU_Replay()
+	{
+		this->Close();
+	}
+
+	bool IMU_Replay::Open(const char* logfile)
+	{
+		this->Close();
+		int fd = open(logfile, O_RDONLY);
+		if(0 > fd)
+		{
+			perror("IMU_Replay opening log failed");
+			return(false);
+		}
+		struct stat status;
+		if(0 != fstat(fd, &status) || (off_t)sizeof(IMU_LogHeader) > status.st_size)
+		{
+			errno = EINVAL;
+			perror("IMU_Replay log without header");
+			close(fd);
+			return(false);
+		}
+		void* mapping = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if(MAP_FAILED == mapping)
+		{
+			perror("IMU_Replay mapping log failed");
+			return(false);
+		}
+		const IMU_LogHeader* header = (const IMU_LogHeader*)mapping;
+		if(0 != memcmp(&header->Magic[0], IMU_LOG_MAGIC, sizeof(IMU_LOG_MAGIC)) || sizeof(IMU_LogRecord) != header->RecordSize)
+		{
+			errno = EINVAL;
+			perror("IMU_Replay unknown log format");
+			munmap(mapping, status.st_size);
+			return(false);
+		}
+		//	read once from begin to end
+		madvise(mapping, status.st_size, MADV_SEQUENTIAL);
+		this->mapping = mapping;
+		this->mappingsize = status.st_size;
+		this->header = header;
+		this->records = (const IMU_LogRecord*)((const char*)mapping + sizeof(IMU_LogHeader));
+		this->samples = (status.st_size - sizeof(IMU_LogHeader)) / sizeof(IMU_LogRecord);
+		return(true);
+	}
+	void IMU_Replay::Close(void)
+	{
+		if(NULL != this->mapping)
+		{
+			munmap(this->mapping, this->mappingsize);
+		}
+		this->mapping = NULL;
+		this->mappingsize = 0;
+		this->header = NULL;
+		this->records = NULL;
+		this->samples = 0;
+	}
+	size_t IMU_Replay::Samples(void) const
+	{
+		return(this->samples);
+	}
+	const IMU_LogRecord* IMU_Replay::Records(void) const
+	{
+		return(this->records);
+	}
+	const IMU_LogHeader* IMU_Replay::Header(void) const
+	{
+		return(this->header);
+	}
+
+	void IMU_Replay::SetFusion(IMU_ReplayFusion fusion)
+	{
+		this->Fusion = fusion;
+	}
+	void IMU_Replay::SetGain(double gain)
+	{
+		this->Gain = gain;
+	}
+	void IMU_Replay::SetLPF(size_t LPFValues)
+	{
+		this->LPFValues = LPFValues;
+	}
+	void IMU_Replay::SetThreads(int threads)
+	{
+		this->Threads = threads;
+	}
+	void IMU_Replay::SetWarmup(size_t samples)
+	{
+		this->Warmup = samples;
+	}
+
+	size_t IMU_Replay::Run(IMU_Vector* orientation)
+	{
+		if(NULL == this->records || 0 == this->samples)
+		{
+			return(0);
+		}
+		size_t threads = (0 < this->Threads ?this->Threads :sysconf(_SC_NPROCESSORS_ONLN));
+		//	shards not shorter than warm-up
+		if(0 < this->Warmup && threads > this->samples / this->Warmup)
+			threads = this->samples / this->Warmup;
+		if(threads > this->samples)
+			threads = this->samples;
+		if(1 > threads)
+			threads = 1;
+		IMU_ReplayShard* shards = new IMU_ReplayShard[threads];
+		pthread_t* thread = new pthread_t[threads];
+		for(size_t shard=0; threads>shard; ++shard)
+		{
+			shards[shard].replay = this;
+			shards[shard].begin = this->samples * shard / threads;
+			shards[shard].end = this->samples * (shard +1) / threads;
+			shards[shard].warmup = (shards[shard].begin > this->Warmup ?shards[shard].begin -this->Warmup :0);
+			shards[shard].orientation = orientation;
+		}
+		struct timespec start, stop;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		//	first shard in calling thread
+		size_t started = 1;
+		for(; threads>started; ++started)
+		{
+			if(0 != pthread_create(&thread[started], NULL, IMU_Replay::pthread_shard, &shards[started]))
+			{
+				perror("IMU_Replay thread creation failed");
+				break;
+			}
+		}
+		this->Fuse(shards[0]);
+		for(size_t shard=1; started>shard; ++shard)
+		{
+			pthread_join(thread[shard], NULL);
+		}
+		//	shards without thread
+		for(size_t shard=started; threads>shard; ++shard)
+		{
+			this->Fuse(shards[shard]);
+		}
+		clock_gettime(CLOCK_MONOTONIC, &stop);
+		double elapsed = (stop.tv_sec - start.tv_sec) + (stop.tv_nsec - start.tv_nsec) /1e9;
+		this->samplespersecond = (0.0 < elapsed ?this->samples / elapsed :0.0);
+		this->threadsused = started;
+		delete[](shards);
+		delete[](thread);
+		return(this->samples);
+	}
+	double IMU_Replay::SamplesPerSecond(void) const
+	{
+		return(this->samplespersecond);
+	}
+	int IMU_Replay::ThreadsUsed(void) const
+	{
+		return(this->threadsused);
+	}
+
+	void* IMU_Replay::pthread_shard(void* arg)
+	{
+		IMU_ReplayShard* shard = (IMU_ReplayShard*)arg;
+		shard->replay->Fuse(*shard);
+		return(NULL);
+	}
+	void IMU_Replay::Fuse(const IMU_ReplayShard& shard)
+	{
+		//	filter state of this shard
+		IMU_MARGdata marg(this->LPFValues);
+		marg.SetFullScale(this->header->FullScaleGyroscope, this->header->FullScaleAcceleration, this->header->FullScaleMagnetometer);
+		marg.SetSampleRate(this->header->SampleRate);
+		IMU_AHRS ahrs(this->header->SampleRate, this->Gain);
+		//	Madgwick needs gyroscope in radian per second
+		double gyroscale = this->header->FullScaleGyroscope * M_PI / 180.0;
+		double accscale = this->header->FullScaleAcceleration;
+		double magscale = this->header->FullScaleMagnetometer;
+		IMU_Vector value;
+		for(size_t pos=shard.warmup; shard.end>pos; ++pos)
+		{
+			const IMU_LogRecord& record = this->records[pos];
+			bool output = (NULL != shard.orientation && shard.begin <= pos);
+			if(IMU_ReplayMadgwick == this->Fusion)
+			{
+				ahrs.Update(gyroscale * record.Gyroscope.X, gyroscale * record.Gyroscope.Y, gyroscale * record.Gyroscope.Z
+					, accscale * record.Acceleration.X, accscale * record.Acceleration.Y, accscale * record.Acceleration.Z
+					, magscale * record.Magnetometer.X, magscale * record.Magnetometer.Y, magscale * record.Magnetometer.Z
+					, record.Timestamp);
+				if(output)
+				{
+					ahrs.Euler(shard.orientation[pos]);
+				}
+				continue;
+			}
+			marg.SetSampleTime(record.Timestamp);
+			marg.PushGyroscope(record.Gyroscope.X, record.Gyroscope.Y, record.Gyroscope.Z);
+			marg.PushAcceleration(record.Acceleration.X, record.Acceleration.Y, record.Acceleration.Z);
+			if(0 == (record.Flags & IMU_LOG_MAGNETOMETER_HELD))
+			{
+				//	pushed once per reading, like the reading thread did
+				marg.PushMagnetometer(record.Magnetometer.X, record.Magnetometer.Y, record.Magnetometer.Z);
+			}
+			if(IMU_ReplayOrientation == this->Fusion)
+			{
+				marg.MadgwickAHRSupdate();
+				marg.Orientation(value);
+			}
+			else
+			{
+				marg.Fusion3D(value);
+			}
+			if(output)
+			{
+				//	in degrees
+				shard.orientation[pos].set(value.scaledX(), value.scaledY(), value.scaledZ(), 1.0);
+			}
+		}
+	}
+
+	bool IMU_Replay::Write(const char* logfile, const IMU_LogHeader& header, const IMU_LogRecord* records, size_t count)
+	{
+		FILE* log = fopen(logfile, "wb");
+		if(NULL == log)
+		{
+			perror("IMU_Replay creating log failed");
+			return(false);
+		}
+		IMU_LogHeader value = header;
+		memcpy(&value.Magic[0], IMU_LOG_MAGIC, sizeof(IMU_LOG_MAGIC));
+		value.RecordSize = sizeof(IMU_LogRecord);
+		bool written = (1 == fwrite(&value, sizeof(value), 1, log) && count == fwrite(records, sizeof(IMU_LogRecord), count, log));
+		if(0 != fclose(log) || !written)
+		{
+			perror("IMU_Replay writing log failed");
+			return(false);
+		}
+		return(true);
+	}
+
+	IMU_Recorder::IMU_Recorder()
+		: log(NULL), records(0)
+	{
+	}
+	IMU_Recorder::~IMU_Recorder()
+	{
+		this->Close();
+	}
+	bool IMU_Recorder::Open(const char* logfile, const IMU_LogHeader& header)
+	{
+		this->Close();
+		FILE* log = fopen(logfile, "wb");
+		if(NULL == log)
+		{
+			perror("IMU_Recorder creating log failed");
+			return(false);
+		}
+		IMU_LogHeader value = header;
+		memcpy(&value.Magic[0], IMU_LOG_MAGIC, sizeof(IMU_LOG_MAGIC));
+		value.RecordSize = sizeof(IMU_LogRecord);
+		if(1 != fwrite(&value, sizeof(value), 1, log))
+		{
+			perror("IMU_Recorder writing header failed");
+			fclose(log);
+			return(false);
+		}
+		this->records.store(0, std::memory_order_relaxed);
+		this->log = log;
+		return(true);
+	}
+	void IMU_Recorder::Close(void)
+	{
+		if(NULL != this->log && 0 != fclose(this->log))
+		{
+			perror("IMU_Recorder writing log failed");
+		}
+		this->log = NULL;
+	}
+	bool IMU_Recorder::Opened(void) const
+	{
+		return(NULL != this->log);
+	}
+	void IMU_Recorder::Append(const IMU_LogRecord& record)
+	{
+		if(NULL == this->log)
+		{
+			return;
+		}
+		if(1 != fwrite(&record, sizeof(record), 1, this->log))
+		{
+			perror("IMU_Recorder appending record failed");
+			return;
+		}
+		this->records.fetch_add(1, std::memory_order_relaxed);
+	}
+	size_t IMU_Recorder::Records(void) const
+	{
+		return(this->records.load(std::memory_order_relaxed));
+	}
+
+};
@@ -0,0 +1,152 @@
+/*	IMUreplay
+ *	offline fusion of recorded IMU sample logs, faster than real time
+**
+**	piScope project https://github.com/march42/piScope
+**	(C) Copyright 2017 by Marc Hefter
+**
+**	This program is free software; you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation; either version 3 of the License, or
+**	(at your option) any later version.
+**
+**	This program is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with this program; if not, write to the Free Software
+**	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+**	MA 02110-1301 USA.
+ */
+
+/*!	\brief	class IMU_Replay, class IMU_Recorder
+ *
+ *	Declaration of class, members and methods.
+ *	Binary IMU log (IMU_LogHeader followed by IMU_LogRecord samples) is
+ *	mapped into memory and fed through IMU_MARGdata and IMU_AHRS. Long logs
+ *	are split into shards, one thread each, every shard starts with a warm-up
+ *	window of the preceding samples to converge the filter state.
+ *	IMU_Recorder appends the samples of a reading thread to such a log.
+ */
+
+#ifndef _IMUREPLAY_HPP_
+#define _IMUREPLAY_HPP_
+
+#include "../config.h"
+#include "IMU.hpp"
+
+#include <cstdlib>
+#include <cstddef>
+#include <cstdio>
+#include <stdint.h>
+#include <atomic>
+
+#define IMU_LOG_MAGIC "IMULOG1"
+//	IMU_LogRecord Flags
+#define IMU_LOG_FIFO 0x0001	//	sample from FIFO slot, time stamp reconstructed
+#define IMU_LOG_MAGNETOMETER_HELD 0x0002	//	magnetometer repeated from earlier record, not read with this sample
+#define IMU_LOG_OVERRUN 0x0004	//	samples lost before this record
+
+using namespace std;
+namespace rpiScope
+{
+
+	typedef struct IMU_LogHeader
+	{
+		char Magic[8];	//	IMU_LOG_MAGIC
+		uint32_t RecordSize;	//	sizeof(IMU_LogRecord)
+		uint32_t Reserved;
+		double SampleRate;	//	nominal rate in Hz
+		double FullScaleGyroscope;	//	dps per LSB
+		double FullScaleAcceleration;	//	g per LSB
+		double FullScaleMagnetometer;	//	gauss per LSB
+	}	IMU_LogHeader;
+	typedef struct IMU_LogRecord
+	{
+		uint64_t Timestamp;	//	CLOCK_MONOTONIC micro seconds
+		IMU_Sample Gyroscope;
+		IMU_Sample Acceleration;
+		IMU_Sample Magnetometer;
+		uint16_t Flags;	//	IMU_LOG_(...)
+		uint32_t Reserved;
+	}	IMU_LogRecord;
+
+	typedef enum IMU_ReplayFusion
+	{
+		IMU_ReplayMadgwick = 0,	//	IMU_AHRS, raw samples
+		IMU_ReplayOrientation,	//	IMU_MARGdata::Orientation, low pass filtered
+		IMU_ReplayFusion3D	//	IMU_MARGdata::Fusion3D, low pass filtered
+	}	IMU_ReplayFusion;
+
+	class IMU_Replay
+	{
+		public:
+			IMU_Replay();
+			~IMU_Replay();
+			bool Open(const char* logfile);	//	map log into memory
+			void Close(void);
+			size_t Samples(void) const;
+			const IMU_LogHeader* Header(void) const;
+			const IMU_LogRecord* Records(void) const;
+			//	configuration, before Run
+			void SetFusion(IMU_ReplayFusion fusion);
+			void SetGain(double gain);	//	Madgwick beta
+			void SetLPF(size_t LPFValues);	//	IMU_MARGdata moving average window
+			void SetThreads(int threads);	//	0 for number of online CPUs
+			void SetWarmup(size_t samples);	//	samples fused before each shard, without output
+			//	fuse all samples, orientation (roll,pitch,yaw degrees) per sample if not NULL
+			size_t Run(IMU_Vector* orientation=NULL);
+			double SamplesPerSecond(void) const;	//	of last Run
+			int ThreadsUsed(void) const;	//	of last Run
+			//	write log file
+			static bool Write(const char* logfile, const IMU_LogHeader& header, const IMU_LogRecord* records, size_t count);
+		protected:
+			typedef struct IMU_ReplayShard
+			{
+				IMU_Replay* replay;
+				size_t begin;	//	first sample with output
+				size_t end;
+				size_t warmup;	//	first sample fused
+				IMU_Vector* orientation;
+			}	IMU_ReplayShard;
+			static void* pthread_shard(void* arg);
+			void Fuse(const IMU_ReplayShard& shard);
+			IMU_ReplayFusion Fusion;
+			double Gain;
+			size_t LPFValues;
+			int Threads;
+			size_t Warmup;
+			int threadsused;
+			double samplespersecond;
+			//	mapped log
+			void* mapping;
+			size_t mappingsize;
+			const IMU_LogHeader* header;
+			const IMU_LogRecord* records;
+			size_t samples;
+		private:
+	};
+
+	/*	IMU_Recorder
+	 *	appends IMU_LogRecord samples to a log, written by one reading thread only
+	 *	records are buffered by stdio, Close flushes them
+	 */
+	class IMU_Recorder
+	{
+		public:
+			IMU_Recorder();
+			~IMU_Recorder();
+			bool Open(const char* logfile, const IMU_LogHeader& header);	//	create log and write header
+			void Close(void);
+			bool Opened(void) const;
+			void Append(const IMU_LogRecord& record);
+			size_t Records(void) const;	//	appended since Open
+		protected:
+			FILE* log;
+			std::atomic<size_t> records;
+		private:
+	};
+
+};
+#endif	/* _IMUREPLAY_HPP_ */
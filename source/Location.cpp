@@ -22,19 +22,21 @@
 */
 
 #include "Location.hpp"
+#include "AstroTime.hpp"
+#include "MACROS.h"
 
 //#include <unistd.h>
 #include <cstdio>
 //#include <cstdlib>
 #include <cstring>
-//#include <cmath>
+#include <cmath>
 #include <cassert>
 
 namespace piScope
 {
 
 	MHLocation::MHLocation(MHLocation* loc)
-		: MHVector3D((MHVector3D*)loc)
+		: MHVector3D((MHVector3D*)loc), SiderealRefreshing(false), LocationGeneration(0)
 	{
 		if(NULL != loc->Name)
 		{
@@ -47,12 +49,14 @@ namespace piScope
 		assert(this->Y == loc->Y);
 		assert(this->Z == loc->Z);
 		assert(this->Length == loc->Length);
+		this->LocationChanged();
 	}
 	MHLocation::MHLocation(double lat, double lon, double height, const char* name)
-		: MHVector3D(VectorType_LATLON, lat, lon, height, 1.0), Name(NULL)
+		: MHVector3D(VectorType_LATLON, lat, lon, height, 1.0), Name(NULL), SiderealRefreshing(false), LocationGeneration(0)
 	{
 		this->SetName(name);	//	set name, if given
 		this->Validate();
+		this->LocationChanged();
 	}
 	MHLocation::~MHLocation()
 	{
@@ -68,6 +72,7 @@ namespace piScope
 		this->Length = 1.0L;
 		this->SetName(name);
 		this->Validate();	//	just, to be sure
+		this->LocationChanged();
 		return(this);
 	}
 	const char* MHLocation::SetName(const char* name)
@@ -116,4 +121,74 @@ namespace piScope
 		return(NULL==this->Name ?NULLRETURN :this->Name);
 	}
 
+	void MHLocation::LocationChanged(void)
+	{
+		//	longitude changed, anchors invalid, new generation before taking guard (refreshs of old longitude are not published)
+		unsigned long generation = this->LocationGeneration.fetch_add(1, std::memory_order_acq_rel) +1;
+		MHSiderealAnchor invalid = { 0, 0, 0.0, 0.0, generation };
+		//	single writer of SeqLock, wait for a refresh publishing meanwhile (holds guard for one Write only)
+		while(this->SiderealRefreshing.exchange(true, std::memory_order_acquire))
+		{
+		}
+		this->SiderealCache.Write(invalid);
+		this->SiderealRefreshing.store(false, std::memory_order_release);
+		/*	horizon (x=east, y=north, z=up) to local equator
+		**	x = equator on meridian (hour angle 0), y = east (hour angle -6h), z = celestial pole
+		*/
+		double sinlat = sin(DEG2RAD(this->GetLatitude()));
+		double coslat = cos(DEG2RAD(this->GetLatitude()));
+		this->Horizon2Equator = MHRotation(0,-sinlat,coslat, 1,0,0, 0,coslat,sinlat);
+	}
+	const MHRotation& MHLocation::GetHorizon2Equator(void) const
+	{
+		return(this->Horizon2Equator);
+	}
+
+	double MHLocation::GetAngleLMST(int64_t ns) const
+	{
+		MHSiderealAnchor anchor;
+		this->SiderealCache.Read(anchor);
+		int64_t offset = ns - anchor.Origin;
+		if(0 > offset || anchor.Span <= offset || anchor.Generation != this->LocationGeneration.load(std::memory_order_acquire))
+		{
+			//	time left cached span or location changed, refresh lazily
+			anchor = this->SiderealRefresh(ns);
+			offset = ns - anchor.Origin;
+		}
+		//	anchor below 360 plus less than one span, one subtraction wraps
+		double angle = anchor.Angle + (anchor.Rate * (double)offset);
+		return(FULLCIRCLE_DEGREE <= angle ?angle - FULLCIRCLE_DEGREE :angle);
+	}
+	MHSiderealAnchor MHLocation::SiderealRefresh(int64_t ns) const
+	{
+		MHSiderealAnchor anchor;
+		anchor.Generation = this->LocationGeneration.load(std::memory_order_acquire);	//	before reading longitude
+		anchor.Span = (int64_t)SIDEREAL_CACHE_SPAN * TIME_NSPERSECOND;
+		//	anchors aligned to span, so all threads calculate the same ones
+		anchor.Origin = ns - (ns % anchor.Span);
+		if(ns < anchor.Origin)
+		{
+			anchor.Origin -= anchor.Span;
+		}
+		anchor.Angle = MHAstroTime::AngleGMST(anchor.Origin) + this->GetLongitude();
+		anchor.Angle = DEGREE_WRAP(anchor.Angle);
+		double end = MHAstroTime::AngleGMST(anchor.Origin + anchor.Span) + this->GetLongitude() - anchor.Angle;
+		anchor.Rate = DEGREE_WRAP(end) / anchor.Span;
+		//	single writer, others use their own anchor without publishing
+		if(!this->SiderealRefreshing.exchange(true, std::memory_order_acquire))
+		{
+			//	location changed meanwhile, anchors of old longitude not published
+			if(anchor.Generation == this->LocationGeneration.load(std::memory_order_acquire))
+			{
+				this->SiderealCache.Write(anchor);
+			}
+			this->SiderealRefreshing.store(false, std::memory_order_release);
+		}
+		return(anchor);
+	}
+	unsigned long MHLocation::GetSiderealRefreshs(void) const
+	{
+		return(this->SiderealCache.Version());
+	}
+
 };
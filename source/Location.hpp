@@ -26,6 +26,8 @@
  *	Declaration of class, members and methods.
  *	Special vector data definition and calculation methods for location data.
  *	Specializes Vector3D for Latitude, Longitude and Height.
+ *	Caches Local Mean Sidereal Time as exact anchors every SIDEREAL_CACHE_SPAN seconds
+ *	and the rotation from horizon (east, north, up) to local equator (hour angle, declination).
  */
 
 #ifndef _LOCATION_HPP_
@@ -33,12 +35,25 @@
 
 #	include "../config.h"
 #	include "Vector3D.hpp"
+#	include "SeqLock.hpp"
+#	include "Rotation.hpp"
 
 #	include <unistd.h>
+#	include <stdint.h>
+#	include <atomic>
 
 namespace piScope
 {
 
+	typedef struct MHSiderealAnchor
+	{
+		int64_t Origin;	/*!< nano seconds since J2000.0 of first anchor */
+		int64_t Span;	/*!< nano seconds to second anchor, 0 = invalid */
+		double Angle;	/*!< LMST at first anchor, degrees */
+		double Rate;	/*!< LMST degrees per nano second between anchors */
+		unsigned long Generation;	/*!< location generation the anchors were calculated for */
+	}	MHSiderealAnchor;
+
 	class MHLocation : public MHVector3D
 	{
 	private:	/* private members are accessible only from within the same class or "friends" */
@@ -50,6 +65,12 @@ namespace piScope
 		*/
 
 	protected:	/* protected members are accessible from the same class or "friends" and derived classes */
+		mutable rpiScope::SeqLock<MHSiderealAnchor> SiderealCache;	/*!< LMST anchors, readers never wait */
+		mutable std::atomic<bool> SiderealRefreshing;	/*!< guard of SiderealCache writer, refreshing threads skip publishing, LocationChanged waits */
+		std::atomic<unsigned long> LocationGeneration;	/*!< incremented by LocationChanged, anchors of other generations are stale */
+		MHSiderealAnchor SiderealRefresh(int64_t ns) const;	/*!< calculate exact anchors around time stamp */
+		MHRotation Horizon2Equator;	/*!< rotation by latitude, east/north/up to meridian/east/celestial pole */
+		void LocationChanged(void);	/*!< recalculate cached values after latitude/longitude changed */
 
 	public:	/* public members are accessible from anywhere */
 		//	constructor/destructor
@@ -68,6 +89,9 @@ namespace piScope
 		double GetLongitude(void) const;	/*!< get locations longitude */
 		double GetHeight(void) const;	/*!< get locations height above mean sea level */
 		const char* GetName(const char* NULLRETURN="UNNAMED") const;	/*!< get locations Name */
+		double GetAngleLMST(int64_t ns) const;	/*!< get Local Mean Sidereal angle in degrees at nano seconds since J2000.0, interpolated */
+		unsigned long GetSiderealRefreshs(void) const;	/*!< get number of anchor calculations */
+		const MHRotation& GetHorizon2Equator(void) const;	/*!< get rotation from horizon to local equator */
 	};
 
 };
@@ -149,7 +149,7 @@ namespace piScope
 		{
 			va_list args;
 			va_start(args, format);
-			char message[200] = {0};
+			char message[400] = {0};
 			written = std::snprintf(&message[0],sizeof(message), "%s:\t%s\t", this->TimeStamp(), &this->NAME[0]);
 			written += vsnprintf(&message[written],sizeof(message)-written, format, args);
 			va_end(args);
@@ -158,5 +158,26 @@ namespace piScope
 		}
 		return(written);
 	}
+	int MHLogFile::printMetrics(int level, const char* name, const rpiScope::Metrics_Loop& metrics)
+	{
+		if(level > this->LOGLEVEL)
+		{
+			return(0);
+		}
+		rpiScope::Metrics_LoopSnapshot snapshot;
+		metrics.Snapshot(snapshot);
+		char line[300];
+		int written = this->printLog(level, "%s:\treads=%llu failures=%llu missed=%llu\n", name
+			, (unsigned long long)snapshot.Reads, (unsigned long long)snapshot.Failures, (unsigned long long)snapshot.Missed);
+		rpiScope::Metrics_Loop::Format("read[ns]", snapshot.ReadDuration, &line[0], sizeof(line));
+		written += this->printLog(level, "%s:\t%s\n", name, &line[0]);
+		rpiScope::Metrics_Loop::Format("period[ns]", snapshot.LoopPeriod, &line[0], sizeof(line));
+		written += this->printLog(level, "%s:\t%s\n", name, &line[0]);
+		rpiScope::Metrics_Loop::Format("fusion[ns]", snapshot.FusionTime, &line[0], sizeof(line));
+		written += this->printLog(level, "%s:\t%s\n", name, &line[0]);
+		rpiScope::Metrics_Loop::Format("queue", snapshot.QueueDepth, &line[0], sizeof(line));
+		written += this->printLog(level, "%s:\t%s\n", name, &line[0]);
+		return(written);
+	}
 
 };
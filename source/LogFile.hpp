@@ -31,6 +31,7 @@
 #	define _LOGFILE_HPP_
 
 #	include "../config.h"
+#	include "Metrics.hpp"
 
 #	include <unistd.h>
 #	include <cstdio>
@@ -67,6 +68,7 @@ namespace piScope
 		//	output methods
 		void rotateLog(void);	/*!< set new clarification name */
 		int printLog(int level, const char * format, ... );	/*!< special printf function for log file */
+		int printMetrics(int level, const char* name, const rpiScope::Metrics_Loop& metrics);	/*!< dump snapshot of polling loop instrumentation */
 	};
 
 };
@@ -78,6 +78,8 @@
 	//	converting degree/radian
 #	define DEG2RAD(deg) ((deg) * FULLCIRCLE_RADIAN / FULLCIRCLE_DEGREE)
 #	define RAD2DEG(rad) ((rad) * FULLCIRCLE_DEGREE / FULLCIRCLE_RADIAN)
+	//	wrapping angle to 0 <= deg < 360 without loops, floor vectorizes where fmod does not
+#	define DEGREE_WRAP(deg) ((deg) - FULLCIRCLE_DEGREE * floor((deg) / FULLCIRCLE_DEGREE))
 
 	//	converting from seconds to Mean Sidereal Time hour angle (seconds per degree)
 #	define EARTH_ROTATIONSPD (EARTH_MEANSOLARDAY / EARTH_ROTATIONSIDEREAL)
@@ -126,12 +128,14 @@
 #	define J2000_EPOCH_TT (946728000)
 	//	J2000.0 epoch is January 1, 2000, 11:58:55.816 UTC (~ 12.00 GMT)
 #	define J2000_EPOCH_UTC (946727936)
+	//	JD 2451545.0 in Universal Time is January 1, 2000, 12:00:00 UT, origin of GMST formula
+#	define J2000_EPOCH_UT (946728000)
 	//	J2000.0 epoch in Julian Day format is 2451545.0
 #	define J2000_EPOCH_JD (2451545.0L)
 	//	Modified Julian Date is number of days since midnight on November 17, 1858. (=2400000.5 days after day 0 of the Julian calendar)
 #	define J2000_EPOCH_MJD (J2000_EPOCH_JD - TIME_MJDEPOCH_JD)
-	//	J2000-JulianDay = count of days since J2000.0 epoch
-#	define J2000_JULIANDAY(utc) (((utc) - J2000_EPOCH_UTC) / EARTH_SECONDSPERDAY)
+	//	J2000-JulianDay = count of days since J2000.0 epoch (UT, JD 2451545.0)
+#	define J2000_JULIANDAY(utc) (((utc) - J2000_EPOCH_UT) / (EARTH_SECONDSPERDAY * 1.0L))
 #	define J2000_JULIANCENTURY(utc) (J2000_JULIANDAY(utc) / (JULIAN_DAYSPERYEAR * 100))
 	/*	GMST and LMST with 0.1sec accuracy
 	**	GMST and LMST are no real time stamp
@@ -139,10 +143,20 @@
 	**	either on prime meridian (GMST) or observers locality
 	*/
 #	define J2000_UTC2GMST(utc) ((18.697374558L + (EARTH_JULIANDAY * J2000_JULIANDAY(utc))) * 3600.0L)
-#	define J2000_GMSTFIX(gmst) {while(EARTH_SECONDSPERDAY <= gmst) gmst -= EARTH_SECONDSPERDAY; while(0 > gmst) gmst += EARTH_SECONDSPERDAY;}
-#	define J2000_UTC2LMST(utc,lmst,lon) {for(lmst = (((18.697374558L + (EARTH_JULIANDAY * J2000_JULIANDAY(utc))) * 3600.0L) \
-						+ ((lon) * EARTH_SECONDSPERDAY / EARTH_ROTATIONSOLARDAY)); EARTH_SECONDSPERDAY <= lmst; \
-						lmst -= EARTH_SECONDSPERDAY){}; while(0 > lmst){lmst += EARTH_SECONDSPERDAY;}}
+#	define J2000_GMSTFIX(gmst) {gmst = fmod(gmst, EARTH_SECONDSPERDAY); if(0 > gmst) gmst += EARTH_SECONDSPERDAY;}
+#	define J2000_UTC2LMST(utc,lmst,lon) {lmst = fmod(((18.697374558L + (EARTH_JULIANDAY * J2000_JULIANDAY(utc))) * 3600.0L) \
+						+ ((lon) * EARTH_SECONDSPERDAY / EARTH_ROTATIONSOLARDAY), EARTH_SECONDSPERDAY); \
+						if(0 > lmst){lmst += EARTH_SECONDSPERDAY;}}
+	/*	high resolution time base
+	**	int64_t nano seconds since J2000.0 (UT), covers +-292 years without precision loss
+	**	unix time has no leap seconds, so whole days stay 86400s like UT days
+	*/
+#	define TIME_NSPERSECOND (1000000000LL)
+#	define TIME_NSPERDAY (TIME_NSPERSECOND * EARTH_SECONDSPERDAY)
+#	define J2000_UTC2NS(utc) (((int64_t)(utc) - J2000_EPOCH_UT) * TIME_NSPERSECOND)
+#	define J2000_NS2UTC(ns) ((time_t)(J2000_EPOCH_UT + (((ns) - (0 > (ns) ?TIME_NSPERSECOND -1 :0)) / TIME_NSPERSECOND)))
+#	define J2000_UNIXUS2NS(us) (((int64_t)(us) - (int64_t)J2000_EPOCH_UT * 1000000LL) * 1000LL)
+#	define J2000_NS2DAYS(ns) ((double)(ns) / TIME_NSPERDAY)
 #	define J2000_NORTHPOLE_RA(utc) (0.00L - (0.641L * J2000_JULIANCENTURY(utc)))
 #	define J2000_NORTHPOLE_DEC(utc) (90.00L - (0.557L * J2000_JULIANCENTURY(utc)))
 
@@ -0,0 +1,165 @@
+/*	Metrics
+ *	lock free counters and histograms for instrumentation of polling loops
+ */
+
+#include "MACROS.h"
+#include "Metrics.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <time.h>
+
+using namespace std;
+namespace rpiScope
+{
+
+	double Metrics_HistogramSnapshot::Mean(void) const
+	{
+		return(0 < this->Count ?(double)this->Sum / this->Count :0.0);
+	}
+	uint64_t Metrics_HistogramSnapshot::Percentile(double percent) const
+	{
+		//	bucket counts may be ahead of Count, taken without lock
+		uint64_t total = 0;
+		for(size_t index=0; METRICS_BUCKETS>index; ++index)
+			total += this->Bucket[index];
+		if(0 == total)
+		{
+			return(0);
+		}
+		uint64_t rank = (uint64_t)(percent / 100.0 * total + 0.5);
+		if(1 > rank)
+			rank = 1;
+		uint64_t counted = 0;
+		for(size_t index=0; METRICS_BUCKETS>index; ++index)
+		{
+			counted += this->Bucket[index];
+			if(counted >= rank)
+			{
+				uint64_t value = Metrics_Histogram::Lowest(index) + (Metrics_Histogram::Highest(index) - Metrics_Histogram::Lowest(index)) /2;
+				//	exact limits known
+				if(value > this->Max)
+					value = this->Max;
+				if(value < this->Min)
+					value = this->Min;
+				return(value);
+			}
+		}
+		return(this->Max);
+	}
+
+	Metrics_Histogram::Metrics_Histogram()
+	{
+		this->Reset();
+	}
+	size_t Metrics_Histogram::Index(uint64_t value)
+	{
+		if(METRICS_SUBBUCKETS > value)
+		{
+			return(value);
+		}
+		//	magnitude above sub bucket resolution, top bits select sub bucket
+		int shift = 63 - __builtin_clzll(value) - __builtin_ctz(METRICS_SUBBUCKETS);
+		return((shift +1) * METRICS_SUBBUCKETS + ((value >> shift) & (METRICS_SUBBUCKETS -1)));
+	}
+	uint64_t Metrics_Histogram::Lowest(size_t index)
+	{
+		if(METRICS_SUBBUCKETS > index)
+		{
+			return(index);
+		}
+		int shift = index / METRICS_SUBBUCKETS -1;
+		return((uint64_t)(METRICS_SUBBUCKETS + index % METRICS_SUBBUCKETS) << shift);
+	}
+	uint64_t Metrics_Histogram::Highest(size_t index)
+	{
+		if(METRICS_SUBBUCKETS > index)
+		{
+			return(index);
+		}
+		int shift = index / METRICS_SUBBUCKETS -1;
+		return(Metrics_Histogram::Lowest(index) + ((uint64_t)1 << shift) -1);
+	}
+	void Metrics_Histogram::Record(uint64_t value)
+	{
+		std::atomic<uint64_t>& bucket = this->Bucket[Metrics_Histogram::Index(value)];
+		bucket.store(bucket.load(std::memory_order_relaxed) +1, std::memory_order_relaxed);
+		this->Sum.store(this->Sum.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+		if(value < this->Min.load(std::memory_order_relaxed))
+			this->Min.store(value, std::memory_order_relaxed);
+		if(value > this->Max.load(std::memory_order_relaxed))
+			this->Max.store(value, std::memory_order_relaxed);
+		this->Count.store(this->Count.load(std::memory_order_relaxed) +1, std::memory_order_release);
+	}
+	void Metrics_Histogram::Reset(void)
+	{
+		this->Count.store(0, std::memory_order_relaxed);
+		this->Sum.store(0, std::memory_order_relaxed);
+		this->Min.store(UINT64_MAX, std::memory_order_relaxed);
+		this->Max.store(0, std::memory_order_relaxed);
+		for(size_t index=0; METRICS_BUCKETS>index; ++index)
+		{
+			this->Bucket[index].store(0, std::memory_order_relaxed);
+		}
+	}
+	void Metrics_Histogram::Snapshot(Metrics_HistogramSnapshot& snapshot) const
+	{
+		snapshot.Count = this->Count.load(std::memory_order_acquire);
+		snapshot.Sum = this->Sum.load(std::memory_order_relaxed);
+		snapshot.Min = (0 < snapshot.Count ?this->Min.load(std::memory_order_relaxed) :0);
+		snapshot.Max = this->Max.load(std::memory_order_relaxed);
+		for(size_t index=0; METRICS_BUCKETS>index; ++index)
+		{
+			snapshot.Bucket[index] = this->Bucket[index].load(std::memory_order_relaxed);
+		}
+	}
+
+	Metrics_Loop::Metrics_Loop()
+		: LastLoop(0)
+	{
+	}
+	uint64_t Metrics_Loop::Now(void)
+	{
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		return((uint64_t)now.tv_sec *1000000000 + now.tv_nsec);
+	}
+	void Metrics_Loop::Loop(uint64_t now)
+	{
+		if(0 != this->LastLoop && now > this->LastLoop)
+		{
+			this->LoopPeriod.Record(now - this->LastLoop);
+		}
+		this->LastLoop = now;
+	}
+	void Metrics_Loop::Reset(void)
+	{
+		this->Reads.Reset();
+		this->Failures.Reset();
+		this->Missed.Reset();
+		this->ReadDuration.Reset();
+		this->LoopPeriod.Reset();
+		this->FusionTime.Reset();
+		this->QueueDepth.Reset();
+		this->LastLoop = 0;
+	}
+	void Metrics_Loop::Snapshot(Metrics_LoopSnapshot& snapshot) const
+	{
+		snapshot.Reads = this->Reads.Load();
+		snapshot.Failures = this->Failures.Load();
+		snapshot.Missed = this->Missed.Load();
+		this->ReadDuration.Snapshot(snapshot.ReadDuration);
+		this->LoopPeriod.Snapshot(snapshot.LoopPeriod);
+		this->FusionTime.Snapshot(snapshot.FusionTime);
+		this->QueueDepth.Snapshot(snapshot.QueueDepth);
+	}
+	int Metrics_Loop::Format(const char* name, const Metrics_HistogramSnapshot& histogram, char* buffer, size_t size)
+	{
+		return(snprintf(buffer, size, "%s n=%llu min=%llu mean=%.0f p50=%llu p90=%llu p99=%llu p99.9=%llu max=%llu"
+			, name, (unsigned long long)histogram.Count, (unsigned long long)histogram.Min, histogram.Mean()
+			, (unsigned long long)histogram.Percentile(50.0), (unsigned long long)histogram.Percentile(90.0)
+			, (unsigned long long)histogram.Percentile(99.0), (unsigned long long)histogram.Percentile(99.9)
+			, (unsigned long long)histogram.Max));
+	}
+
+};
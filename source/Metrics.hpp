@@ -0,0 +1,134 @@
+/*	Metrics
+ *	lock free counters and histograms for instrumentation of polling loops
+**
+**	piScope project https://github.com/march42/piScope
+**	(C) Copyright 2017 by Marc Hefter
+**
+**	This program is free software; you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation; either version 3 of the License, or
+**	(at your option) any later version.
+**
+**	This program is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with this program; if not, write to the Free Software
+**	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+**	MA 02110-1301 USA.
+ */
+
+/*!	\brief	class Metrics_Histogram, Metrics_Loop
+ *
+ *	Declaration of class, members and methods.
+ *	Every counter and histogram has a single writer (the polling thread),
+ *	which only loads and stores relaxed atomics, no locked instructions.
+ *	Readers take snapshots from any thread at any time.
+ *	Histogram buckets are log-linear like HdrHistogram: values below
+ *	METRICS_SUBBUCKETS are exact, above each power of two is split into
+ *	METRICS_SUBBUCKETS linear buckets, relative error below 1/(2*SUBBUCKETS).
+ */
+
+#ifndef _METRICS_HPP_
+#define _METRICS_HPP_
+
+#include "../config.h"
+
+#include <cstdlib>
+#include <cstddef>
+#include <stdint.h>
+#include <atomic>
+
+#define METRICS_BUCKETS (64 * METRICS_SUBBUCKETS)
+
+using namespace std;
+namespace rpiScope
+{
+
+	class Metrics_Counter
+	{
+		public:
+			Metrics_Counter() : Value(0) {}
+			void Add(uint64_t count=1)	//	single writer
+			{
+				this->Value.store(this->Value.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+			}
+			uint64_t Load(void) const
+			{
+				return(this->Value.load(std::memory_order_relaxed));
+			}
+			void Reset(void)
+			{
+				this->Value.store(0, std::memory_order_relaxed);
+			}
+		protected:
+			std::atomic<uint64_t> Value;
+		private:
+	};
+
+	typedef struct Metrics_HistogramSnapshot
+	{
+		uint64_t Count;
+		uint64_t Sum;
+		uint64_t Min;
+		uint64_t Max;
+		uint64_t Bucket[METRICS_BUCKETS];
+		double Mean(void) const;
+		uint64_t Percentile(double percent) const;	//	0..100, value of bucket middle
+	}	Metrics_HistogramSnapshot;
+
+	class Metrics_Histogram
+	{
+		public:
+			Metrics_Histogram();
+			void Record(uint64_t value);	//	single writer
+			void Reset(void);
+			void Snapshot(Metrics_HistogramSnapshot& snapshot) const;
+			static size_t Index(uint64_t value);
+			static uint64_t Lowest(size_t index);	//	smallest value of bucket
+			static uint64_t Highest(size_t index);	//	largest value of bucket
+		protected:
+			std::atomic<uint64_t> Count;
+			std::atomic<uint64_t> Sum;
+			std::atomic<uint64_t> Min;
+			std::atomic<uint64_t> Max;
+			std::atomic<uint64_t> Bucket[METRICS_BUCKETS];
+		private:
+	};
+
+	typedef struct Metrics_LoopSnapshot
+	{
+		uint64_t Reads;	//	successful bus reads
+		uint64_t Failures;	//	failed polls or bus reads
+		uint64_t Missed;	//	samples lost (FIFO overrun, skipped deadlines)
+		Metrics_HistogramSnapshot ReadDuration;	//	nano seconds
+		Metrics_HistogramSnapshot LoopPeriod;	//	nano seconds
+		Metrics_HistogramSnapshot FusionTime;	//	nano seconds
+		Metrics_HistogramSnapshot QueueDepth;	//	samples
+	}	Metrics_LoopSnapshot;
+
+	class Metrics_Loop
+	{
+		public:
+			Metrics_Loop();
+			Metrics_Counter Reads;
+			Metrics_Counter Failures;
+			Metrics_Counter Missed;
+			Metrics_Histogram ReadDuration;
+			Metrics_Histogram LoopPeriod;
+			Metrics_Histogram FusionTime;
+			Metrics_Histogram QueueDepth;
+			void Loop(uint64_t now);	//	start of loop iteration, records period
+			void Reset(void);
+			void Snapshot(Metrics_LoopSnapshot& snapshot) const;
+			static uint64_t Now(void);	//	CLOCK_MONOTONIC nano seconds
+			static int Format(const char* name, const Metrics_HistogramSnapshot& histogram, char* buffer, size_t size);	//	one line summary
+		protected:
+			uint64_t LastLoop;
+		private:
+	};
+
+};
+#endif	/* _METRICS_HPP_ */
@@ -0,0 +1,199 @@
+/*	Pacer
+ *	real time configuration and absolute deadline pacing of polling threads
+ */
+
+#include "MACROS.h"
+#include "Pacer.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <sched.h>
+#include <sys/mman.h>
+
+using namespace std;
+namespace rpiScope
+{
+
+	static uint64_t Thread_Nanoseconds(const struct timespec& ts)
+	{
+		return((uint64_t)ts.tv_sec *1000000000 + ts.tv_nsec);
+	}
+
+	int Thread_Create(pthread_t* thread, pthread_attr_t* attributes, const Thread_Config& config, void *(*routine)(void*), void* arg)
+	{
+		pthread_attr_init(attributes);
+		pthread_attr_setdetachstate(attributes, PTHREAD_CREATE_JOINABLE);
+		if(config.LockMemory && 0 != mlockall(MCL_CURRENT | MCL_FUTURE))
+		{
+			perror("Thread_Create mlockall failed");
+		}
+		if(0 <= config.CPU)
+		{
+			cpu_set_t cpus;
+			CPU_ZERO(&cpus);
+			CPU_SET(config.CPU, &cpus);
+			if(0 != pthread_attr_setaffinity_np(attributes, sizeof(cpus), &cpus))
+			{
+				perror("Thread_Create setting affinity failed");
+			}
+		}
+		if(0 < config.Priority)
+		{
+			struct sched_param param;
+			memset(&param, 0x00, sizeof(param));
+			param.sched_priority = config.Priority;
+			pthread_attr_setinheritsched(attributes, PTHREAD_EXPLICIT_SCHED);
+			pthread_attr_setschedpolicy(attributes, SCHED_FIFO);
+			pthread_attr_setschedparam(attributes, &param);
+		}
+		int rc = pthread_create(thread, attributes, routine, arg);
+		if(EPERM == rc && 0 < config.Priority)
+		{
+			//	no CAP_SYS_NICE or RLIMIT_RTPRIO, run with default scheduling
+			errno = rc;
+			perror("Thread_Create SCHED_FIFO not permitted");
+			pthread_attr_setinheritsched(attributes, PTHREAD_INHERIT_SCHED);
+			rc = pthread_create(thread, attributes, routine, arg);
+		}
+		if(EINVAL == rc && 0 <= config.CPU)
+		{
+			//	CPU not available
+			errno = rc;
+			perror("Thread_Create affinity not possible");
+			cpu_set_t cpus;
+			CPU_ZERO(&cpus);
+			for(int cpu=0; CPU_SETSIZE>cpu; ++cpu)
+				CPU_SET(cpu, &cpus);
+			pthread_attr_setaffinity_np(attributes, sizeof(cpus), &cpus);
+			rc = pthread_create(thread, attributes, routine, arg);
+		}
+		return(rc);
+	}
+
+	Thread_Pacer::Thread_Pacer(uint64_t period)
+		: Period(period), LastWake(0)
+	{
+		this->Reset();
+		this->Start();
+	}
+	void Thread_Pacer::SetPeriod(uint64_t period)
+	{
+		if(period == this->Period || 0 == period)
+		{
+			return;
+		}
+		//	move next deadline, histogram is relative to new target
+		uint64_t deadline = Thread_Nanoseconds(this->Deadline) - this->Period + period;
+		this->Deadline.tv_sec = deadline /1000000000;
+		this->Deadline.tv_nsec = deadline %1000000000;
+		this->Period = period;
+		this->Reset();
+	}
+	uint64_t Thread_Pacer::GetPeriod(void) const
+	{
+		return(this->Period);
+	}
+	void Thread_Pacer::Start(void)
+	{
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		uint64_t deadline = Thread_Nanoseconds(now) + this->Period;
+		this->Deadline.tv_sec = deadline /1000000000;
+		this->Deadline.tv_nsec = deadline %1000000000;
+		this->LastWake = 0;
+	}
+	bool Thread_Pacer::Wait(void)
+	{
+		int rc;
+		do
+		{
+			rc = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &this->Deadline, NULL);
+		}	while(EINTR == rc);
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		uint64_t wake = Thread_Nanoseconds(now);
+		uint64_t deadline = Thread_Nanoseconds(this->Deadline);
+		this->Record(wake);
+		uint64_t lateness = (wake > deadline ?wake - deadline :0);
+		if(lateness > this->MaxLateness.load(std::memory_order_relaxed))
+			this->MaxLateness.store(lateness, std::memory_order_relaxed);
+		deadline += this->Period;
+		bool missed = (wake >= deadline);
+		if(missed)
+		{
+			//	skip missed deadlines, keep phase
+			uint64_t skipped = (wake - deadline) / this->Period +1;
+			deadline += skipped * this->Period;
+			this->Overruns.store(this->Overruns.load(std::memory_order_relaxed) + skipped, std::memory_order_relaxed);
+		}
+		this->Deadline.tv_sec = deadline /1000000000;
+		this->Deadline.tv_nsec = deadline %1000000000;
+		return(!missed);
+	}
+	void Thread_Pacer::Record(uint64_t now)
+	{
+		uint64_t last = this->LastWake;
+		this->LastWake = now;
+		if(0 == last)
+		{
+			return;
+		}
+		uint64_t period = now - last;
+		uint64_t deviation = (period > this->Period ?period - this->Period :this->Period - period) /1000;
+		int bucket = 0;
+		while(0 < deviation && THREAD_JITTER_BUCKETS -1 > bucket)
+		{
+			deviation >>= 1;
+			++bucket;
+		}
+		this->Bucket[bucket].store(this->Bucket[bucket].load(std::memory_order_relaxed) +1, std::memory_order_relaxed);
+		if(period < this->MinPeriod.load(std::memory_order_relaxed))
+			this->MinPeriod.store(period, std::memory_order_relaxed);
+		if(period > this->MaxPeriod.load(std::memory_order_relaxed))
+			this->MaxPeriod.store(period, std::memory_order_relaxed);
+		this->Periods.store(this->Periods.load(std::memory_order_relaxed) +1, std::memory_order_release);
+	}
+	void Thread_Pacer::Reset(void)
+	{
+		this->Periods.store(0, std::memory_order_relaxed);
+		this->Overruns.store(0, std::memory_order_relaxed);
+		this->MinPeriod.store(UINT64_MAX, std::memory_order_relaxed);
+		this->MaxPeriod.store(0, std::memory_order_relaxed);
+		this->MaxLateness.store(0, std::memory_order_relaxed);
+		for(int bucket=0; THREAD_JITTER_BUCKETS>bucket; ++bucket)
+		{
+			this->Bucket[bucket].store(0, std::memory_order_relaxed);
+		}
+		this->LastWake = 0;
+	}
+	void Thread_Pacer::Snapshot(Thread_Jitter& jitter) const
+	{
+		//	counters may be one period apart, no lock against pacing thread
+		jitter.Target = this->Period;
+		jitter.Periods = this->Periods.load(std::memory_order_acquire);
+		jitter.Overruns = this->Overruns.load(std::memory_order_relaxed);
+		jitter.MinPeriod = (0 < jitter.Periods ?this->MinPeriod.load(std::memory_order_relaxed) :0);
+		jitter.MaxPeriod = this->MaxPeriod.load(std::memory_order_relaxed);
+		jitter.MaxLateness = this->MaxLateness.load(std::memory_order_relaxed);
+		for(int bucket=0; THREAD_JITTER_BUCKETS>bucket; ++bucket)
+		{
+			jitter.Bucket[bucket] = this->Bucket[bucket].load(std::memory_order_relaxed);
+		}
+	}
+	int Thread_Pacer::Format(const Thread_Jitter& jitter, char* buffer, size_t size)
+	{
+		int written = snprintf(buffer, size, "target %lluus periods %llu min %lluus max %lluus late %lluus overruns %llu jitter"
+			, (unsigned long long)(jitter.Target /1000), (unsigned long long)jitter.Periods
+			, (unsigned long long)(jitter.MinPeriod /1000), (unsigned long long)(jitter.MaxPeriod /1000)
+			, (unsigned long long)(jitter.MaxLateness /1000), (unsigned long long)jitter.Overruns);
+		for(int bucket=0; THREAD_JITTER_BUCKETS>bucket && 0 <= written && size > (size_t)written; ++bucket)
+		{
+			if(0 == jitter.Bucket[bucket])
+				continue;
+			written += snprintf(buffer +written, size -written, " <%dus:%llu", (1 <<bucket), (unsigned long long)jitter.Bucket[bucket]);
+		}
+		return(written);
+	}
+
+};
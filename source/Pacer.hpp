@@ -0,0 +1,100 @@
+/*	Pacer
+ *	real time configuration and absolute deadline pacing of polling threads
+**
+**	piScope project https://github.com/march42/piScope
+**	(C) Copyright 2017 by Marc Hefter
+**
+**	This program is free software; you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation; either version 3 of the License, or
+**	(at your option) any later version.
+**
+**	This program is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with this program; if not, write to the Free Software
+**	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+**	MA 02110-1301 USA.
+ */
+
+/*!	\brief	class Thread_Pacer
+ *
+ *	Declaration of class, members and methods.
+ *	Thread_Config selects SCHED_FIFO priority, CPU affinity and locked memory
+ *	for a polling thread, Thread_Create applies it and falls back to default
+ *	scheduling without privileges. Thread_Pacer sleeps until absolute
+ *	deadlines (clock_nanosleep TIMER_ABSTIME on CLOCK_MONOTONIC), so sleeping
+ *	does not add up to drift, and keeps a histogram of the achieved period.
+ */
+
+#ifndef _PACER_HPP_
+#define _PACER_HPP_
+
+#include "../config.h"
+
+#include <cstdlib>
+#include <cstddef>
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+#include <atomic>
+
+using namespace std;
+namespace rpiScope
+{
+
+	typedef struct Thread_Config
+	{
+		int Priority;	//	SCHED_FIFO priority 1..99, 0 for default scheduling
+		int CPU;	//	pinned to CPU, -1 for any
+		bool LockMemory;	//	mlockall current and future pages, avoids page faults
+	}	Thread_Config;
+	//	create joinable thread with configuration, default scheduling if not permitted
+	int Thread_Create(pthread_t* thread, pthread_attr_t* attributes, const Thread_Config& config, void *(*routine)(void*), void* arg);
+
+	/*	Thread_Jitter
+	 *	bucket 0 counts periods within 1us of target,
+	 *	bucket n counts deviations of 2^(n-1) up to 2^n micro seconds
+	 */
+	typedef struct Thread_Jitter
+	{
+		uint64_t Target;	//	period in nano seconds
+		uint64_t Periods;	//	periods measured
+		uint64_t Overruns;	//	deadlines missed by more than one period, skipped
+		uint64_t MinPeriod;	//	nano seconds
+		uint64_t MaxPeriod;	//	nano seconds
+		uint64_t MaxLateness;	//	wake up after deadline, nano seconds
+		uint64_t Bucket[THREAD_JITTER_BUCKETS];
+	}	Thread_Jitter;
+
+	class Thread_Pacer
+	{
+		public:
+			Thread_Pacer(uint64_t period=1000000);
+			void SetPeriod(uint64_t period);	//	nano seconds, next deadline keeps phase
+			uint64_t GetPeriod(void) const;
+			void Start(void);	//	first deadline one period from now
+			bool Wait(void);	//	sleep until next deadline, false if deadline was missed
+			void Reset(void);	//	clear histogram
+			void Snapshot(Thread_Jitter& jitter) const;
+			static int Format(const Thread_Jitter& jitter, char* buffer, size_t size);	//	one line summary
+		protected:
+			uint64_t Period;
+			struct timespec Deadline;
+			uint64_t LastWake;	//	CLOCK_MONOTONIC nano seconds, 0 before first period
+			//	written by pacing thread only, read from any thread
+			std::atomic<uint64_t> Periods;
+			std::atomic<uint64_t> Overruns;
+			std::atomic<uint64_t> MinPeriod;
+			std::atomic<uint64_t> MaxPeriod;
+			std::atomic<uint64_t> MaxLateness;
+			std::atomic<uint64_t> Bucket[THREAD_JITTER_BUCKETS];
+			void Record(uint64_t now);
+		private:
+	};
+
+};
+#endif	/* _PACER_HPP_ */
@@ -0,0 +1,208 @@
+/*
+**	Precession (.hpp/.cpp)
+**	precession and nutation between J2000 and equator of date
+**
+**	piScope project https://github.com/march42/piScope
+**	(C) Copyright 2017 by Marc Hefter
+**
+**	This program is free software; you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation; either version 3 of the License, or
+**	(at your option) any later version.
+**
+**	This program is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with this program; if not, write to the Free Software
+**	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+**	MA 02110-1301 USA.
+*/
+
+#include "Precession.hpp"
+#include "MACROS.h"
+
+//#include <unistd.h>
+//#include <cstdio>
+//#include <cstdlib>
+//#include <cstring>
+#include <cmath>
+//#include <cassert>
+
+namespace piScope
+{
+
+	/*	IAU 1980 nutation series (Meeus, table 22.A)
+	**	multiples of D, M, M', F, Omega
+	**	longitude and obliquity coefficients in 0.0001 arc seconds, constant and per Julian century
+	*/
+	static const struct
+	{
+		signed char D, M, Mm, F, Omega;
+		int Longitude;
+		double LongitudeT;
+		int Obliquity;
+		double ObliquityT;
+	}	MHNutationSeries[] =
+	{
+		{  0, 0, 0, 0, 1, -171996, -174.2, 92025, 8.9 },
+		{ -2, 0, 0, 2, 2, -13187, -1.6, 5736, -3.1 },
+		{  0, 0, 0, 2, 2, -2274, -0.2, 977, -0.5 },
+		{  0, 0, 0, 0, 2, 2062, 0.2, -895, 0.5 },
+		{  0, 1, 0, 0, 0, 1426, -3.4, 54, -0.1 },
+		{  0, 0, 1, 0, 0, 712, 0.1, -7, 0 },
+		{ -2, 1, 0, 2, 2, -517, 1.2, 224, -0.6 },
+		{  0, 0, 0, 2, 1, -386, -0.4, 200, 0 },
+		{  0, 0, 1, 2, 2, -301, 0, 129, -0.1 },
+		{ -2,-1, 0, 2, 2, 217, -0.5, -95, 0.3 },
+		{ -2, 0, 1, 0, 0, -158, 0, 0, 0 },
+		{ -2, 0, 0, 2, 1, 129, 0.1, -70, 0 },
+		{  0, 0,-1, 2, 2, 123, 0, -53, 0 },
+		{  2, 0, 0, 0, 0, 63, 0, 0, 0 },
+		{  0, 0, 1, 0, 1, 63, 0.1, -33, 0 },
+		{  2, 0,-1, 2, 2, -59, 0, 26, 0 },
+		{  0, 0,-1, 0, 1, -58, -0.1, 32, 0 },
+		{  0, 0, 1, 2, 1, -51, 0, 27, 0 },
+		{ -2, 0, 2, 0, 0, 48, 0, 0, 0 },
+		{  0, 0,-2, 2, 1, 46, 0, -24, 0 },
+		{  2, 0, 0, 2, 2, -38, 0, 16, 0 },
+		{  0, 0, 2, 2, 2, -31, 0, 13, 0 },
+		{  0, 0, 2, 0, 0, 29, 0, 0, 0 },
+		{ -2, 0, 1, 2, 2, 29, 0, -12, 0 },
+		{  0, 0, 0, 2, 0, 26, 0, 0, 0 },
+		{ -2, 0, 0, 2, 0, -22, 0, 0, 0 },
+		{  0, 0,-1, 2, 1, 21, 0, -10, 0 },
+		{  0, 2, 0, 0, 0, 17, -0.1, 0, 0 },
+		{  2, 0,-1, 0, 1, 16, 0, -8, 0 },
+		{ -2, 2, 0, 2, 2, -16, 0.1, 7, 0 },
+		{  0, 1, 0, 0, 1, -15, 0, 9, 0 },
+		{ -2, 0, 1, 0, 1, -13, 0, 7, 0 },
+		{  0,-1, 0, 0, 1, -12, 0, 6, 0 },
+		{  0, 0, 2,-2, 0, 11, 0, 0, 0 },
+		{  2, 0,-1, 2, 1, -10, 0, 5, 0 },
+		{  2, 0, 1, 2, 2, -8, 0, 3, 0 },
+		{  0, 1, 0, 2, 2, 7, 0, -3, 0 },
+		{ -2, 1, 1, 0, 0, -7, 0, 0, 0 },
+		{  0,-1, 0, 2, 2, -7, 0, 3, 0 },
+		{  2, 0, 0, 2, 1, -7, 0, 3, 0 },
+		{  2, 0, 1, 0, 0, 6, 0, 0, 0 },
+		{ -2, 0, 2, 2, 2, 6, 0, -3, 0 },
+		{ -2, 0, 1, 2, 1, 6, 0, -3, 0 },
+		{  2, 0,-2, 0, 1, -6, 0, 3, 0 },
+		{  2, 0, 0, 0, 1, -6, 0, 3, 0 },
+		{  0,-1, 1, 0, 0, 5, 0, 0, 0 },
+		{ -2,-1, 0, 2, 1, -5, 0, 3, 0 },
+		{ -2, 0, 0, 0, 1, -5, 0, 3, 0 },
+		{  0, 0, 2, 2, 1, -5, 0, 3, 0 },
+		{ -2, 0, 2, 0, 1, 4, 0, 0, 0 },
+		{ -2, 1, 0, 2, 1, 4, 0, 0, 0 },
+		{  0, 0, 1,-2, 0, 4, 0, 0, 0 },
+		{ -1, 0, 1, 0, 0, -4, 0, 0, 0 },
+		{ -2, 1, 0, 0, 0, -4, 0, 0, 0 },
+		{  1, 0, 0, 0, 0, -4, 0, 0, 0 },
+		{  0, 0, 1, 2, 0, 3, 0, 0, 0 },
+		{  0, 0,-2, 2, 2, -3, 0, 0, 0 },
+		{ -1,-1, 1, 0, 0, -3, 0, 0, 0 },
+		{  0, 1, 1, 0, 0, -3, 0, 0, 0 },
+		{  0,-1, 1, 2, 2, -3, 0, 0, 0 },
+		{  2,-1,-1, 2, 2, -3, 0, 0, 0 },
+		{  0, 0, 3, 2, 2, -3, 0, 0, 0 },
+		{  2,-1, 0, 2, 2, -3, 0, 0, 0 },
+	};
+
+	MHPrecession::MHPrecession()
+		: Span(0), Valid(false), Refreshs(0)
+	{
+		this->Cached.Longitude = 0.0;
+		this->Cached.Obliquity = 0.0;
+		this->Cached.MeanObliquity = J2000_OBLIQUITY;
+	}
+	MHPrecession::~MHPrecession()
+	{
+	}
+
+	MHRotation MHPrecession::Precession(double t)
+	{
+		//	zeta, z, theta in arc seconds (Meeus 21.3), rotations of vector: z about pole, -theta, zeta
+		double zeta = t * (2306.2181 + t * (0.30188 + t * 0.017998));
+		double z = t * (2306.2181 + t * (1.09468 + t * 0.018203));
+		double theta = t * (2004.3109 - t * (0.42665 + t * 0.041833));
+		MHRotation rotation = MHRotation::AxisZ(DEG2RAD(z / 3600.0));
+		rotation = rotation.Multiply(MHRotation::AxisY(DEG2RAD(-theta / 3600.0)));
+		return(rotation.Multiply(MHRotation::AxisZ(DEG2RAD(zeta / 3600.0))));
+	}
+	MHNutation MHPrecession::Nutation(double t)
+	{
+		//	fundamental arguments in degrees (Meeus 22)
+		double D = 297.85036 + t * (445267.111480 + t * (-0.0019142 + t / 189474.0));
+		double M = 357.52772 + t * (35999.050340 + t * (-0.0001603 - t / 300000.0));
+		double Mm = 134.96298 + t * (477198.867398 + t * (0.0086972 + t / 56250.0));
+		double F = 93.27191 + t * (483202.017538 + t * (-0.0036825 + t / 327270.0));
+		double Omega = 125.04452 + t * (-1934.136261 + t * (0.0020708 + t / 450000.0));
+		MHNutation nutation;
+		nutation.Longitude = 0.0;
+		nutation.Obliquity = 0.0;
+		for(size_t index=0; sizeof(MHNutationSeries) / sizeof(MHNutationSeries[0]) > index; ++index)
+		{
+			double argument = DEG2RAD((MHNutationSeries[index].D * D) + (MHNutationSeries[index].M * M) + (MHNutationSeries[index].Mm * Mm)
+				+ (MHNutationSeries[index].F * F) + (MHNutationSeries[index].Omega * Omega));
+			nutation.Longitude += (MHNutationSeries[index].Longitude + (MHNutationSeries[index].LongitudeT * t)) * sin(argument);
+			nutation.Obliquity += (MHNutationSeries[index].Obliquity + (MHNutationSeries[index].ObliquityT * t)) * cos(argument);
+		}
+		nutation.Longitude *= 0.0001;
+		nutation.Obliquity *= 0.0001;
+		//	mean obliquity (Meeus 22.2)
+		nutation.MeanObliquity = LATLON_DMS2DEG(23,26,21.448) + (t * (-46.8150 + t * (-0.00059 + t * 0.001813)) / 3600.0);
+		return(nutation);
+	}
+	MHRotation MHPrecession::NutationMatrix(const MHNutation& nutation)
+	{
+		//	mean equator to ecliptic, nutation in longitude, back to true equator
+		double obliquity = nutation.MeanObliquity + (nutation.Obliquity / 3600.0);
+		MHRotation rotation = MHRotation::AxisX(DEG2RAD(obliquity));
+		rotation = rotation.Multiply(MHRotation::AxisZ(DEG2RAD(nutation.Longitude / 3600.0)));
+		return(rotation.Multiply(MHRotation::AxisX(DEG2RAD(-nutation.MeanObliquity))));
+	}
+
+	void MHPrecession::Refresh(int64_t ns)
+	{
+		const int64_t span = (int64_t)PRECESSION_CACHE_SPAN * TIME_NSPERSECOND;
+		int64_t index = ns / span - (0 > ns % span ?1 :0);
+		if(this->Valid && index == this->Span)
+		{
+			return;
+		}
+		//	middle of span, half the change within span at most
+		double t = J2000_NS2DAYS(index * span + span / 2) / (JULIAN_DAYSPERYEAR * 100);
+		this->Cached = MHPrecession::Nutation(t);
+		this->Forward = MHPrecession::NutationMatrix(this->Cached).Multiply(MHPrecession::Precession(t));
+		this->Backward = this->Forward.Transpose();
+		this->Span = index;
+		this->Valid = true;
+		++this->Refreshs;
+	}
+	const MHRotation& MHPrecession::J20002Date(int64_t ns)
+	{
+		this->Refresh(ns);
+		return(this->Forward);
+	}
+	const MHRotation& MHPrecession::Date2J2000(int64_t ns)
+	{
+		this->Refresh(ns);
+		return(this->Backward);
+	}
+	const MHNutation& MHPrecession::GetNutation(int64_t ns)
+	{
+		this->Refresh(ns);
+		return(this->Cached);
+	}
+	double MHPrecession::GetEquationOfEquinoxes(int64_t ns)
+	{
+		this->Refresh(ns);
+		//	nutation in right ascension, delta psi * cos(epsilon)
+		return(this->Cached.Longitude * cos(DEG2RAD(this->Cached.MeanObliquity + (this->Cached.Obliquity / 3600.0))) / 3600.0);
+	}
+
+};
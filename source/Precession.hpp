@@ -0,0 +1,85 @@
+/*
+**	Precession (.hpp/.cpp)
+**	precession and nutation between J2000 and equator of date
+**
+**	piScope project https://github.com/march42/piScope
+**	(C) Copyright 2017 by Marc Hefter
+**
+**	This program is free software; you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation; either version 3 of the License, or
+**	(at your option) any later version.
+**
+**	This program is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with this program; if not, write to the Free Software
+**	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+**	MA 02110-1301 USA.
+*/
+
+/*!	\brief	class MHPrecession
+ *
+ *	Declaration of class, members and methods.
+ *	IAU 1976 precession (Lieske) and IAU 1980 nutation (63 terms), as given
+ *	by Meeus, Astronomical Algorithms, chapters 21 and 22.
+ *	Rotations between J2000 and true equator and equinox of date change slowly,
+ *	so they are cached per PRECESSION_CACHE_SPAN seconds.
+ *	UT is taken for TT, difference of about a minute is far below 0.001 arcsec.
+ */
+
+#ifndef _PRECESSION_HPP_
+#	define _PRECESSION_HPP_
+
+#	include "../config.h"
+#	include "Rotation.hpp"
+
+#	include <stdint.h>
+
+namespace piScope
+{
+
+	typedef struct MHNutation
+	{
+		double Longitude;	/*!< nutation in longitude (delta psi), arc seconds */
+		double Obliquity;	/*!< nutation in obliquity (delta epsilon), arc seconds */
+		double MeanObliquity;	/*!< mean obliquity of ecliptic (epsilon 0), degrees */
+	}	MHNutation;
+
+	class MHPrecession
+	{
+	private:	/* private members are accessible only from within the same class or "friends" */
+
+	protected:	/* protected members are accessible from the same class or "friends" and derived classes */
+		int64_t Span;	/*!< number of cached span since J2000.0 */
+		bool Valid;	/*!< cache calculated */
+		MHNutation Cached;	/*!< nutation at middle of cached span */
+		MHRotation Forward;	/*!< J2000 to true equator and equinox of date */
+		MHRotation Backward;	/*!< true equator and equinox of date to J2000 */
+		void Refresh(int64_t ns);	/*!< calculate rotations of span containing time stamp */
+
+	public:	/* public members are accessible from anywhere */
+		unsigned long Refreshs;	/*!< number of cache calculations */
+
+		//	constructor/destructor
+		MHPrecession();	/*!< constructor */
+		~MHPrecession();	/*!< destructor */
+
+		//	public calculation methods, t = Julian centuries since J2000.0
+		static MHRotation Precession(double t);	/*!< mean equator and equinox J2000 to mean of date */
+		static MHNutation Nutation(double t);	/*!< nutation and mean obliquity of date */
+		static MHRotation NutationMatrix(const MHNutation& nutation);	/*!< mean equator and equinox of date to true of date */
+
+		//	public access methods, cached, ns = nano seconds since J2000.0
+		const MHRotation& J20002Date(int64_t ns);	/*!< get rotation from J2000 to true equator and equinox of date */
+		const MHRotation& Date2J2000(int64_t ns);	/*!< get rotation from true equator and equinox of date to J2000 */
+		const MHNutation& GetNutation(int64_t ns);	/*!< get nutation of date */
+		double GetEquationOfEquinoxes(int64_t ns);	/*!< get apparent minus mean sidereal time, degrees */
+	};
+
+};
+
+#endif	/* _PRECESSION_HPP_ */
@@ -0,0 +1,114 @@
+/*
+**	Rotation (.hpp/.cpp)
+**	3x3 rotation matrix for coordinate frame transformations
+**
+**	piScope project https://github.com/march42/piScope
+**	(C) Copyright 2017 by Marc Hefter
+**
+**	This program is free software; you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation; either version 3 of the License, or
+**	(at your option) any later version.
+**
+**	This program is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with this program; if not, write to the Free Software
+**	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+**	MA 02110-1301 USA.
+*/
+
+#include "Rotation.hpp"
+
+//#include <unistd.h>
+//#include <cstdio>
+//#include <cstdlib>
+//#include <cstring>
+#include <cmath>
+//#include <cassert>
+
+namespace piScope
+{
+
+	MHRotation::MHRotation()
+	{
+		for(int row=0; 3>row; ++row)
+		{
+			for(int column=0; 3>column; ++column)
+			{
+				this->M[row][column] = (row == column ?1.0 :0.0);
+			}
+		}
+	}
+	MHRotation::MHRotation(double m00, double m01, double m02, double m10, double m11, double m12, double m20, double m21, double m22)
+	{
+		this->M[0][0] = m00;	this->M[0][1] = m01;	this->M[0][2] = m02;
+		this->M[1][0] = m10;	this->M[1][1] = m11;	this->M[1][2] = m12;
+		this->M[2][0] = m20;	this->M[2][1] = m21;	this->M[2][2] = m22;
+	}
+
+	MHRotation MHRotation::AxisX(double rad)
+	{
+		double c = cos(rad);
+		double s = sin(rad);
+		return(MHRotation(1,0,0, 0,c,-s, 0,s,c));
+	}
+	MHRotation MHRotation::AxisY(double rad)
+	{
+		double c = cos(rad);
+		double s = sin(rad);
+		return(MHRotation(c,0,s, 0,1,0, -s,0,c));
+	}
+	MHRotation MHRotation::AxisZ(double rad)
+	{
+		double c = cos(rad);
+		double s = sin(rad);
+		return(MHRotation(c,-s,0, s,c,0, 0,0,1));
+	}
+
+	MHRotation MHRotation::Multiply(const MHRotation& right) const
+	{
+		MHRotation product;
+		for(int row=0; 3>row; ++row)
+		{
+			for(int column=0; 3>column; ++column)
+			{
+				product.M[row][column] = (this->M[row][0] * right.M[0][column]) + (this->M[row][1] * right.M[1][column]) + (this->M[row][2] * right.M[2][column]);
+			}
+		}
+		return(product);
+	}
+	MHRotation MHRotation::Transpose(void) const
+	{
+		return(MHRotation(this->M[0][0],this->M[1][0],this->M[2][0], this->M[0][1],this->M[1][1],this->M[2][1], this->M[0][2],this->M[1][2],this->M[2][2]));
+	}
+	void MHRotation::Rotate(const double* in, double* out) const
+	{
+		double x = in[0];
+		double y = in[1];
+		double z = in[2];
+		out[0] = (this->M[0][0] * x) + (this->M[0][1] * y) + (this->M[0][2] * z);
+		out[1] = (this->M[1][0] * x) + (this->M[1][1] * y) + (this->M[1][2] * z);
+		out[2] = (this->M[2][0] * x) + (this->M[2][1] * y) + (this->M[2][2] * z);
+	}
+	void MHRotation::Rotate(const double* x, const double* y, const double* z, double* outx, double* outy, double* outz, size_t count) const
+	{
+		//	matrix in locals, compiler keeps it in registers for whole loop
+		const double m00 = this->M[0][0], m01 = this->M[0][1], m02 = this->M[0][2];
+		const double m10 = this->M[1][0], m11 = this->M[1][1], m12 = this->M[1][2];
+		const double m20 = this->M[2][0], m21 = this->M[2][1], m22 = this->M[2][2];
+		for(size_t index=0; count>index; ++index)
+		{
+			double vx = x[index];
+			double vy = y[index];
+			double vz = z[index];
+			outx[index] = (m00 * vx) + (m01 * vy) + (m02 * vz);
+			outy[index] = (m10 * vx) + (m11 * vy) + (m12 * vz);
+			outz[index] = (m20 * vx) + (m21 * vy) + (m22 * vz);
+		}
+	}
+
+};
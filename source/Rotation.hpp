@@ -0,0 +1,68 @@
+/*
+**	Rotation (.hpp/.cpp)
+**	3x3 rotation matrix for coordinate frame transformations
+**
+**	piScope project https://github.com/march42/piScope
+**	(C) Copyright 2017 by Marc Hefter
+**
+**	This program is free software; you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation; either version 3 of the License, or
+**	(at your option) any later version.
+**
+**	This program is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with this program; if not, write to the Free Software
+**	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+**	MA 02110-1301 USA.
+*/
+
+/*!	\brief	class MHRotation
+ *
+ *	Declaration of class, members and methods.
+ *	Plain 3x3 rotation matrix, rotations about the axes and batch rotation
+ *	of vectors stored as separate X/Y/Z arrays, so loops vectorize.
+ */
+
+#ifndef _ROTATION_HPP_
+#	define _ROTATION_HPP_
+
+#	include "../config.h"
+
+#	include <cstddef>
+
+namespace piScope
+{
+
+	class MHRotation
+	{
+	private:	/* private members are accessible only from within the same class or "friends" */
+
+	protected:	/* protected members are accessible from the same class or "friends" and derived classes */
+
+	public:	/* public members are accessible from anywhere */
+		double M[3][3];	/*!< matrix rows, out = M * in */
+
+		//	constructor/destructor
+		MHRotation();	/*!< constructor, identity */
+		MHRotation(double m00, double m01, double m02, double m10, double m11, double m12, double m20, double m21, double m22);	/*!< constructor by rows */
+
+		//	public creation methods
+		static MHRotation AxisX(double rad);	/*!< rotation of vectors by angle about X axis, counter clockwise */
+		static MHRotation AxisY(double rad);	/*!< rotation of vectors by angle about Y axis, counter clockwise */
+		static MHRotation AxisZ(double rad);	/*!< rotation of vectors by angle about Z axis, counter clockwise */
+
+		//	public access methods
+		MHRotation Multiply(const MHRotation& right) const;	/*!< this * right, applies right first */
+		MHRotation Transpose(void) const;	/*!< inverse rotation */
+		void Rotate(const double* in, double* out) const;	/*!< rotate one vector[3] */
+		void Rotate(const double* x, const double* y, const double* z, double* outx, double* outy, double* outz, size_t count) const;	/*!< rotate batch of vectors */
+	};
+
+};
+
+#endif	/* _ROTATION_HPP_ */
@@ -0,0 +1,81 @@
+/*	SeqLock
+ *	sequence lock, publishing data from one writer to any number of readers
+**
+**	piScope project https://github.com/march42/piScope
+**	(C) Copyright 2017 by Marc Hefter
+**
+**	This program is free software; you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation; either version 3 of the License, or
+**	(at your option) any later version.
+**
+**	This program is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with this program; if not, write to the Free Software
+**	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+**	MA 02110-1301 USA.
+ */
+
+/*!	\brief	template class SeqLock
+ *
+ *	Declaration and implementation of template class.
+ *	The writer never waits, readers copy the value and retry if it was
+ *	changed meanwhile. There must be only one writer at a time and the
+ *	value type has to be trivially copyable.
+ */
+
+#ifndef _SEQLOCK_HPP_
+#define _SEQLOCK_HPP_
+
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#include <atomic>
+using namespace std;
+namespace rpiScope
+{
+
+	template <typename T> class SeqLock
+	{
+		public:
+			SeqLock() : Sequence(0)
+			{
+				memset((void*)&this->Value, 0x00, sizeof(this->Value));
+			}
+			void Write(const T& value)
+			{
+				unsigned long sequence = this->Sequence.load(std::memory_order_relaxed);
+				//	odd sequence while writing
+				this->Sequence.store(sequence +1, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_release);
+				memcpy((void*)&this->Value, (const void*)&value, sizeof(this->Value));
+				this->Sequence.store(sequence +2, std::memory_order_release);
+			}
+			void Read(T& value) const
+			{
+				unsigned long before = 0;
+				unsigned long after = 0;
+				do
+				{
+					before = this->Sequence.load(std::memory_order_acquire);
+					memcpy((void*)&value, (const void*)&this->Value, sizeof(this->Value));
+					std::atomic_thread_fence(std::memory_order_acquire);
+					after = this->Sequence.load(std::memory_order_relaxed);
+				}	while(0 != (before &1) || before != after);
+			}
+			unsigned long Version(void) const	//	number of writes
+			{
+				return(this->Sequence.load(std::memory_order_acquire) >>1);
+			}
+		protected:
+			std::atomic<unsigned long> Sequence;
+			T Value;
+		private:
+	};
+
+};
+#endif	/* _SEQLOCK_HPP_ */
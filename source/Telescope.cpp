@@ -27,7 +27,7 @@
 //#include <cstdio>
 #include <cstdlib>
 #include <cstring>
-//#include <cmath>
+#include <cmath>
 //#include <climits>
 #include <unistd.h>
 
@@ -47,7 +47,7 @@ namespace piScope
 {
 
 	MHTelescope::MHTelescope(const char* name)
-		: Name(NULL), Location(NULL)
+		: Name(NULL), Location(NULL), Sky(NULL), OrientationHead(0), OrientationTail(0), OrientationRemoved(0)
 #	if defined(USE_RTIMULIB)
 		, ImuSetting(NULL), ImuSensor(NULL), IMUpthread_stopping(true), IMUpthread_running(false), IMUpthread(0)
 #	endif
@@ -56,9 +56,18 @@ namespace piScope
 		this->SetName(name);
 		//	log will be set to same name, in SetName
 		this->IMUpthread = pthread_self();	//	consider self==invalid for any sub thread
+#	if defined(USE_RTIMULIB)
+		this->IMUpthread_config.Priority = THREAD_PRIORITY;
+		this->IMUpthread_config.CPU = THREAD_CPU;
+		this->IMUpthread_config.LockMemory = false;
+#	endif
 		//	create variable buffers
 		this->Location = new MHLocation();
-		//this->Orientation = new MHAstroVector(VectorType_3DONLY, 0.0,0.0,0.0, 0.0, this->Location);
+		this->Sky = new MHTransform(this->Location);
+		memset(&this->Orientation[0], 0x00, sizeof(this->Orientation));
+		memset(&this->OrientationSin[0], 0x00, sizeof(this->OrientationSin));
+		memset(&this->OrientationCos[0], 0x00, sizeof(this->OrientationCos));
+		pthread_mutex_init(&this->OrientationMutex, NULL);
 	}
 	MHTelescope::~MHTelescope()
 	{
@@ -68,6 +77,8 @@ namespace piScope
 		{
 			this->IMUpthread_stopp();
 		}
+		pthread_mutex_destroy(&this->OrientationMutex);
+		delete(this->Sky);
 		this->printLog(9,"MHTelescope destructor:\t%s\n", "done");
 	}
 
@@ -92,59 +103,162 @@ namespace piScope
 
 	MHAstroVector* MHTelescope::GetOrientation(void)
 	{
-		//	limit queue to 1000 values
-		while(1000 < this->Orientation.size())
+		MHOrientationEstimate estimate;
+		if(!this->GetOrientation(&estimate))
 		{
-			this->Orientation.pop_front();
+			return(new MHAstroVector(VectorType_INVALID, 0.0,0.0,0.0, 0.0, this->Location));
 		}
-		MHAstroVector* vec = new MHAstroVector(this->Orientation.back());
-		this->printLog(9,"last orientation:\t%s\n", vec->ToString());
-		//	remove all values older than 300 seconds or differ more than 1 percent
-		//	leave a minimum of 100 values in queue
-		while(100 < this->Orientation.size() && (300 < this->Orientation.front()->GetElapsed()
-			|| 0.01 < abs(this->Orientation.front()->GetOffsetX(vec->GetX()))
-			|| 0.01 < abs(this->Orientation.front()->GetOffsetY(vec->GetY()))
-			|| 0.01 < abs(this->Orientation.front()->GetOffsetZ(vec->GetZ()))))
+		MHAstroVector* vec = new MHAstroVector(VectorType_LocalRPY, estimate.Roll, estimate.Pitch, estimate.Yaw, 0, this->Location);
+		vec->SetTimeJ2000(J2000_UNIXUS2NS(estimate.Timestamp));
+		return(vec);
+	}
+	bool MHTelescope::GetOrientation(MHOrientationEstimate* estimate)
+	{
+		if(NULL == estimate)
+		{
+			return(false);
+		}
+		uint64_t now = (uint64_t)time(NULL) *1000000;
+		pthread_mutex_lock(&this->OrientationMutex);
+		this->OrientationPrune(now);
+		size_t count = this->OrientationHead -this->OrientationTail;
+		estimate->Count = count;
+		if(0 == count)
+		{
+			pthread_mutex_unlock(&this->OrientationMutex);
+			return(false);
+		}
+		estimate->Timestamp = this->Orientation[(this->OrientationHead -1) &(TELESCOPE_ORIENTATION_SIZE-1)].Timestamp;
+		//	direction and length of mean unit vector
+		double mean[3], deviation[3];
+		for(int axis=0; 3>axis; ++axis)
+		{
+			mean[axis] = atan2(this->OrientationSin[axis], this->OrientationCos[axis]);
+			double length = hypot(this->OrientationSin[axis], this->OrientationCos[axis]) / count;
+			deviation[axis] = (1.0 <= length ?0.0 :sqrt(-2.0 * log(length)));
+		}
+		pthread_mutex_unlock(&this->OrientationMutex);
+		estimate->Roll = mean[0];
+		estimate->Pitch = mean[1];
+		estimate->Yaw = mean[2];
+		estimate->RollDeviation = deviation[0];
+		estimate->PitchDeviation = deviation[1];
+		estimate->YawDeviation = deviation[2];
+		this->printLog(9,"averaging orientation:\t%zu %f,%f,%f\n", count, estimate->Roll, estimate->Pitch, estimate->Yaw);
+		return(true);
+	}
+	void MHTelescope::OrientationPrune(uint64_t now)
+	{
+		if(this->OrientationHead == this->OrientationTail)
 		{
-			this->printLog(9,"remove orientation:\t%s\n", this->Orientation.front()->ToString());
-			this->Orientation.pop_front();
+			return;
 		}
-		//	calculate average
-		double px = 0, py = 0, pz = 0;
-		if(1 < this->Orientation.size())
+		const MHOrientationSample& last = this->Orientation[(this->OrientationHead -1) &(TELESCOPE_ORIENTATION_SIZE-1)];
+		//	remove all values older than 300 seconds or differ more than 1 percent of full circle
+		//	leave a minimum of 100 values in queue
+		//	every sample is removed once, amortized constant time per sample
+		uint64_t oldest = now -300 *1000000;
+		const double limit = 0.01 * FULLCIRCLE_RADIAN;
+		while(100 < this->OrientationHead -this->OrientationTail)
 		{
-			size_t pos;
-			for(pos=0; pos < this->Orientation.size(); ++pos)
+			const MHOrientationSample& front = this->Orientation[this->OrientationTail &(TELESCOPE_ORIENTATION_SIZE-1)];
+			//	shortest angular distance, across -PI/PI wrap
+			if(oldest <= front.Timestamp
+				&& limit >= fabs(remainder(front.Roll - last.Roll, FULLCIRCLE_RADIAN))
+				&& limit >= fabs(remainder(front.Pitch - last.Pitch, FULLCIRCLE_RADIAN))
+				&& limit >= fabs(remainder(front.Yaw - last.Yaw, FULLCIRCLE_RADIAN)))
 			{
-				px += this->Orientation.at(pos)->GetX();
-				py += this->Orientation.at(pos)->GetY();
-				pz += this->Orientation.at(pos)->GetZ();
+				break;
 			}
-			px /= pos;
-			py /= pos;
-			pz /= pos;
-			this->printLog(9,"averaging orientation:\t%d %f,%f,%f\n", pos, px,py,pz);
-			vec->Set(px, py, pz, 0);
+			++this->OrientationTail;
+			this->OrientationLeave(front);
 		}
-		return(vec);
+	}
+	void MHTelescope::OrientationEnter(const MHOrientationSample& sample)
+	{
+		//	angles summed as unit vectors, mean direction stable across -PI/PI wrap
+		const double value[3] = { sample.Roll, sample.Pitch, sample.Yaw };
+		for(int axis=0; 3>axis; ++axis)
+		{
+			this->OrientationSin[axis] += sin(value[axis]);
+			this->OrientationCos[axis] += cos(value[axis]);
+		}
+	}
+	void MHTelescope::OrientationLeave(const MHOrientationSample& sample)
+	{
+		if(TELESCOPE_ORIENTATION_SIZE <= ++this->OrientationRemoved || this->OrientationHead == this->OrientationTail)
+		{
+			this->OrientationRecalculate();
+			return;
+		}
+		const double value[3] = { sample.Roll, sample.Pitch, sample.Yaw };
+		for(int axis=0; 3>axis; ++axis)
+		{
+			this->OrientationSin[axis] -= sin(value[axis]);
+			this->OrientationCos[axis] -= cos(value[axis]);
+		}
+	}
+
+	void MHTelescope::OrientationRecalculate(void)
+	{
+		//	sum over ring, once per TELESCOPE_ORIENTATION_SIZE removals
+		this->OrientationRemoved = 0;
+		memset(&this->OrientationSin[0], 0x00, sizeof(this->OrientationSin));
+		memset(&this->OrientationCos[0], 0x00, sizeof(this->OrientationCos));
+		for(uint64_t pos=this->OrientationTail; this->OrientationHead>pos; ++pos)
+		{
+			this->OrientationEnter(this->Orientation[pos &(TELESCOPE_ORIENTATION_SIZE-1)]);
+		}
+	}
+	size_t MHTelescope::GetOrientationCount(void)
+	{
+		pthread_mutex_lock(&this->OrientationMutex);
+		size_t count = this->OrientationHead -this->OrientationTail;
+		pthread_mutex_unlock(&this->OrientationMutex);
+		return(count);
+	}
+	void MHTelescope::PushOrientation(double roll, double pitch, double yaw, uint64_t timestamp, uint32_t flags)
+	{
+		pthread_mutex_lock(&this->OrientationMutex);
+		MHOrientationSample& sample = this->Orientation[this->OrientationHead &(TELESCOPE_ORIENTATION_SIZE-1)];
+		//	full, oldest sample overwritten
+		if(TELESCOPE_ORIENTATION_SIZE <= this->OrientationHead -this->OrientationTail)
+		{
+			++this->OrientationTail;
+			this->OrientationLeave(sample);
+		}
+		sample.Timestamp = timestamp;
+		sample.Roll = roll;
+		sample.Pitch = pitch;
+		sample.Yaw = yaw;
+		sample.Flags = flags;
+		++this->OrientationHead;
+		this->OrientationEnter(sample);
+		pthread_mutex_unlock(&this->OrientationMutex);
+	}
+	void MHTelescope::ClearOrientation(void)
+	{
+		pthread_mutex_lock(&this->OrientationMutex);
+		this->OrientationTail = this->OrientationHead;
+		this->OrientationRecalculate();
+		pthread_mutex_unlock(&this->OrientationMutex);
 	}
 	bool MHTelescope::GetOrientation(double* RA, double* DEC)
 	{
-		if(NULL == RA || NULL == DEC || 0 == this->Orientation.size())
+		if(NULL == RA || NULL == DEC)
 		{
 			return(false);
 		}
 		//	get orientation
-		MHAstroVector* vec = this->GetOrientation();
-		if(NULL == vec || VectorType_INVALID == vec->GetType())
+		MHOrientationEstimate estimate;
+		if(!this->GetOrientation(&estimate))
 		{
 			return(false);
 		}
-		//	convert:	local hour angle = local sidereal time - right ascension
-		*RA = vec->GetLocalSiderealAngle();
-		//	declination = elevation + ecliptic
-		double rad = asin (vec->GetY() / (sqrt(pow(vec->GetX(),2) + pow(vec->GetY(),2) + pow(vec->GetZ(),2))));
-		*DEC = RAD2DEG(rad);
+		//	convert:	LocalRPY -> azimuth/altitude -> hour angle/declination -> right ascension/declination
+		pthread_mutex_lock(&this->OrientationMutex);
+		this->Sky->Orientation2Equatorial(estimate.Roll, estimate.Pitch, estimate.Yaw, J2000_UNIXUS2NS(estimate.Timestamp), RA, DEC);
+		pthread_mutex_unlock(&this->OrientationMutex);
 		//	return
 		return(true);
 	}
@@ -241,8 +355,22 @@ namespace piScope
 			this->printLog(2,"PollIMUSensor:\t%s\n", "no IMU sensor");
 			return(false);	//	no sensor or error
 		}
-		else if(this->ImuSensor->IMURead())
+		uint64_t start = rpiScope::Metrics_Loop::Now();
+		if(!this->ImuSensor->IMURead())
+		{
+			//	no new data, or reading failed
+			this->IMUpthread_metrics.Failures.Add();
+			if(!this->IMUpthread_running)
+			{
+				//	no output, if threaded reading
+				this->printLog(2,"PollIMUSensor:\t%s\n", "error reading or no new data");
+			}
+		}
+		else
 		{
+			uint64_t read = rpiScope::Metrics_Loop::Now();
+			this->IMUpthread_metrics.ReadDuration.Record(read - start);
+			this->IMUpthread_metrics.Reads.Add();
 			//	successfully read
 			if(!this->IMUpthread_running)
 			{
@@ -292,8 +420,11 @@ namespace piScope
 				double BETA = pose.y();		//	pitch
 				double GAMMA = pose.z();	//	yaw
 #				endif
-				//	create vector and push to queue
-				MHAstroVector* ori = new MHAstroVector(VectorType_LocalRPY, ALPHA, BETA, GAMMA, 0);
+				//	push to queue
+				uint32_t flags = OrientationFlag_ACCEL | OrientationFlag_COMPASS | (this->ImuData.gyroValid ?OrientationFlag_GYRO :0);
+#				if !defined(CALCULATE_ORIENTATION)
+				flags |= OrientationFlag_POSE;
+#				endif
 				#if defined(DONT_OPTIMIZE_TIMESTAMP)
 				//	this->ImuData.timestamp = RTMath::currentUSecsSinceEpoch()
 				struct timeval tvnow;
@@ -301,23 +432,14 @@ namespace piScope
 				time_t tstamp = time(NULL);
 				tvnow.tv_sec -= this->ImuData.timestamp / 1000000;	//	get offset
 				tstamp -= tvnow.tv_sec;
-				ori->SetTime(tstamp);
+				this->PushOrientation(ALPHA, BETA, GAMMA, (uint64_t)tstamp *1000000, flags);
 				#else
-				ori->SetTime(this->ImuData.timestamp /1000000);
+				this->PushOrientation(ALPHA, BETA, GAMMA, this->ImuData.timestamp, flags);
 				#endif
-				this->Orientation.push_back(ori);
+				this->IMUpthread_metrics.FusionTime.Record(rpiScope::Metrics_Loop::Now() - read);
 				return(true);	//	successfully polled IMU sensor
 			}
 		}
-		else
-		{
-			//	no new data, or reading failed
-			if(!this->IMUpthread_running)
-			{
-				//	no output, if threaded reading
-				this->printLog(2,"PollIMUSensor:\t%s\n", "error reading or no new data");
-			}
-		}
 		return(false);	//	polling failed, no new data or accel/compass not valid
 	}
 
@@ -325,46 +447,74 @@ namespace piScope
 	{
 		bool tsValid = true;
 		#if defined(USE_TIMESTAMP_IMUNOTMOVING)
-		MHAstroTime tsimu(this->ImuData.timestamp, this->Position);
+		MHAstroTime tsimu(1, this->Position);
+		tsimu.SetJ2000(J2000_UNIXUS2NS(this->ImuData.timestamp));
 		tsValid = 100 > tsimu.GetElapsed();
 		#endif
 		//	not moving, if x+y+z below 0.1 radians per second
-		return(tsValid && this->ImuData.gyroValid && 0.1 > (this->ImuData.gyro.x() + this->ImuData.gyro.y() + this->ImuData.gyro.z()));
+		return(tsValid && this->ImuData.gyroValid && 0.1 > (fabs(this->ImuData.gyro.x()) + fabs(this->ImuData.gyro.y()) + fabs(this->ImuData.gyro.z())));
 	}
 
 	void *IMUpthread_Polling(void *data)
 	{
 		MHTelescope* mother = (MHTelescope*)data;
 		mother->printLog(2,"IMUpthread_Polling starting\n");
-		int read_counter = 0;
-		int read_rate = 100;
+		MHPollScheduler& scheduler = mother->IMUpthread_scheduler;
+		//	absolute deadlines, no drift from polling time
+		mother->IMUpthread_pacer.SetPeriod(1000000000 / TELESCOPE_POLL_TRACKING);
+		mother->IMUpthread_pacer.Start();
+		uint64_t dumped = rpiScope::Metrics_Loop::Now();
+		uint64_t checked = 0;
 		while(!mother->IMUpthread_stopping)
 		{
 			mother->IMUpthread_running = true;
-			if(mother->PollIMUSensor())
+			uint64_t now = rpiScope::Metrics_Loop::Now();
+			mother->IMUpthread_metrics.Loop(now);
+			//	sensor interval once a second, not depending on poll rate
+			if(now - checked >= 1000000000 && NULL != mother->ImuSensor)
 			{
-				if(0 == (read_counter++ %(read_rate <<3)))
-				{
-					int interval = mother->ImuSensor->IMUGetPollInterval();	//	poll interval in ms
-					read_rate = (500 < interval ?2 :(1000 / interval));	// 2Hz minimum polling rate
-					mother->printLog(8,"IMU:\t%dHz\tgyro%s=[%f,%f,%f]\tacc%s=[%f,%f,%f]\tmag%s=[%f,%f,%f]\n", read_rate
-						, (mother->ImuData.gyroValid ?"" :"!"), mother->ImuData.gyro.x(),mother->ImuData.gyro.y(),mother->ImuData.gyro.z()
-						, (mother->ImuData.accelValid ?"" :"!"), mother->ImuData.accel.x(),mother->ImuData.accel.y(),mother->ImuData.accel.z()
-						, (mother->ImuData.compassValid ?"" :"!"), mother->ImuData.compass.x(),mother->ImuData.compass.y(),mother->ImuData.compass.z());
-				}
-				//	clear Orientation deque on movement
-				if(mother->ImuData.gyroValid && read_rate < (int)mother->Orientation.size()
-					&& 0.2 < (abs(mother->ImuData.gyro.x()) + abs(mother->ImuData.gyro.y()) + abs(mother->ImuData.gyro.z())))
-				{
-					mother->printLog(8,"IMU:\tclear on movement [%f,%f,%f]\n", abs(mother->ImuData.gyro.x()), abs(mother->ImuData.gyro.y()), abs(mother->ImuData.gyro.z()));
-					mother->Orientation.clear();
-				}
-				usleep(1000000 / read_rate);	//	calculate micro seconds from polling rate
+				scheduler.SetSensorInterval(mother->ImuSensor->IMUGetPollInterval());	//	poll interval in ms
+				checked = now;
 			}
-			else
+			if(now - dumped >= (uint64_t)METRICS_DUMP_INTERVAL *1000000000)
 			{
-				usleep(1000);	//	poll rate of 1kHz, if polling fails
+				MHPollStatistics statistics;
+				scheduler.GetStatistics(statistics);
+				mother->printLog(8,"IMU:\tstate %d %.1fHz\tgyro%s=[%f,%f,%f]\tacc%s=[%f,%f,%f]\tmag%s=[%f,%f,%f]\n", statistics.State, 1e9 /statistics.Period
+					, (mother->ImuData.gyroValid ?"" :"!"), mother->ImuData.gyro.x(),mother->ImuData.gyro.y(),mother->ImuData.gyro.z()
+					, (mother->ImuData.accelValid ?"" :"!"), mother->ImuData.accel.x(),mother->ImuData.accel.y(),mother->ImuData.accel.z()
+					, (mother->ImuData.compassValid ?"" :"!"), mother->ImuData.compass.x(),mother->ImuData.compass.y(),mother->ImuData.compass.z());
+				mother->printLog(8,"IMU:\tpolls tracking %llu slewing %llu idle %llu backoff %llu\n"
+					, (unsigned long long)statistics.Polls[PollState_TRACKING], (unsigned long long)statistics.Polls[PollState_SLEWING]
+					, (unsigned long long)statistics.Polls[PollState_IDLE], (unsigned long long)statistics.Polls[PollState_BACKOFF]);
+				rpiScope::Thread_Jitter jitter;
+				mother->IMUpthread_pacer.Snapshot(jitter);
+				char summary[400];
+				rpiScope::Thread_Pacer::Format(jitter, &summary[0], sizeof(summary));
+				mother->printLog(8,"IMU:\t%s\n", &summary[0]);
+				mother->printMetrics(8, "IMU", mother->IMUpthread_metrics);
+				dumped = now;
 			}
+			bool polled = mother->PollIMUSensor();
+			double motion = 0;
+			if(polled)
+			{
+				mother->IMUpthread_metrics.QueueDepth.Record(mother->GetOrientationCount());
+				if(mother->ImuData.gyroValid)
+					motion = fabs(mother->ImuData.gyro.x()) + fabs(mother->ImuData.gyro.y()) + fabs(mother->ImuData.gyro.z());
+			}
+			MHPollState_t state = scheduler.GetState();
+			uint64_t period = scheduler.Update(now, polled, motion, polled && mother->ImuNotMoving());
+			//	clear Orientation history when slewing begins, not on single spikes
+			if(PollState_SLEWING == scheduler.GetState() && PollState_SLEWING != state)
+			{
+				mother->printLog(8,"IMU:\tclear on movement [%f,%f,%f]\n", mother->ImuData.gyro.x(), mother->ImuData.gyro.y(), mother->ImuData.gyro.z());
+				mother->ClearOrientation();
+			}
+			//	period of scheduler state, exponential backoff after failed polls (not counted as missed)
+			mother->IMUpthread_pacer.SetPeriod(period);
+			if(!mother->IMUpthread_pacer.Wait() && PollState_BACKOFF != scheduler.GetState())
+				mother->IMUpthread_metrics.Missed.Add();
 		}
 		mother->IMUpthread_running = false;
 		mother->printLog(2,"IMUpthread_Polling stopped\n");
@@ -379,14 +529,13 @@ namespace piScope
 			this->IMUpthread_stopping = !this->InitIMUSensor();
 		}
 		//	IMU should be ready
-		//	prepare thread attributes
-		pthread_attr_init(&this->IMUpthread_attributes);
-		pthread_attr_setdetachstate(&this->IMUpthread_attributes, PTHREAD_CREATE_JOINABLE);
-		//	start thread
-		int rc = pthread_create(&this->IMUpthread, &this->IMUpthread_attributes, IMUpthread_Polling, (void *)this);
-		if(0 > rc)
+		//	start thread, with scheduling and affinity in attributes
+		int rc = rpiScope::Thread_Create(&this->IMUpthread, &this->IMUpthread_attributes, this->IMUpthread_config, IMUpthread_Polling, (void *)this);
+		if(0 != rc)
 		{
 			this->printLog(0,"pthread_create failed, for IMUpthread_Polling\n");
+			pthread_attr_destroy(&this->IMUpthread_attributes);
+			this->IMUpthread = pthread_self();
 		}
 		else
 		{
@@ -412,8 +561,128 @@ namespace piScope
 		this->IMUpthread = pthread_self();
 		this->printLog(9,"IMUpthread_stopp:\t%s\n", "stopped IMUpthread_Polling");
 		//	clear orientation buffer
-		this->Orientation.clear();
+		this->ClearOrientation();
+	}
+	void MHTelescope::IMUpthread_configure(const rpiScope::Thread_Config& config)
+	{
+		this->IMUpthread_config = config;
+	}
+	void MHTelescope::IMUpthread_jitter(rpiScope::Thread_Jitter& jitter) const
+	{
+		this->IMUpthread_pacer.Snapshot(jitter);
+	}
+	const rpiScope::Metrics_Loop& MHTelescope::GetIMUMetrics(void) const
+	{
+		return(this->IMUpthread_metrics);
+	}
+	void MHTelescope::GetIMUPollState(MHPollStatistics& statistics) const
+	{
+		this->IMUpthread_scheduler.GetStatistics(statistics);
 	}
 #	endif
 
+	MHPollScheduler::MHPollScheduler()
+		: Resume(PollState_TRACKING), SensorPeriod(0), Backoff(0), LastUpdate(0), LastMotion(0), StillSince(0), MotionSamples(0)
+	{
+		memset(&this->Statistics, 0x00, sizeof(this->Statistics));
+		this->Statistics.State = PollState_TRACKING;
+		this->Statistics.Period = 1000000000 / TELESCOPE_POLL_TRACKING;
+		this->Published.Write(this->Statistics);
+	}
+	void MHPollScheduler::SetSensorInterval(int interval)
+	{
+		this->SensorPeriod = (0 < interval ?(uint64_t)interval *1000000 :0);
+	}
+	MHPollState_t MHPollScheduler::GetState(void) const
+	{
+		return(this->Statistics.State);
+	}
+	void MHPollScheduler::GetStatistics(MHPollStatistics& statistics) const
+	{
+		this->Published.Read(statistics);
+	}
+	void MHPollScheduler::Enter(MHPollState_t state)
+	{
+		if(state != this->Statistics.State)
+		{
+			this->Statistics.State = state;
+			++this->Statistics.Transitions;
+		}
+	}
+	uint64_t MHPollScheduler::Update(uint64_t now, bool polled, double motion, bool still)
+	{
+		MHPollState_t state = this->Statistics.State;
+		if(0 != this->LastUpdate && now > this->LastUpdate)
+		{
+			this->Statistics.Time[state] += now - this->LastUpdate;
+		}
+		this->LastUpdate = now;
+		++this->Statistics.Polls[state];
+		if(!polled)
+		{
+			//	double delay on every failure, from sensor period up to maximum
+			++this->Statistics.Failures;
+			uint64_t first = (0 < this->SensorPeriod ?this->SensorPeriod :1000000);
+			this->Backoff = (0 == this->Backoff ?first :this->Backoff *2);
+			if((uint64_t)TELESCOPE_POLL_BACKOFF *1000000 < this->Backoff)
+				this->Backoff = (uint64_t)TELESCOPE_POLL_BACKOFF *1000000;
+			if(PollState_BACKOFF != state)
+			{
+				this->Resume = state;
+				this->Enter(PollState_BACKOFF);
+			}
+			this->Statistics.Period = this->Backoff;
+			this->Published.Write(this->Statistics);
+			return(this->Statistics.Period);
+		}
+		this->Backoff = 0;
+		if(PollState_BACKOFF == state)
+		{
+			state = this->Resume;
+			this->Enter(state);
+		}
+		this->MotionSamples = (TELESCOPE_POLL_SLEWMOTION < motion ?this->MotionSamples +1 :0);
+		if(PollState_SLEWING == state)
+		{
+			if(0 < this->MotionSamples)
+			{
+				this->LastMotion = now;
+			}
+			else if((uint64_t)TELESCOPE_POLL_SLEWHOLD *1000000000 <= now - this->LastMotion)
+			{
+				this->StillSince = 0;
+				this->Enter(PollState_TRACKING);
+			}
+		}
+		else if(TELESCOPE_POLL_SLEWSAMPLES <= this->MotionSamples)
+		{
+			this->LastMotion = now;
+			this->Enter(PollState_SLEWING);
+		}
+		else if(!still)
+		{
+			this->StillSince = 0;
+			this->Enter(PollState_TRACKING);
+		}
+		else if(0 == this->StillSince)
+		{
+			this->StillSince = now;
+		}
+		else if((uint64_t)TELESCOPE_POLL_IDLEAFTER *1000000000 <= now - this->StillSince)
+		{
+			this->Enter(PollState_IDLE);
+		}
+		//	rate of state, never faster than sensor
+		uint64_t period = 1000000000 / TELESCOPE_POLL_TRACKING;
+		if(PollState_SLEWING == this->Statistics.State)
+			period = (0 < this->SensorPeriod ?this->SensorPeriod :1000000000 / (4 *TELESCOPE_POLL_TRACKING));
+		else if(PollState_IDLE == this->Statistics.State)
+			period = 1000000000 / TELESCOPE_POLL_IDLE;
+		if(period < this->SensorPeriod)
+			period = this->SensorPeriod;
+		this->Statistics.Period = period;
+		this->Published.Write(this->Statistics);
+		return(period);
+	}
+
 };
@@ -33,13 +33,16 @@
 #	include "LogFile.hpp"
 #	include "TimeStamp.hpp"
 #	include "AstroTime.hpp"
+#	include "Transform.hpp"
 #	include "Vector3D.hpp"
 #	include "AstroVector.hpp"
 #	include "Location.hpp"
+#	include "Pacer.hpp"
+#	include "SeqLock.hpp"
 
 #	include <unistd.h>
+#	include <stdint.h>
 #	include <pthread.h>
-#	include <deque>
 
 #	if defined(USE_RTIMULIB)
 #		include <RTIMULib.h>
@@ -48,6 +51,76 @@
 namespace piScope
 {
 
+	typedef enum
+	{
+		OrientationFlag_ACCEL=0x01,	/*!< accelerometer data valid */
+		OrientationFlag_COMPASS=0x02,	/*!< compass data valid */
+		OrientationFlag_GYRO=0x04,	/*!< gyroscope data valid */
+		OrientationFlag_POSE=0x08,	/*!< fused pose of RTIMULib, not own calculation */
+	}	MHOrientationFlag_t;	/*!< validity flags of orientation sample */
+
+	typedef struct
+	{
+		uint64_t Timestamp;	/*!< micro seconds since epoch */
+		double Roll;	/*!< radians */
+		double Pitch;	/*!< radians */
+		double Yaw;	/*!< radians */
+		uint32_t Flags;	/*!< MHOrientationFlag_t */
+	}	MHOrientationSample;	/*!< orientation history entry, plain data stored inline */
+
+	typedef struct
+	{
+		uint64_t Timestamp;	/*!< newest sample, micro seconds since epoch */
+		size_t Count;	/*!< samples in estimate */
+		double Roll;	/*!< circular mean, radians -PI..PI */
+		double Pitch;	/*!< circular mean, radians -PI..PI */
+		double Yaw;	/*!< circular mean, radians -PI..PI */
+		double RollDeviation;	/*!< circular standard deviation of samples, radians */
+		double PitchDeviation;	/*!< circular standard deviation of samples, radians */
+		double YawDeviation;	/*!< circular standard deviation of samples, radians */
+	}	MHOrientationEstimate;	/*!< windowed orientation statistics, standard error of mean is about deviation/sqrt(Count) */
+
+	typedef enum
+	{
+		PollState_TRACKING=0,	/*!< telescope still or tracking, TELESCOPE_POLL_TRACKING */
+		PollState_SLEWING,	/*!< telescope moving, polling at sensor rate */
+		PollState_IDLE,	/*!< no motion for TELESCOPE_POLL_IDLEAFTER seconds, TELESCOPE_POLL_IDLE */
+		PollState_BACKOFF,	/*!< polls failing, exponential backoff */
+		PollState_COUNT,
+	}	MHPollState_t;	/*!< state of adaptive polling */
+
+	typedef struct
+	{
+		MHPollState_t State;	/*!< current state */
+		uint64_t Period;	/*!< current polling period, nano seconds */
+		uint64_t Transitions;	/*!< state changes */
+		uint64_t Failures;	/*!< failed polls */
+		uint64_t Polls[PollState_COUNT];	/*!< polls per state */
+		uint64_t Time[PollState_COUNT];	/*!< nano seconds per state */
+	}	MHPollStatistics;	/*!< published state of adaptive polling, to measure savings */
+
+	class MHPollScheduler
+	{
+	protected:	/* protected members are accessible from the same class or "friends" and derived classes */
+		MHPollStatistics Statistics;	/*!< state, written by polling thread */
+		rpiScope::SeqLock<MHPollStatistics> Published;	/*!< copy of Statistics for other threads */
+		MHPollState_t Resume;	/*!< state to return to after backoff */
+		uint64_t SensorPeriod;	/*!< poll interval reported by sensor, nano seconds */
+		uint64_t Backoff;	/*!< current backoff delay, nano seconds */
+		uint64_t LastUpdate;	/*!< time of last update, nano seconds */
+		uint64_t LastMotion;	/*!< time of last motion while slewing, nano seconds */
+		uint64_t StillSince;	/*!< begin of no motion while tracking, 0 for moving */
+		int MotionSamples;	/*!< consecutive samples above slew threshold */
+		void Enter(MHPollState_t state);	/*!< change state */
+
+	public:	/* public members are accessible from anywhere */
+		MHPollScheduler();	/*!< constructor */
+		void SetSensorInterval(int interval);	/*!< poll interval of sensor in milli seconds */
+		uint64_t Update(uint64_t now, bool polled, double motion, bool still);	/*!< next polling period in nano seconds, after poll at monotonic time now */
+		MHPollState_t GetState(void) const;	/*!< current state, polling thread only */
+		void GetStatistics(MHPollStatistics& statistics) const;	/*!< snapshot from any thread */
+	};
+
 	class MHTelescope
 		: public MHLogFile
 	{
@@ -56,7 +129,20 @@ namespace piScope
 	protected:	/* protected members are accessible from the same class or "friends" and derived classes */
 		char* Name;	/*!< Name of the telescope */
 		MHLocation* Location;	/*!< Location of the telescope */
-		std::deque<MHAstroVector*> Orientation;	/*!< Orientation of the telescope, deque for statistical precision */
+		MHTransform* Sky;	/*!< horizon to equator of Location, guarded by OrientationMutex */
+		MHOrientationSample Orientation[TELESCOPE_ORIENTATION_SIZE];	/*!< Orientation of the telescope, ring buffer for statistical precision */
+		uint64_t OrientationHead;	/*!< orientation samples pushed, next ring position */
+		uint64_t OrientationTail;	/*!< oldest orientation sample in ring */
+		pthread_mutex_t OrientationMutex;	/*!< guards ring between polling thread and readers */
+		double OrientationSin[3];	/*!< running sum of sine of roll, pitch, yaw in ring */
+		double OrientationCos[3];	/*!< running sum of cosine of roll, pitch, yaw in ring */
+		uint64_t OrientationRemoved;	/*!< samples left window since last exact recalculation */
+
+		//	running statistics, called with OrientationMutex locked
+		void OrientationEnter(const MHOrientationSample& sample);	/*!< add sample to running statistics, after head moved */
+		void OrientationLeave(const MHOrientationSample& sample);	/*!< remove sample from running statistics, after tail moved */
+		void OrientationRecalculate(void);	/*!< exact statistics of ring, bounds rounding drift */
+		void OrientationPrune(uint64_t now);	/*!< remove outdated or differing samples */
 
 	/*	RTIMULib members, for inertial measurement sensors
 	**	ImuSetting
@@ -72,6 +158,10 @@ namespace piScope
 		bool IMUpthread_running;	/*!< running flag for RTIMULib reading and handling thread */
 		pthread_t IMUpthread;	/*!< POSIX thread handler of RTIMULib reading and handling thread */
 		pthread_attr_t IMUpthread_attributes;	/*!< POSIX thread attributes of RTIMULib reading and handling thread */
+		rpiScope::Thread_Config IMUpthread_config;	/*!< scheduling, affinity and memory locking of RTIMULib reading thread */
+		rpiScope::Thread_Pacer IMUpthread_pacer;	/*!< absolute deadline pacing and jitter histogram of RTIMULib reading thread */
+		rpiScope::Metrics_Loop IMUpthread_metrics;	/*!< read duration, loop period, fusion time and orientation queue depth */
+		MHPollScheduler IMUpthread_scheduler;	/*!< adaptive poll rate of RTIMULib reading thread */
 		friend void *IMUpthread_Polling(void *data);	/*!< friend declaration for RTIMULib reading and handling thread */
 #	endif
 
@@ -85,6 +175,12 @@ namespace piScope
 		const char* ToString(void) const;	/*!< simple output function */
 		MHAstroVector* GetOrientation(void);	/*!< calculate current orientation from queue */
 		bool GetOrientation(double* RA, double* DEC);	/*!< calculate current orientation from queue */
+		bool GetOrientation(MHOrientationEstimate* estimate);	/*!< mean and deviation of queue, constant time */
+		size_t GetOrientationCount(void);	/*!< number of orientation samples in queue */
+
+		//	orientation history
+		void PushOrientation(double roll, double pitch, double yaw, uint64_t timestamp, uint32_t flags);	/*!< add orientation sample, oldest dropped if full */
+		void ClearOrientation(void);	/*!< remove all orientation samples */
 
 		//	preparation and manipulation methods
 		const char* SetName(const char* name);	/*!< set new Name */
@@ -100,6 +196,10 @@ namespace piScope
 		bool ImuNotMoving(void);	/*!< check RTIMULib sensor not showing movement*/
 		void IMUpthread_start(void);	/*!< start RTIMULib reading and handling thread */
 		void IMUpthread_stopp(void);	/*!< stop RTIMULib reading and handling thread */
+		void IMUpthread_configure(const rpiScope::Thread_Config& config);	/*!< real time configuration, before IMUpthread_start */
+		void IMUpthread_jitter(rpiScope::Thread_Jitter& jitter) const;	/*!< achieved polling period of RTIMULib reading thread */
+		const rpiScope::Metrics_Loop& GetIMUMetrics(void) const;	/*!< instrumentation of RTIMULib polling, take Snapshot */
+		void GetIMUPollState(MHPollStatistics& statistics) const;	/*!< adaptive polling state and time per state */
 #	endif
 
 	};
@@ -42,6 +42,7 @@ namespace piScope
 	MHTimeStamp::MHTimeStamp(MHTimeStamp* ts)
 	{
 		this->UTC = ts->UTC;
+		this->J2000ns = ts->J2000ns;
 	}
 	MHTimeStamp::MHTimeStamp(time_t ts)
 	{
@@ -55,19 +56,32 @@ namespace piScope
 	{
 		if(1 == ts)
 		{
-			this->UTC = time(NULL);
+			//	current system time with sub-second resolution
+			struct timespec now;
+			clock_gettime(CLOCK_REALTIME, &now);
+			this->SetJ2000(J2000_UTC2NS(now.tv_sec) + now.tv_nsec);
 		}
 		else
 		{
-			this->UTC = ts;
+			this->SetJ2000(J2000_UTC2NS(ts));
 		}
 		return(this->UTC);
 	}
+	int64_t MHTimeStamp::SetJ2000(int64_t ns)
+	{
+		this->J2000ns = ns;
+		this->UTC = J2000_NS2UTC(ns);
+		return(this->J2000ns);
+	}
 
 	time_t MHTimeStamp::Get(void) const
 	{
 		return(this->UTC);
 	}
+	int64_t MHTimeStamp::GetJ2000(void) const
+	{
+		return(this->J2000ns);
+	}
 	time_t MHTimeStamp::GetElapsed(time_t ts) const
 	{
 		time_t since = (1==ts ?time(NULL) :ts);
@@ -75,9 +89,13 @@ namespace piScope
 	}
 	double MHTimeStamp::GetJulianDate(int modified) const
 	{
-		double JD = (modified ?TIME_UTC2MJD(this->UTC) :TIME_UTC2JD(this->UTC));
+		double JD = (modified ?J2000_EPOCH_MJD :J2000_EPOCH_JD) + this->GetJ2000Days();
 		return(JD);
 	}
+	double MHTimeStamp::GetJ2000Days(void) const
+	{
+		return(J2000_NS2DAYS(this->J2000ns));
+	}
 
 	const char* MHTimeStamp::ToString(void) const
 	{
@@ -25,6 +25,7 @@
  *
  *	Declaration of class, members and methods.
  *	Special time data members and handling methods.
+ *	Time is kept in nano seconds since J2000.0 (UT), UTC seconds follow from it.
  */
 
 #ifndef _TIMESTAMP_HPP_
@@ -33,6 +34,7 @@
 #	include "../config.h"
 
 #	include <ctime>
+#	include <stdint.h>
 
 namespace piScope
 {
@@ -43,6 +45,7 @@ namespace piScope
 
 	protected:	/* protected members are accessible from the same class or "friends" and derived classes */
 		time_t UTC;	/*!< time data in UTC seconds since system epoch (1970-01-01.0000 on most systems) */
+		int64_t J2000ns;	/*!< time data in nano seconds since J2000.0 (2000-01-01.5000 UT), same instant as UTC */
 
 	public:	/* public members are accessible from anywhere */
 		//	constructor/destructor
@@ -52,11 +55,14 @@ namespace piScope
 
 		//	public manipulation methods
 		time_t Set(time_t ts =1);	/*!< set new time, ts==1 to get current system time */
+		int64_t SetJ2000(int64_t ns);	/*!< set new time in nano seconds since J2000.0 */
 
 		//	public access methods
 		time_t Get(void) const;	/*!< get time stamp (-1=UTC, 0=LMST, 1=GMST, 2=JD, 3=MJD) */
+		int64_t GetJ2000(void) const;	/*!< get time stamp in nano seconds since J2000.0 */
 		time_t GetElapsed(time_t ts =1) const;	/*!< get elapsed time since time stamp */
 		double GetJulianDate(int modified =false) const;	/*!< get Julian Date on prime meridian (0=JD, 1=MJD) */
+		double GetJ2000Days(void) const;	/*!< get days since J2000.0, sub-microsecond resolution */
 		const char* ToString(void) const;	/*!< get time stamp (-1=UTC, 0=LMST, 1=GMST, 2=JD, 3=MJD) */
 	};
 
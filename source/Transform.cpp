@@ -0,0 +1,119 @@
+/*
+**	Transform (.hpp/.cpp)
+**	horizontal to equatorial transformation pipeline
+**
+**	piScope project https://github.com/march42/piScope
+**	(C) Copyright 2017 by Marc Hefter
+**
+**	This program is free software; you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation; either version 3 of the License, or
+**	(at your option) any later version.
+**
+**	This program is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with this program; if not, write to the Free Software
+**	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+**	MA 02110-1301 USA.
+*/
+
+#include "Transform.hpp"
+#include "MACROS.h"
+
+//#include <unistd.h>
+//#include <cstdio>
+//#include <cstdlib>
+//#include <cstring>
+#include <cmath>
+#include <cassert>
+
+namespace piScope
+{
+
+	MHTransform::MHTransform(MHLocation* loc, bool j2000)
+		: Location(loc), J2000(j2000), Tick(0), Version(0)
+	{
+		assert(NULL != this->Location);
+	}
+	MHTransform::~MHTransform()
+	{
+	}
+
+	const MHRotation& MHTransform::Prepare(int64_t ns)
+	{
+		if(0 != this->Version && ns == this->Tick && this->Version == this->Location->GetSiderealRefreshs())
+		{
+			return(this->Horizon2Target);
+		}
+		//	horizon -> local equator (latitude) -> true equinox of date (apparent LST about pole) -> J2000
+		double last = this->Location->GetAngleLMST(ns) + this->Equinox.GetEquationOfEquinoxes(ns);
+		MHRotation sidereal = MHRotation::AxisZ(DEG2RAD(last));
+		this->Horizon2Target = sidereal.Multiply(this->Location->GetHorizon2Equator());
+		if(this->J2000)
+		{
+			this->Horizon2Target = this->Equinox.Date2J2000(ns).Multiply(this->Horizon2Target);
+		}
+		this->Tick = ns;
+		this->Version = this->Location->GetSiderealRefreshs();
+		return(this->Horizon2Target);
+	}
+
+	void MHTransform::Horizontal2HourAngle(double az, double alt, double* ha, double* dec) const
+	{
+		double horizon[3] = { cos(DEG2RAD(alt)) * sin(DEG2RAD(az)), cos(DEG2RAD(alt)) * cos(DEG2RAD(az)), sin(DEG2RAD(alt)) };
+		double equator[3];
+		this->Location->GetHorizon2Equator().Rotate(&horizon[0], &equator[0]);
+		//	y axis points east, hour angle grows to west
+		double angle = RAD2DEG(atan2(-equator[1], equator[0]));
+		*ha = DEGREE_WRAP(angle);
+		*dec = RAD2DEG(asin(fmax(-1.0, fmin(1.0, equator[2]))));
+	}
+	void MHTransform::Horizontal2Equatorial(double az, double alt, int64_t ns, double* ra, double* dec)
+	{
+		this->Horizontal2Equatorial(&az, &alt, ra, dec, 1, ns);
+	}
+	void MHTransform::Horizontal2Equatorial(const double* az, const double* alt, double* ra, double* dec, size_t count, int64_t ns)
+	{
+		const MHRotation& rotation = this->Prepare(ns);
+		for(size_t index=0; count>index; ++index)
+		{
+			double azimuth = DEG2RAD(az[index]);
+			double altitude = DEG2RAD(alt[index]);
+			double horizon[3] = { cos(altitude) * sin(azimuth), cos(altitude) * cos(azimuth), sin(altitude) };
+			double target[3];
+			rotation.Rotate(&horizon[0], &target[0]);
+			double angle = RAD2DEG(atan2(target[1], target[0]));
+			ra[index] = DEGREE_WRAP(angle);
+			dec[index] = RAD2DEG(asin(fmax(-1.0, fmin(1.0, target[2]))));
+		}
+	}
+	void MHTransform::Equatorial2Horizontal(double ra, double dec, int64_t ns, double* az, double* alt)
+	{
+		double target[3] = { cos(DEG2RAD(dec)) * cos(DEG2RAD(ra)), cos(DEG2RAD(dec)) * sin(DEG2RAD(ra)), sin(DEG2RAD(dec)) };
+		double horizon[3];
+		//	inverse rotation is the transposed matrix
+		this->Prepare(ns).Transpose().Rotate(&target[0], &horizon[0]);
+		double angle = RAD2DEG(atan2(horizon[0], horizon[1]));
+		*az = DEGREE_WRAP(angle);
+		*alt = RAD2DEG(asin(fmax(-1.0, fmin(1.0, horizon[2]))));
+	}
+	void MHTransform::Orientation2Equatorial(double roll, double pitch, double yaw, int64_t ns, double* ra, double* dec)
+	{
+		//	roll turns about the optical axis, pointing is azimuth=yaw and altitude=pitch
+		(void)roll;
+		this->Horizontal2Equatorial(RAD2DEG(yaw), RAD2DEG(pitch), ns, ra, dec);
+	}
+	void MHTransform::Convert(const double* x, const double* y, const double* z, double* outx, double* outy, double* outz, size_t count, int64_t ns)
+	{
+		this->Prepare(ns).Rotate(x, y, z, outx, outy, outz, count);
+	}
+	void MHTransform::ConvertInverse(const double* x, const double* y, const double* z, double* outx, double* outy, double* outz, size_t count, int64_t ns)
+	{
+		this->Prepare(ns).Transpose().Rotate(x, y, z, outx, outy, outz, count);
+	}
+
+};
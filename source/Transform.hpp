@@ -0,0 +1,80 @@
+/*
+**	Transform (.hpp/.cpp)
+**	horizontal to equatorial transformation pipeline
+**
+**	piScope project https://github.com/march42/piScope
+**	(C) Copyright 2017 by Marc Hefter
+**
+**	This program is free software; you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation; either version 3 of the License, or
+**	(at your option) any later version.
+**
+**	This program is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with this program; if not, write to the Free Software
+**	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+**	MA 02110-1301 USA.
+*/
+
+/*!	\brief	class MHTransform
+ *
+ *	Declaration of class, members and methods.
+ *	Pipeline from telescope orientation (LocalRPY) over horizon (azimuth, altitude)
+ *	and local equator (hour angle, declination) to equatorial coordinates.
+ *	MHLocation caches the latitude rotation, the sidereal rotation is cached here
+ *	per time stamp (tick), so a batch of pointing vectors needs one matrix.
+ *	Equinox of date is the true equator and equinox (apparent sidereal time),
+ *	J2000 adds precession and nutation, cached per PRECESSION_CACHE_SPAN.
+ *	Angles in degrees, azimuth from north over east.
+ */
+
+#ifndef _TRANSFORM_HPP_
+#	define _TRANSFORM_HPP_
+
+#	include "../config.h"
+#	include "Rotation.hpp"
+#	include "Location.hpp"
+#	include "Precession.hpp"
+
+#	include <cstddef>
+#	include <stdint.h>
+
+namespace piScope
+{
+
+	class MHTransform
+	{
+	private:	/* private members are accessible only from within the same class or "friends" */
+
+	protected:	/* protected members are accessible from the same class or "friends" and derived classes */
+		MHLocation* Location;	/*!< observer, owns latitude rotation and LMST cache */
+		bool J2000;	/*!< target frame J2000 instead of equinox of date */
+		MHPrecession Equinox;	/*!< precession and nutation of date */
+		MHRotation Horizon2Target;	/*!< combined rotation of cached tick */
+		int64_t Tick;	/*!< nano seconds since J2000.0 of cached rotation */
+		unsigned long Version;	/*!< location cache version of cached rotation, 0 = none */
+
+	public:	/* public members are accessible from anywhere */
+		//	constructor/destructor
+		MHTransform(MHLocation* loc, bool j2000 =false);	/*!< constructor, location must outlive transform */
+		~MHTransform();	/*!< destructor */
+
+		//	public conversion methods
+		const MHRotation& Prepare(int64_t ns);	/*!< get rotation from horizon (east, north, up) to target frame at nano seconds since J2000.0 */
+		void Horizontal2HourAngle(double az, double alt, double* ha, double* dec) const;	/*!< horizon to local equator, no time needed */
+		void Horizontal2Equatorial(double az, double alt, int64_t ns, double* ra, double* dec);	/*!< horizon to right ascension and declination */
+		void Horizontal2Equatorial(const double* az, const double* alt, double* ra, double* dec, size_t count, int64_t ns);	/*!< batch, one pass */
+		void Equatorial2Horizontal(double ra, double dec, int64_t ns, double* az, double* alt);	/*!< right ascension and declination to horizon */
+		void Orientation2Equatorial(double roll, double pitch, double yaw, int64_t ns, double* ra, double* dec);	/*!< LocalRPY radians, optical axis on X, yaw from north over east, pitch up */
+		void Convert(const double* x, const double* y, const double* z, double* outx, double* outy, double* outz, size_t count, int64_t ns);	/*!< batch of horizon vectors to target frame */
+		void ConvertInverse(const double* x, const double* y, const double* z, double* outx, double* outy, double* outz, size_t count, int64_t ns);	/*!< batch of target frame vectors (catalog) to horizon */
+	};
+
+};
+
+#endif	/* _TRANSFORM_HPP_ */
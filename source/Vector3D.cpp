@@ -132,9 +132,13 @@ namespace piScope
 			}
 			break;
 
-		case VectorType_ECEF:
-			//	checking to be implemented
 		case VectorType_J2000:
+			//	direction on celestial sphere, rotations by MHPrecession need no length
+			invalid |= !(std::isfinite(this->X) && std::isfinite(this->Y) && std::isfinite(this->Z));
+			invalid |= (0 == this->X && 0 == this->Y && 0 == this->Z);
+			break;
+
+		case VectorType_ECEF:
 			//	checking to be implemented
 			#if !defined(NDEBUG)
 				fprintf(stderr, "debug:\t%s:\t%s\n", "Vector3D::Validate", "VectorType checking, is not implemented");
@@ -3,6 +3,12 @@
 **	__TEST_I2CSENSOR__	tests for I2C IMU sensor
 **	__TEST_VECTOR__		tests for Vector classes
 **	__TEST_RTIMULIB__	tests for RTIMULib orientation sensing
+**	__TEST_I2CBUS__		tests for I2C bus transactions (loopback, no hardware)
+**	__TEST_IMUDATA__	tests and benchmarks for IMU data handling
+**	__TEST_IMUREPLAY__	tests and benchmarks for offline fusion of IMU logs
+**	__TEST_TELESCOPE__	tests for telescope orientation history (soak)
+**	__TEST_PACER__		tests for real time polling thread pacing and instrumentation
+**	__TEST_ASTROTIME__	tests for astronomical time and sidereal precision
 **
 **	piScope project https://github.com/march42/piScope
 **	(C) Copyright 2017 by Marc Hefter
@@ -28,24 +34,85 @@
  *	__TEST_I2CSENSOR__
  *	__TEST_VECTOR__
  *	__TEST_RTIMULIB__
+ *	__TEST_I2CBUS__
+ *	__TEST_IMUDATA__
+ *	__TEST_IMUREPLAY__
+ *	__TEST_TELESCOPE__
+ *	__TEST_PACER__
+ *	__TEST_ASTROTIME__
  */
 
 //#if defined(__TEST_I2CSENSOR__)
 #	include "I2Csensor.hpp"
+#	include "I2Cbus.hpp"
 #	include "IMU.hpp"
+#	include "IMUreplay.hpp"
+#	include "Pacer.hpp"
+#	include "Metrics.hpp"
 //#elif defined(__TEST_VECTOR__)
 #	include "AstroVector.hpp"
 //#elif defined(__TEST_RTIMULIB__)
 #	include "AstroTime.hpp"
 #	include "AstroVector.hpp"
+#	include "Transform.hpp"
+#	include "Precession.hpp"
 #	include "Telescope.hpp"
+#	include "MACROS.h"
 //#else
 //#	error "NO TARGET SPECIFIED FOR COMPILING: " __FILE__
 //#endif // defined(__TEST_I2CSENSOR__) || defined(__TEST_VECTOR__) || defined(__TEST_RTIMULIB__)
 
 #include <unistd.h>
 #include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <cmath>
 #include <iostream>
+#include <time.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <deque>
+#include <new>
+#include <atomic>
+
+static double test_seconds(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return(now.tv_sec + now.tv_nsec /1e9);
+}
+static uint64_t test_microseconds(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return((uint64_t)now.tv_sec *1000000 + now.tv_nsec /1000);
+}
+static double test_cputime(void)
+{
+	struct rusage usage;
+	getrusage(RUSAGE_THREAD, &usage);
+	return(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) /1e6);
+}
+
+//	count heap allocations of all test programs
+static std::atomic<unsigned long> test_allocations(0);
+void* operator new(size_t size)
+{
+	test_allocations.fetch_add(1, std::memory_order_relaxed);
+	void* memory = malloc(0 == size ?1 :size);
+	if(NULL == memory)
+		throw std::bad_alloc();
+	return(memory);
+}
+void operator delete(void* memory) noexcept
+{
+	free(memory);
+}
+void operator delete(void* memory, size_t size) noexcept
+{
+	free(memory);
+}
 
 static volatile bool keep_running = true;
 #ifdef WIN32
@@ -97,38 +164,33 @@ int test_i2csensor(int argc, char* argv[], char* envp[])
 		{
 			break;
 		}
-		rpiScope::IMU_Vector*	Acceleration = imu.IMUvalue.Acceleration();
-		rpiScope::IMU_Vector*	Gyroscope = imu.IMUvalue.Gyroscope();
-		rpiScope::IMU_Vector*	Magnetometer = imu.IMUvalue.Magnetometer();
-		rpiScope::IMU_Vector*	euler = imu.IMUvalue.Orientation();
-		rpiScope::IMU_Vector*	fusion = imu.IMUvalue.Fusion3D();
+		rpiScope::IMU_Vector	Acceleration, Gyroscope, Magnetometer, euler, fusion;
+		imu.IMUvalue.Acceleration(Acceleration);
+		imu.IMUvalue.Gyroscope(Gyroscope);
+		imu.IMUvalue.Magnetometer(Magnetometer);
+		imu.IMUvalue.Orientation(euler);
+		imu.IMUvalue.Fusion3D(fusion);
 #		if defined(DEBUG3)
-		std::cout << "\t" << "a=" << Acceleration->X << "," << Acceleration->Y << "," << Acceleration->Z
-			<< "\t" << "a=" << Acceleration->scaledX() << "," << Acceleration->scaledY() << "," << Acceleration->scaledZ()
+		std::cout << "\t" << "a=" << Acceleration.X << "," << Acceleration.Y << "," << Acceleration.Z
+			<< "\t" << "a=" << Acceleration.scaledX() << "," << Acceleration.scaledY() << "," << Acceleration.scaledZ()
 			<< std::endl;
-		std::cout << "\t" << "g=" << Gyroscope->X << "," << Gyroscope->Y << "," << Gyroscope->Z
-			<< "\t" << "g=" << Gyroscope->scaledX() << "," << Gyroscope->scaledY() << "," << Gyroscope->scaledZ()
+		std::cout << "\t" << "g=" << Gyroscope.X << "," << Gyroscope.Y << "," << Gyroscope.Z
+			<< "\t" << "g=" << Gyroscope.scaledX() << "," << Gyroscope.scaledY() << "," << Gyroscope.scaledZ()
 			<< std::endl;
-		std::cout << "\t" << "m=" << Magnetometer->X << "," << Magnetometer->Y << "," << Magnetometer->Z
-			<< "\t" << "m=" << Magnetometer->scaledX() << "," << Magnetometer->scaledY() << "," << Magnetometer->scaledZ()
+		std::cout << "\t" << "m=" << Magnetometer.X << "," << Magnetometer.Y << "," << Magnetometer.Z
+			<< "\t" << "m=" << Magnetometer.scaledX() << "," << Magnetometer.scaledY() << "," << Magnetometer.scaledZ()
 			<< std::endl;
 #		elif defined(DEBUG2)
 		std::cout
-			<< "\t" << "a=" << Acceleration->scaledX() << "," << Acceleration->scaledY() << "," << Acceleration->scaledZ()
-			<< "\t" << "g=" << Gyroscope->scaledX() << "," << Gyroscope->scaledY() << "," << Gyroscope->scaledZ()
-			<< "\t" << "m=" << Magnetometer->scaledX() << "," << Magnetometer->scaledY() << "," << Magnetometer->scaledZ()
+			<< "\t" << "a=" << Acceleration.scaledX() << "," << Acceleration.scaledY() << "," << Acceleration.scaledZ()
+			<< "\t" << "g=" << Gyroscope.scaledX() << "," << Gyroscope.scaledY() << "," << Gyroscope.scaledZ()
+			<< "\t" << "m=" << Magnetometer.scaledX() << "," << Magnetometer.scaledY() << "," << Magnetometer.scaledZ()
 			<< std::endl;
 #		endif
 		std::cout
-			<< "\t" << "E=" << euler->scaledX() << "," << euler->scaledY() << "," << euler->scaledZ()
-			<< "\t" << "F=" << fusion->scaledX() << "," << fusion->scaledY() << "," << fusion->scaledZ()
+			<< "\t" << "E=" << euler.scaledX() << "," << euler.scaledY() << "," << euler.scaledZ()
+			<< "\t" << "F=" << fusion.scaledX() << "," << fusion.scaledY() << "," << fusion.scaledZ()
 			<< std::endl;
-		//	free vector data
-		delete(Acceleration);
-		delete(Gyroscope);
-		delete(Magnetometer);
-		delete(euler);
-		delete(fusion);
 		sleep(1);
 	}
 	return(0);
@@ -219,62 +281,2493 @@ int test_rtimulib(int argc, char* argv[], char* envp[])
 	return(0);
 }
 
-int main(int argc, char* argv[], char* envp[])
+//	LSM9DS1 register file on loopback bus, WHO_AM_I and self clearing reboot bits
+//	magnetometer only auto increments with MSB of sub address set
+static void test_i2cbus_lsm9ds1(rpiScope::I2Cloopback* bus)
+{
+	bus->Subaddress(0x1C);
+	bus->Preset(0x6A, 0x0F, 0x68);	//	WHO_AM_I acc,gyro
+	bus->Preset(0x6A, 0x22, 0x04, 0x81);	//	CTRL_REG8, REBOOT and SW_RESET self clearing
+	bus->Preset(0x1C, 0x0F, 0x3D);	//	WHO_AM_I mag
+	bus->Preset(0x1C, 0x21, 0x00, 0x0C);	//	CTRL_REG2_M, REBOOT and SOFT_RST self clearing
+	for(int pos=0; 6>pos; ++pos)
+	{
+		bus->Preset(0x6A, 0x18+pos, 0x10+pos);	//	gyro
+		bus->Preset(0x6A, 0x28+pos, 0x20+pos);	//	acc
+		bus->Preset(0x1C, 0x28+pos, 0x30+pos);	//	mag
+	}
+}
+
+//	loopback bus with an adapter rejecting combined transactions
+class test_i2cbus_nordwr : public rpiScope::I2Cloopback
+{
+	public:
+		virtual int Ioctl(int fd, unsigned long request, void* argument)
+		{
+			if(I2C_RDWR == request)
+			{
+				++this->count_rdwr;
+				errno = EOPNOTSUPP;
+				return(-1);
+			}
+			return(rpiScope::I2Cloopback::Ioctl(fd, request, argument));
+		}
+};
+
+//	LSM9DS1 FIFO register stream simulator
+//	sample k of the stream is gyro (k,-k,3k) and acc (1000+k,-1000-k,16384), little endian
+class test_i2cbus_fifo : public rpiScope::I2Cloopback
+{
+	public:
+		int produced;	//	samples written to FIFO by sensor
+		int consumed;	//	samples read from FIFO
+		bool overrun;
+		test_i2cbus_fifo() : produced(0), consumed(0), overrun(false) {}
+		void Produce(int count)
+		{
+			this->produced += count;
+			if(I2C_FIFO_DEPTH < this->produced - this->consumed)
+			{
+				//	oldest samples overwritten
+				this->consumed = this->produced - I2C_FIFO_DEPTH;
+				this->overrun = true;
+			}
+		}
+		static int16_t Stream(int sample, int value)
+		{
+			switch(value)
+			{
+				case 0:	return(sample);
+				case 1:	return(-sample);
+				case 2:	return(3*sample);
+				case 3:	return(1000+sample);
+				case 4:	return(-1000-sample);
+				default:	return(16384);
+			}
+		}
+	protected:
+		virtual unsigned char ReadRegister(unsigned char i2caddress, unsigned char reg)
+		{
+			reg &= 0x7F;
+			if(0x6A != i2caddress || 0 == (this->Register(0x6A,0x23) & 0x02))
+			{
+				return(rpiScope::I2Cloopback::ReadRegister(i2caddress, reg));
+			}
+			if(0x2F == reg)
+			{
+				//	FIFO_SRC, threshold, overrun and unread samples
+				int unread = this->produced - this->consumed;
+				unsigned char value = (this->overrun ?0x40 :0x00) | ((this->Register(0x6A,0x2E) &0x1F) <= unread ?0x80 :0x00) | unread;
+				this->overrun = false;
+				return(value);
+			}
+			int16_t value = 0;
+			if(0x18 <= reg && 0x1D >= reg)
+			{
+				value = Stream(this->consumed, (reg -0x18) /2);
+			}
+			else if(0x28 <= reg && 0x2D >= reg)
+			{
+				value = Stream(this->consumed, 3 +(reg -0x28) /2);
+				if(0x2D == reg)
+				{
+					//	FIFO slot read completely
+					++this->consumed;
+				}
+			}
+			else
+			{
+				return(rpiScope::I2Cloopback::ReadRegister(i2caddress, reg));
+			}
+			return(0 == (reg &0x01) ?(value &0xFF) :((value >>8) &0xFF));
+		}
+};
+
+//	simulated data ready interrupt source, signalling eventfd with fixed rate
+typedef struct test_i2cbus_drdy
+{
+	int fd;	//	eventfd, -1 for time stamps only
+	int events;	//	number of interrupts
+	long period;	//	nano seconds
+	volatile uint64_t signaltime;	//	time stamp of last interrupt (micro seconds)
+	volatile bool done;
+}	test_i2cbus_drdy;
+static void* test_i2cbus_interrupt(void* data)
+{
+	test_i2cbus_drdy* drdy = (test_i2cbus_drdy*)data;
+	struct timespec next;
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	for(int event=0; drdy->events>event; ++event)
+	{
+		next.tv_nsec += drdy->period;
+		while(1000000000 <= next.tv_nsec)
+		{
+			next.tv_nsec -= 1000000000;
+			++next.tv_sec;
+		}
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+		drdy->signaltime = test_microseconds();
+		uint64_t one = 1;
+		if(0 <= drdy->fd && sizeof(one) != write(drdy->fd, &one, sizeof(one)))
+		{
+			perror("eventfd write failed");
+		}
+	}
+	drdy->done = true;
+	return(NULL);
+}
+
+//	reading thread, every register of gyro, acc and mag holds the same byte per reading
+typedef struct test_i2cbus_torn
+{
+	rpiScope::I2Cloopback* bus;
+	rpiScope::I2Csensor* imu;
+	unsigned long readings;
+	volatile bool done;
+}	test_i2cbus_torn;
+static void* test_i2cbus_tornwriter(void* data)
+{
+	test_i2cbus_torn* torn = (test_i2cbus_torn*)data;
+	while(!torn->done)
+	{
+		unsigned char value = (unsigned char)(++torn->readings);
+		for(int pos=0; 6>pos; ++pos)
+		{
+			torn->bus->Preset(0x6A, 0x18+pos, value);	//	gyro
+			torn->bus->Preset(0x6A, 0x28+pos, value);	//	acc
+			torn->bus->Preset(0x1C, 0x28+pos, value);	//	mag
+		}
+		torn->imu->I2Creadimu();
+	}
+	return(NULL);
+}
+
+int test_i2cbus(int argc, char* argv[], char* envp[])
 {
 	//	parameters may be unused
 	(void)argc;
+	(void)argv;
 	(void)envp;
-	//	programm greeting
-	std::cout << argv[0] << "\t" << "(build " << __DATE__ << ")" << std::endl;
+	int failed = 0;
+	const int samples = 100000;
 
-	// prepare signal handling
+	//	combined I2C_RDWR reading against SMBus reading
+	rpiScope::I2Cloopback bus;
+	test_i2cbus_lsm9ds1(&bus);
+	rpiScope::I2Csensor imu(rpiScope::I2C_AutoIdentify,-1,"/dev/i2c-loopback",&bus);
+	if(rpiScope::I2C_LSM9DS1 != imu.sensortype)
 	{
-#		ifdef WIN32
-		if (!SetConsoleCtrlHandler((PHANDLER_ROUTINE)signal_handler, TRUE))
+		fprintf(stdout, "I2Cbus:\tLSM9DS1 not identified on loopback\n");
+		return(1);
+	}
+	double rate[2] = {0,0};
+	double ioctls[2] = {0,0};
+	for(int combined=0; 2>combined; ++combined)
+	{
+		imu.I2Ccombined = (1 == combined);
+		unsigned long version = imu.DataVersion();
+		unsigned long count = bus.count_ioctl;
+		double start = test_seconds();
+		for(int sample=0; samples>sample; ++sample)
 		{
-			std::cerr << "SetConsoleCtrlHandler failed" << std::endl;
-			return 127;
+			imu.I2Creadimu();
 		}
-#		else
-		//	ignore SIGPIPE
-		signal(SIGPIPE, SIG_IGN);
-		signal(SIGINT, signal_handler);
-		signal(SIGTERM, signal_handler);
-		signal(SIGQUIT, signal_handler);
-		//	?keep running after SIGHUP
-		//signal(SIGHUP,signal_handler);
-#		endif
+		double duration = test_seconds() - start;
+		ioctls[combined] = (double)(bus.count_ioctl - count) / samples;
+		rate[combined] = samples / duration;
+		rpiScope::I2Cregisters registers;
+		imu.DataSnapshot(registers);
+		if((unsigned long)samples != imu.DataVersion() - version)
+		{
+			fprintf(stdout, "I2Cbus:\t%s published %lu of %d readings\n", (combined ?"I2C_RDWR" :"SMBus"), imu.DataVersion() - version, samples);
+			++failed;
+		}
+		for(int pos=0; 6>pos; ++pos)
+		{
+			if(0x10+pos != registers.Register[0x18+pos] || 0x20+pos != registers.Register[0x28+pos] || 0x30+pos != registers.Register[I2C_BUFFER_PAGESIZE +0x28+pos])
+			{
+				fprintf(stdout, "I2Cbus:\t%s data mismatch at byte %d\n", (combined ?"I2C_RDWR" :"SMBus"), pos);
+				++failed;
+				break;
+			}
+		}
+		fprintf(stdout, "I2Cbus:\t%-8s\t%.1f ioctl/sample\t%.0f samples/s\n", (combined ?"I2C_RDWR" :"SMBus"), ioctls[combined], rate[combined]);
+	}
+	if(1.0 != ioctls[1] || ioctls[0] <= ioctls[1])
+	{
+		fprintf(stdout, "I2Cbus:\tcombined reading should need exactly one ioctl per sample\n");
+		++failed;
 	}
 
-#	if defined(__TEST_I2CSENSOR__)
-		test_i2csensor(argc, argv, envp);
-#	elif defined(__TEST_VECTOR__)
-		test_vector(argc, argv, envp);
-#	elif defined(__TEST_RTIMULIB__)
-		test_rtimulib(argc, argv, envp);
-#	else
-	for(int pos = 1; argc > pos; ++pos)
+	//	capability probe once per opened bus, I2C_SLAVE only on address change
+	imu.I2Ccombined = false;
+	unsigned long funcs = bus.count_funcs;
+	unsigned long slave = bus.count_slave;
+	unsigned long saved = imu.I2CioctlsSaved();
+	for(int sample=0; 1000>sample; ++sample)
 	{
-		if(0 != strncmp(argv[pos],"--test",6))
+		imu.I2Creadimu();
+	}
+	if(funcs != bus.count_funcs || 2000 != bus.count_slave - slave || 2000 != imu.I2CioctlsSaved() - saved)
+	{
+		fprintf(stdout, "I2Cbus:\tI2C_FUNCS %lu, I2C_SLAVE %lu, saved %lu (expected 0, 2000, 2000)\n"
+			, bus.count_funcs - funcs, bus.count_slave - slave, imu.I2CioctlsSaved() - saved);
+		++failed;
+	}
+	funcs = bus.count_funcs;
+	imu.I2Cinitialize();	//	reopens bus
+	imu.I2Creadimu();
+	if(funcs +1 != bus.count_funcs)
+	{
+		fprintf(stdout, "I2Cbus:\tI2C_FUNCS not probed again after reopening bus\n");
+		++failed;
+	}
+	fprintf(stdout, "I2Cbus:\t%lu ioctl saved\t%.0f ioctl/s saved\n", imu.I2CioctlsSaved(), imu.I2CioctlsSavedRate());
+
+	//	register map, configuration only read when invalidated
+	imu.I2Cinvalidate(rpiScope::I2C_STATIC);
+	imu.I2Cinvalidate(rpiScope::I2C_CONFIG);
+	unsigned long bytes = bus.count_bytes;
+	unsigned long mapbytes = imu.register_bytes;
+	imu.I2Cread2buffer();
+	unsigned long fullbytes = bus.count_bytes - bytes;
+	bytes = bus.count_bytes;
+	unsigned long mapsaved = imu.register_saved;
+	for(int second=0; 10>second; ++second)
+	{
+		imu.I2Cread2buffer();
+	}
+	unsigned long deltabytes = (bus.count_bytes - bytes) /10;
+	if(73 != fullbytes || 26 != deltabytes || fullbytes + 10 *deltabytes != imu.register_bytes - mapbytes
+		|| 10 *(fullbytes - deltabytes) != imu.register_saved - mapsaved)
+	{
+		fprintf(stdout, "I2Cbus:\tregister map read %lu bytes full, %lu bytes delta, %lu saved\n", fullbytes, deltabytes, imu.register_saved - mapsaved);
+		++failed;
+	}
+	rpiScope::I2Cregisters mapregisters;
+	bus.Preset(0x6A, 0x20, 0b10011000);	//	acc full scale 8G
+	imu.I2Cread2buffer();
+	imu.DataSnapshot(mapregisters);
+	if(0b10011000 == mapregisters.Register[0x20])
+	{
+		fprintf(stdout, "I2Cbus:\tconfiguration read without invalidation\n");
+		++failed;
+	}
+	imu.I2Cinvalidate();
+	imu.I2Cread2buffer();
+	imu.DataSnapshot(mapregisters);
+	if(0b10011000 != mapregisters.Register[0x20])
+	{
+		fprintf(stdout, "I2Cbus:\tconfiguration not read after invalidation\n");
+		++failed;
+	}
+	//	merged magnetometer ranges, without auto increment bit the first register repeats
+	rpiScope::I2Cloopback strictbus;
+	test_i2cbus_lsm9ds1(&strictbus);
+	union i2c_smbus_data strictdata;
+	strictdata.block[0] = 6;
+	struct i2c_smbus_ioctl_data strictargs = {I2C_SMBUS_READ, 0x28, I2C_SMBUS_I2C_BLOCK_DATA, &strictdata};
+	strictbus.Ioctl(1000, I2C_SLAVE, (void*)0x1C);
+	strictbus.Ioctl(1000, I2C_SMBUS, &strictargs);
+	if(0x30 != strictdata.block[1] || 0x30 != strictdata.block[6])
+	{
+		fprintf(stdout, "I2Cbus:\tloopback auto increments magnetometer without sub address bit\n");
+		++failed;
+	}
+	for(int pos=0; 5>pos; ++pos)
+	{
+		bus.Preset(0x1C, 0x20+pos, 0x40 +4*pos);	//	CTRL_REG1_M .. CTRL_REG5_M
+	}
+	imu.I2Cinvalidate();
+	imu.I2Cread2buffer();
+	imu.DataSnapshot(mapregisters);
+	for(int pos=0; 6>pos; ++pos)
+	{
+		if((5>pos && 0x40 +4*pos != mapregisters.Register[I2C_BUFFER_PAGESIZE +0x20+pos]) || 0x30+pos != mapregisters.Register[I2C_BUFFER_PAGESIZE +0x28+pos])
 		{
-			//	not a program call
+			fprintf(stdout, "I2Cbus:\tmagnetometer register map mismatch at byte %d\n", pos);
+			++failed;
+			break;
 		}
-		else if(NULL != strstr(argv[pos],"i2csensor"))
+	}
+	for(int pos=0; 5>pos; ++pos)
+	{
+		bus.Preset(0x1C, 0x20+pos, 0x00);
+	}
+	bus.Preset(0x6A, 0x20, 0b10010000);
+	imu.I2Cinvalidate();
+	imu.I2Cread2buffer();
+	fprintf(stdout, "I2Cbus:\tLSM9DS1 register map\t%lu bytes full\t%lu bytes delta\t%lu bytes saved\n", fullbytes, deltabytes, imu.register_saved);
+
+	//	BNO055 pages, page 1 only with configuration
+	rpiScope::I2Cloopback bnobus;
+	bnobus.Preset(0x29, 0x00, 0xA0);	//	CHIP_ID
+	bnobus.Preset(0x29, 0x01, 0xFB);	//	ACC_ID
+	bnobus.Preset(0x29, 0x02, 0x32);	//	MAG_ID
+	bnobus.Preset(0x29, 0x03, 0x0F);	//	GYR_ID
+	rpiScope::I2Csensor bno(rpiScope::I2C_AutoIdentify,-1,"/dev/i2c-loopback",&bnobus);
+	bno.I2Cinvalidate(rpiScope::I2C_STATIC);
+	bno.I2Cinvalidate(rpiScope::I2C_CONFIG);
+	bytes = bnobus.count_bytes;
+	bno.I2Cread2buffer();
+	fullbytes = bnobus.count_bytes - bytes;
+	bytes = bnobus.count_bytes;
+	bno.I2Cread2buffer();
+	deltabytes = bnobus.count_bytes - bytes;
+	if(rpiScope::I2C_BNO055 != bno.sensortype || 131 != fullbytes || 51 != deltabytes || 0 != bnobus.Register(0x29, 0x07))
+	{
+		fprintf(stdout, "I2Cbus:\tBNO055 register map read %lu bytes full, %lu bytes delta\n", fullbytes, deltabytes);
+		++failed;
+	}
+	fprintf(stdout, "I2Cbus:\tBNO055 register map\t%lu bytes full\t%lu bytes delta\t(%d bytes whole pages)\n", fullbytes, deltabytes, 2*0x80 +1);
+
+	//	BNO055 NDOF fast path, fusion output in one burst, no host fusion
+	bnobus.Preset(0x29, 0x20, 15826 &0xFF);	//	quaternion W, yaw 30 degrees
+	bnobus.Preset(0x29, 0x21, 15826 >>8);
+	bnobus.Preset(0x29, 0x26, 4240 &0xFF);	//	quaternion Z
+	bnobus.Preset(0x29, 0x27, 4240 >>8);
+	bnobus.Preset(0x29, 0x32, 981 &0xFF);	//	gravity Z, 100LSB per m/s^2
+	bnobus.Preset(0x29, 0x33, 981 >>8);
+	bnobus.Preset(0x29, 0x28, 250 &0xFF);	//	linear acceleration X, 2.5 m/s^2
+	bnobus.Preset(0x29, 0x29, 250 >>8);
+	bnobus.Preset(0x29, 0x35, 0xFF);	//	CALIB_STAT fully calibrated
+	bytes = bnobus.count_bytes;
+	unsigned long bnoioctls = bnobus.count_ioctl;
+	double bnostart = test_cputime();
+	for(int sample=0; samples>sample; ++sample)
+	{
+		bno.I2Creadimu();
+	}
+	double bnotime = (test_cputime() - bnostart) / samples;
+	double bnobytes = (double)(bnobus.count_bytes - bytes) / samples;
+	double bnoioctl = (double)(bnobus.count_ioctl - bnoioctls) / samples;
+	rpiScope::IMU_Vector bnoeuler;
+	bno.IMUvalue.Orientation(bnoeuler);
+	rpiScope::IMU_Vector bnogravity;
+	bno.IMUvalue.Acceleration(bnogravity);
+	rpiScope::IMU_Vector bnolinear;
+	bno.IMUvalue.LinearAcceleration(bnolinear);
+	if(0x0C != bnobus.Register(0x29, 0x3D) || 22.0 != bnobytes || 1.0 != bnoioctl || 0xFF != bno.calibration
+		|| 0.01 < fabs(bnoeuler.Z - 30.0) || 0.01 < fabs(bnoeuler.X) || 0.01 < fabs(bnoeuler.Y) || 0.01 < fabs(bnogravity.scaledZ() - 981 /(100*9.80665))
+		|| 0.001 < fabs(bnolinear.scaledX() - 250 /(100*9.80665)) || 0.0 != bnolinear.scaledZ())
+	{
+		fprintf(stdout, "I2Cbus:\tBNO055 NDOF %.1f bytes/sample, %.1f ioctl/sample, yaw %.2f, gravity %.3fG\n", bnobytes, bnoioctl, bnoeuler.Z, bnogravity.scaledZ());
+		++failed;
+	}
+	//	reference, whole register map and host fusion of LSM9DS1
+	bytes = bnobus.count_bytes;
+	bnostart = test_cputime();
+	for(int sample=0; 10000>sample; ++sample)
+	{
+		bno.I2Cinvalidate(rpiScope::I2C_STATIC);
+		bno.I2Cinvalidate(rpiScope::I2C_CONFIG);
+		bno.I2Cread2buffer();
+	}
+	double fulltime = (test_cputime() - bnostart) / 10000;
+	double fullbnobytes = (double)(bnobus.count_bytes - bytes) / 10000;
+	double lsmstart = test_cputime();
+	for(int sample=0; samples>sample; ++sample)
+	{
+		imu.I2Creadimu();
+	}
+	double lsmtime = (test_cputime() - lsmstart) / samples;
+	fprintf(stdout, "I2Cbus:\tBNO055 NDOF\t%.0f bytes/sample\t%.2fus/sample\t(register map %.0f bytes %.2fus, LSM9DS1 host fusion %.2fus)\n"
+		, bnobytes, bnotime *1e6, fullbnobytes, fulltime *1e6, lsmtime *1e6);
+
+	//	two sensors on one bus, one thread and one combined transaction per round
+	rpiScope::I2Cloopback sharedbus;
+	test_i2cbus_lsm9ds1(&sharedbus);
+	rpiScope::I2Csensor mount(rpiScope::I2C_AutoIdentify,-1,"/dev/i2c-loopback",&sharedbus);
+	sharedbus.Preset(0x29, 0x00, 0xA0);	//	CHIP_ID
+	sharedbus.Preset(0x29, 0x01, 0xFB);	//	ACC_ID
+	sharedbus.Preset(0x29, 0x02, 0x32);	//	MAG_ID
+	sharedbus.Preset(0x29, 0x03, 0x0F);	//	GYR_ID
+	sharedbus.Preset(0x29, 0x20, 15826 &0xFF);	//	quaternion W, yaw 30 degrees
+	sharedbus.Preset(0x29, 0x21, 15826 >>8);
+	sharedbus.Preset(0x29, 0x26, 4240 &0xFF);	//	quaternion Z
+	sharedbus.Preset(0x29, 0x27, 4240 >>8);
+	rpiScope::I2Csensor tube(rpiScope::I2C_AutoIdentify,-1,"/dev/i2c-loopback",&sharedbus);
+	const int rounds = 50;
+	unsigned long ownioctls = sharedbus.count_ioctl;
+	for(int round=0; rounds>round; ++round)
+	{
+		mount.I2Creadimu();
+		tube.I2Creadimu();
+	}
+	ownioctls = sharedbus.count_ioctl - ownioctls;
+	rpiScope::I2Cbus manager("/dev/i2c-loopback", &sharedbus);
+	if(rpiScope::I2C_LSM9DS1 != mount.sensortype || rpiScope::I2C_BNO055 != tube.sensortype || !manager.Attach(&mount) || !manager.Attach(&tube) || 2 != manager.Devices())
+	{
+		fprintf(stdout, "I2Cbus:\tsensors not attached to bus manager\n");
+		++failed;
+	}
+	uint64_t busnow = rpiScope::Metrics_Loop::Now();
+	manager.Poll(busnow);	//	register buffers, data rates
+	unsigned long busioctls = sharedbus.count_ioctl;
+	unsigned long bustransactions = manager.transactions;
+	int bussamples = 0;
+	for(int round=0; rounds>round; ++round)
+	{
+		busnow += 10000000;
+		bussamples += manager.Poll(busnow);
+	}
+	busioctls = sharedbus.count_ioctl - busioctls;
+	rpiScope::I2Cregisters mountregisters;
+	mount.DataSnapshot(mountregisters);
+	rpiScope::IMU_Vector tubeeuler;
+	tube.IMUvalue.Orientation(tubeeuler);
+	if(2 *rounds != bussamples || (unsigned long)rounds != busioctls || (unsigned long)rounds != manager.transactions - bustransactions
+		|| 0x10 != mountregisters.Register[0x18] || 0x30 != mountregisters.Register[I2C_BUFFER_PAGESIZE +0x28] || 0.01 < fabs(tubeeuler.Z - 30.0))
+	{
+		fprintf(stdout, "I2Cbus:\tbus manager %d samples, %lu ioctl, %lu transactions in %d rounds\n", bussamples, busioctls, manager.transactions - bustransactions, rounds);
+		++failed;
+	}
+	fprintf(stdout, "I2Cbus:\t2 sensors\t%.1f ioctl/round own threads\t%.1f ioctl/round bus manager\n", (double)ownioctls / rounds, (double)busioctls / rounds);
+	//	bus thread, deadlines of 238Hz LSM9DS1 and 100Hz BNO055 interleaved
+	uint64_t mountreads = mount.metrics.Reads.Load();
+	uint64_t tubereads = tube.metrics.Reads.Load();
+	busioctls = sharedbus.count_ioctl;
+	bustransactions = manager.transactions;
+	double busstart = test_seconds();
+	manager.pthread_I2Creading();
+	usleep(500000);
+	manager.pthread_stopp();
+	double busduration = test_seconds() - busstart;
+	mountreads = mount.metrics.Reads.Load() - mountreads;
+	tubereads = tube.metrics.Reads.Load() - tubereads;
+	busioctls = sharedbus.count_ioctl - busioctls;
+	fprintf(stdout, "I2Cbus:\tbus thread\t%.0f+%.0f samples/s\t%lu transactions\t%.2f ioctl/sample\n"
+		, mountreads / busduration, tubereads / busduration, manager.transactions - bustransactions, (double)busioctls / (mountreads + tubereads));
+	if(238 *busduration /2 > mountreads || 100 *busduration /2 > tubereads || 238 *busduration *1.1 +2 < mountreads || busioctls >= mountreads + tubereads)
+	{
+		fprintf(stdout, "I2Cbus:\tbus thread read %llu and %llu samples in %.2fs\n", (unsigned long long)mountreads, (unsigned long long)tubereads, busduration);
+		++failed;
+	}
+	manager.Detach(&mount);
+	busioctls = sharedbus.count_ioctl;
+	mount.I2Creadimu();
+	if(1 != manager.Devices() || busioctls == sharedbus.count_ioctl)
+	{
+		fprintf(stdout, "I2Cbus:\tdetached sensor not reading on own file descriptor\n");
+		++failed;
+	}
+
+	//	adapter rejecting I2C_RDWR falls back to SMBus
+	test_i2cbus_nordwr smbus;
+	test_i2cbus_lsm9ds1(&smbus);
+	rpiScope::I2Csensor fallback(rpiScope::I2C_AutoIdentify,-1,"/dev/i2c-loopback",&smbus);
+	//	rejected reading is repeated with SMBus in the same call, fresh registers published once
+	smbus.Preset(0x6A, 0x18, 0x55);	//	gyro X_L
+	unsigned long fallbackversion = fallback.DataVersion();
+	uint64_t fallbackreads = fallback.metrics.Reads.Load();
+	fallback.I2Creadimu();
+	rpiScope::I2Cregisters fallbackregisters;
+	fallback.DataSnapshot(fallbackregisters);
+	rpiScope::IMU_Vector fallbackgyro;
+	fallback.IMUvalue.Gyroscope(fallbackgyro);
+	if(1 != smbus.count_rdwr || fallback.I2Ccombined || 1 != fallback.DataVersion() - fallbackversion || 1 != fallback.metrics.Reads.Load() - fallbackreads
+		|| 0x55 != fallbackregisters.Register[0x18] || 0x30 != fallbackregisters.Register[I2C_BUFFER_PAGESIZE +0x28] || 0x1155 != fallbackgyro.X)
+	{
+		fprintf(stdout, "I2Cbus:\tno SMBus fallback after failed I2C_RDWR (%lu published, gyro X 0x%04X)\n", fallback.DataVersion() - fallbackversion, (int)fallbackgyro.X);
+		++failed;
+	}
+	smbus.Preset(0x6A, 0x18, 0x10);
+	fallback.I2Creadimu();
+	fallback.DataSnapshot(fallbackregisters);
+	if(1 != smbus.count_rdwr || 0x10 != fallbackregisters.Register[0x18])
+	{
+		fprintf(stdout, "I2Cbus:\tI2C_RDWR tried again after SMBus fallback\n");
+		++failed;
+	}
+	//	bus manager, full transaction rejected, no further I2C_RDWR for remaining sensors
+	test_i2cbus_nordwr rejecting;
+	test_i2cbus_lsm9ds1(&rejecting);
+	rpiScope::I2Cbus rejectingmanager("/dev/i2c-loopback", &rejecting);
+	rpiScope::I2Csensor* crowd[I2C_BUS_DEVICES];
+	unsigned long crowdversion[I2C_BUS_DEVICES];
+	for(int index=0; I2C_BUS_DEVICES>index; ++index)
+	{
+		crowd[index] = new rpiScope::I2Csensor(rpiScope::I2C_AutoIdentify,-1,"/dev/i2c-loopback",&rejecting);
+		rejectingmanager.Attach(crowd[index]);
+	}
+	uint64_t crowdnow = rpiScope::Metrics_Loop::Now();
+	rejectingmanager.Poll(crowdnow);	//	register buffers
+	for(int index=0; I2C_BUS_DEVICES>index; ++index)
+	{
+		crowdversion[index] = crowd[index]->DataVersion();
+	}
+	uint64_t crowdfailures = rejectingmanager.metrics.Failures.Load();
+	unsigned long crowdrdwr = rejecting.count_rdwr;
+	rejecting.Preset(0x6A, 0x18, 0x55);	//	gyro X_L, new value read in rejected round
+	int crowdread = rejectingmanager.Poll(crowdnow +1000000000);
+	int crowdpublished = 0;
+	for(int index=0; I2C_BUS_DEVICES>index; ++index)
+	{
+		rpiScope::I2Cregisters crowdregisters;
+		crowd[index]->DataSnapshot(crowdregisters);
+		crowdpublished += (1 == crowd[index]->DataVersion() - crowdversion[index] && 0x55 == crowdregisters.Register[0x18]
+			&& 0x30 == crowdregisters.Register[I2C_BUFFER_PAGESIZE +0x28] && !crowd[index]->I2Ccombined ?1 :0);
+	}
+	if(I2C_BUS_DEVICES != crowdread || I2C_BUS_DEVICES != crowdpublished || 1 != rejectingmanager.metrics.Failures.Load() - crowdfailures
+		|| 1 != rejecting.count_rdwr - crowdrdwr)
+	{
+		fprintf(stdout, "I2Cbus:\trejected bus transaction, %d of %d sensors read fresh registers, %llu failed transactions, %lu I2C_RDWR\n"
+			, crowdpublished, I2C_BUS_DEVICES, (unsigned long long)(rejectingmanager.metrics.Failures.Load() - crowdfailures), rejecting.count_rdwr - crowdrdwr);
+		++failed;
+	}
+	for(int index=0; I2C_BUS_DEVICES>index; ++index)
+	{
+		rejectingmanager.Detach(crowd[index]);
+		delete(crowd[index]);
+	}
+
+	//	FIFO continuous mode, draining recorded register stream
+	test_i2cbus_fifo fifo;
+	test_i2cbus_lsm9ds1(&fifo);
+	rpiScope::I2Csensor fifoimu(rpiScope::I2C_AutoIdentify,-1,"/dev/i2c-loopback",&fifo);
+	if(!fifoimu.FIFOstart() || (0xC0 | I2C_FIFO_WATERMARK) != fifo.Register(0x6A,0x2E) || 0 == (fifo.Register(0x6A,0x23) & 0x02))
+	{
+		fprintf(stdout, "I2Cbus:\tFIFO continuous mode not configured\n");
+		++failed;
+	}
+	rpiScope::I2Cfifosample fifosamples[I2C_FIFO_DEPTH];
+	uint64_t lasttime = 0;
+	int expected = 0;
+	unsigned long drainioctls = fifo.count_ioctl;
+	uint64_t drainreads = fifoimu.metrics.Reads.Load();
+	int drains = 0;
+	double period = 0;
+	double fifogyroscale = 0;
+	double fifoaccscale = 0;
+	double fifomagscale = 0;
+	fifoimu.IMUvalue.GetFullScale(fifogyroscale, fifoaccscale, fifomagscale);
+	for(int round=0; 20>round; ++round)
+	{
+		usleep(1000);	//	far faster than 238Hz filling, but time stamps need 1us per sample
+		fifo.Produce(I2C_FIFO_WATERMARK);
+		int count = fifoimu.FIFOdrain(&fifosamples[0]);
+		++drains;
+		if(0 == round)
 		{
-			test_i2csensor(argc, argv, envp);
+			//	nominal spacing, later drains come faster than the FIFO fills
+			period = (fifosamples[I2C_FIFO_WATERMARK-1].timestamp - fifosamples[0].timestamp) / (I2C_FIFO_WATERMARK -1.0);
 		}
-		else if(NULL != strstr(argv[pos],"vector"))
+		if(I2C_FIFO_WATERMARK != count)
 		{
-			test_vector(argc, argv, envp);
+			fprintf(stdout, "I2Cbus:\tFIFO drained %d samples, expected %d\n", count, I2C_FIFO_WATERMARK);
+			++failed;
+			break;
 		}
-		else if(NULL != strstr(argv[pos],"rtimulib"))
+		for(int pos=0; count>pos; ++pos, ++expected)
 		{
-			test_rtimulib(argc, argv, envp);
+			if(fifosamples[pos].gyro[0] != test_i2cbus_fifo::Stream(expected,0) || fifosamples[pos].gyro[2] != test_i2cbus_fifo::Stream(expected,2)
+				|| fifosamples[pos].acc[1] != test_i2cbus_fifo::Stream(expected,4) || fifosamples[pos].acc[2] != test_i2cbus_fifo::Stream(expected,5))
+			{
+				fprintf(stdout, "I2Cbus:\tFIFO sample %d does not match register stream\n", expected);
+				++failed;
+				round = 20;
+				break;
+			}
+			if(1e-5 < fabs(fifosamples[pos].gyroscaled[2] - fifosamples[pos].gyro[2] *fifogyroscale) || 1e-5 < fabs(fifosamples[pos].accscaled[1] - fifosamples[pos].acc[1] *fifoaccscale))
+			{
+				fprintf(stdout, "I2Cbus:\tFIFO sample %d not scaled by full scale\n", expected);
+				++failed;
+				round = 20;
+				break;
+			}
+			if(lasttime >= fifosamples[pos].timestamp)
+			{
+				fprintf(stdout, "I2Cbus:\tFIFO time stamp of sample %d not increasing\n", expected);
+				++failed;
+				round = 20;
+				break;
+			}
+			lasttime = fifosamples[pos].timestamp;
+		}
+	}
+	if(1.0 < fabs(period - 1000000.0/238))
+	{
+		fprintf(stdout, "I2Cbus:\tFIFO sample period %.1fus, expected %.1fus\n", period, 1000000.0/238);
+		++failed;
+	}
+	if(lasttime > test_microseconds())
+	{
+		fprintf(stdout, "I2Cbus:\tFIFO time stamps %.1fms ahead of clock\n", (lasttime - test_microseconds()) /1000.0);
+		++failed;
+	}
+	fprintf(stdout, "I2Cbus:\tFIFO\t%.1f samples/wakeup\t%.2f ioctl/sample\t%.1fus period\n"
+		, (double)fifoimu.fifo_samples / drains, (double)(fifo.count_ioctl - drainioctls) / fifoimu.fifo_samples, period);
+	//	recording drained samples for IMU_Replay, one drain and the overrun below
+	char recordfile[] = "/tmp/test_i2cbus.XXXXXX";
+	int recordfd = mkstemp(&recordfile[0]);
+	bool recording = (0 <= recordfd && 0 == close(recordfd) && fifoimu.IMUrecordStart(&recordfile[0]));
+	int recordfirst = expected;
+	fifo.Produce(I2C_FIFO_WATERMARK);
+	fifoimu.FIFOdrain();
+	++drains;
+	expected += I2C_FIFO_WATERMARK;
+	//	overrun, oldest samples lost and reported
+	fifo.Produce(I2C_FIFO_DEPTH +8);
+	int count = fifoimu.FIFOdrain(&fifosamples[0]);
+	if(I2C_FIFO_DEPTH != count || 1 != fifoimu.fifo_overruns || test_i2cbus_fifo::Stream(expected +8,0) != fifosamples[0].gyro[0])
+	{
+		fprintf(stdout, "I2Cbus:\tFIFO overrun not handled (%d samples, %lu overruns)\n", count, fifoimu.fifo_overruns);
+		++failed;
+	}
+	fifoimu.IMUrecordStop();
+	rpiScope::IMU_Replay recorded;
+	if(!recording || I2C_FIFO_WATERMARK +I2C_FIFO_DEPTH != fifoimu.IMUrecorded() || !recorded.Open(&recordfile[0]) || I2C_FIFO_WATERMARK +I2C_FIFO_DEPTH != recorded.Samples())
+	{
+		fprintf(stdout, "I2Cbus:\tFIFO recording has %zu of %d records\n", fifoimu.IMUrecorded(), I2C_FIFO_WATERMARK +I2C_FIFO_DEPTH);
+		++failed;
+	}
+	else
+	{
+		const rpiScope::IMU_LogRecord* records = recorded.Records();
+		const rpiScope::IMU_LogRecord& overrun = records[I2C_FIFO_WATERMARK];
+		if(IMU_LOG_FIFO != records[0].Flags || (IMU_LOG_FIFO | IMU_LOG_MAGNETOMETER_HELD) != records[1].Flags
+			|| (IMU_LOG_FIFO | IMU_LOG_OVERRUN) != overrun.Flags || (IMU_LOG_FIFO | IMU_LOG_MAGNETOMETER_HELD) != records[I2C_FIFO_WATERMARK +1].Flags
+			|| test_i2cbus_fifo::Stream(recordfirst,0) != records[0].Gyroscope.X || test_i2cbus_fifo::Stream(recordfirst,5) != records[0].Acceleration.Z
+			|| test_i2cbus_fifo::Stream(expected +8,0) != overrun.Gyroscope.X || 0x3130 != records[1].Magnetometer.X
+			|| records[I2C_FIFO_WATERMARK -1].Timestamp >= overrun.Timestamp || 238.0 != recorded.Header()->SampleRate)
+		{
+			fprintf(stdout, "I2Cbus:\tFIFO recording does not match drained samples\n");
+			++failed;
 		}
+		recorded.SetThreads(1);
+		if(recorded.Samples() != recorded.Run())
+		{
+			fprintf(stdout, "I2Cbus:\tFIFO recording not replayed\n");
+			++failed;
+		}
+	}
+	recorded.Close();
+	unlink(&recordfile[0]);
+	//	instrumentation of drains, queue depth is FIFO level
+	rpiScope::Metrics_HistogramSnapshot* depth = new rpiScope::Metrics_HistogramSnapshot;
+	fifoimu.metrics.QueueDepth.Snapshot(*depth);
+	if((uint64_t)drains +1 != fifoimu.metrics.Reads.Load() -drainreads || 1 != fifoimu.metrics.Missed.Load() || I2C_FIFO_WATERMARK != depth->Min || I2C_FIFO_DEPTH != depth->Max)
+	{
+		fprintf(stdout, "I2Cbus:\tFIFO metrics wrong (%llu reads, queue %llu..%llu)\n", (unsigned long long)fifoimu.metrics.Reads.Load(), (unsigned long long)depth->Min, (unsigned long long)depth->Max);
+		++failed;
+	}
+	delete(depth);
+	fifoimu.FIFOstop();
+	if(0 != fifo.Register(0x6A,0x2E) || 0 != (fifo.Register(0x6A,0x23) & 0x02) || -1 != fifoimu.FIFOdrain())
+	{
+		fprintf(stdout, "I2Cbus:\tFIFO not stopped\n");
+		++failed;
 	}
-#	endif // defined(__TEST_I2CSENSOR__) || defined(__TEST_VECTOR__) || defined(__TEST_RTIMULIB__)
 
-	//	done
-	fprintf(stdout, "Bye.\n");
-	return(0);
+	//	register snapshots while reading thread overwrites buffer, no torn values
+	rpiScope::I2Cloopback tornbus;
+	test_i2cbus_lsm9ds1(&tornbus);
+	rpiScope::I2Csensor tornimu(rpiScope::I2C_AutoIdentify,-1,"/dev/i2c-loopback",&tornbus);
+	test_i2cbus_torn torn;
+	torn.bus = &tornbus;
+	torn.imu = &tornimu;
+	torn.readings = 0;
+	torn.done = false;
+	rpiScope::I2Cregisters* snapshot = new rpiScope::I2Cregisters;
+	unsigned long snapshots = 0;
+	unsigned long changes = 0;
+	unsigned long tornreads = 0;
+	unsigned char last = 0;
+	pthread_t tornwriter;
+	pthread_create(&tornwriter, NULL, test_i2cbus_tornwriter, &torn);
+	double tornstart = test_seconds();
+	while(1.0 > test_seconds() - tornstart)
+	{
+		tornimu.DataSnapshot(*snapshot);
+		++snapshots;
+		unsigned char value = snapshot->Register[0x18];
+		for(int pos=0; 6>pos; ++pos)
+		{
+			if(value != snapshot->Register[0x18+pos] || value != snapshot->Register[0x28+pos] || value != snapshot->Register[I2C_BUFFER_PAGESIZE +0x28+pos])
+			{
+				++tornreads;
+				break;
+			}
+		}
+		if(value != last)
+		{
+			++changes;
+			last = value;
+		}
+	}
+	torn.done = true;
+	pthread_join(tornwriter, NULL);
+	delete(snapshot);
+	fprintf(stdout, "I2Cbus:\tsnapshot\t%lu readings\t%lu snapshots\t%lu changes seen\t%lu torn\n", torn.readings, snapshots, changes, tornreads);
+	if(0 != tornreads || 0 == changes || tornimu.DataVersion() < torn.readings)
+	{
+		fprintf(stdout, "I2Cbus:\tregister snapshot not consistent\n");
+		++failed;
+	}
+
+	//	data ready interrupt against usleep polling, same 1kHz sample rate
+	for(int interrupt=0; 2>interrupt; ++interrupt)
+	{
+		test_i2cbus_drdy drdy;
+		drdy.fd = (interrupt ?eventfd(0, EFD_NONBLOCK) :-1);
+		drdy.events = 1000;
+		drdy.period = 1000000;
+		drdy.signaltime = 0;
+		drdy.done = false;
+		if(interrupt && (!imu.DRDYattach(drdy.fd) || 0b00000010 != bus.Register(0x6A,0x0C)))
+		{
+			fprintf(stdout, "I2Cbus:\tDRDY interrupt not enabled\n");
+			++failed;
+		}
+		unsigned long events = imu.drdy_events;
+		long reads = 0;
+		double latency = 0;
+		double maxlatency = 0;
+		double cpu = test_cputime();
+		double start = test_seconds();
+		pthread_t producer;
+		pthread_create(&producer, NULL, test_i2cbus_interrupt, &drdy);
+		while(!drdy.done)
+		{
+			if(interrupt)
+			{
+				if(1 != imu.DRDYwait(I2C_DRDY_TIMEOUT))
+					continue;
+			}
+			else
+			{
+				usleep(drdy.period /1000);
+			}
+			imu.I2Creadimu();
+			uint64_t signaltime = drdy.signaltime;
+			if(0 != signaltime && imu.IMUvalue.GetSampleTime() >= signaltime)
+			{
+				double delay = imu.IMUvalue.GetSampleTime() - signaltime;
+				latency += delay;
+				maxlatency = (delay > maxlatency ?delay :maxlatency);
+				++reads;
+			}
+		}
+		pthread_join(producer, NULL);
+		double duration = test_seconds() - start;
+		cpu = test_cputime() - cpu;
+		fprintf(stdout, "I2Cbus:\t%-8s\t%ld reads/%d samples\t%.0fus mean latency\t%.0fus max latency\t%.1f%% CPU\n"
+			, (interrupt ?"DRDY" :"usleep"), reads, drdy.events, (0 < reads ?latency / reads :0), maxlatency, 100.0 * cpu / duration);
+		if(interrupt)
+		{
+			if(drdy.events < reads || drdy.events /2 > reads || imu.drdy_events - events < (unsigned long)reads)
+			{
+				fprintf(stdout, "I2Cbus:\tDRDY should read once per interrupt\n");
+				++failed;
+			}
+			imu.DRDYdetach();
+			close(drdy.fd);
+			if(0 != bus.Register(0x6A,0x0C) || imu.DRDYattached())
+			{
+				fprintf(stdout, "I2Cbus:\tDRDY interrupt not disabled\n");
+				++failed;
+			}
+		}
+	}
+	if(imu.DRDYattach("/nonexistent/gpio/value"))
+	{
+		fprintf(stdout, "I2Cbus:\tDRDY attached to nonexistent gpio\n");
+		++failed;
+	}
+
+	fprintf(stdout, "I2Cbus:\t%s\n", (0 == failed ?"OK" :"FAILED"));
+	return(0 == failed ?0 :1);
+}
+
+//	fuse a static sensor tilted by roll degrees, one filter per thread
+struct test_imudata_ahrs
+{
+	rpiScope::IMU_AHRS ahrs;
+	double roll;
+	static void* Fuse(void* arg)
+	{
+		test_imudata_ahrs* test = (test_imudata_ahrs*)arg;
+		double ay = std::sin(test->roll *M_PI /180.0);
+		double az = std::cos(test->roll *M_PI /180.0);
+		for(int count=1; 20000>=count; ++count)
+		{
+			//	irregular sample times, 5ms and 15ms
+			test->ahrs.Update(0.0,0.0,0.0, 0.0,ay,az, 0.4,0.0,-0.3, 1000000 +(uint64_t)count *10000 +(count &1) *5000);
+		}
+		return(NULL);
+	}
+};
+
+//	IMU_Data before lock free ring buffer, deque guarded by mutex (benchmark reference)
+class test_imudata_deque
+{
+	public:
+		test_imudata_deque() : LPF_MaxValues(32)	{ pthread_mutex_init(&this->mutex, NULL); }
+		~test_imudata_deque()	{ pthread_mutex_destroy(&this->mutex); }
+		void Push(int16_t X, int16_t Y, int16_t Z)
+		{
+			rpiScope::IMU_Vector value(X,Y,Z);
+			pthread_mutex_lock(&this->mutex);
+			this->LPF_Values.push_back(value);
+			while(this->LPF_MaxValues < this->LPF_Values.size())
+			{
+				this->LPF_Values.pop_front();
+			}
+			pthread_mutex_unlock(&this->mutex);
+		}
+		rpiScope::IMU_Vector* vector(void)
+		{
+			double X = 0;
+			double Y = 0;
+			double Z = 0;
+			pthread_mutex_lock(&this->mutex);
+			size_t count = this->LPF_Values.size();
+			for(size_t pos=0; count>pos; ++pos)
+			{
+				X += this->LPF_Values[pos].X;
+				Y += this->LPF_Values[pos].Y;
+				Z += this->LPF_Values[pos].Z;
+			}
+			if(0 < count)
+			{
+				X /= count;
+				Y /= count;
+				Z /= count;
+			}
+			pthread_mutex_unlock(&this->mutex);
+			return(new rpiScope::IMU_Vector(X, Y, Z));
+		}
+	protected:
+		size_t LPF_MaxValues;
+		std::deque<rpiScope::IMU_Vector> LPF_Values;
+		pthread_mutex_t mutex;
+};
+
+//	one producer pushing samples (X=Y=Z), readers averaging until producer is done
+template <typename T> struct test_imudata_contention
+{
+	T* data;
+	int samples;
+	volatile bool done;
+	double pushduration;
+	unsigned long reads[2];
+	unsigned long torn;
+	static void* Producer(void* arg)
+	{
+		test_imudata_contention* bench = (test_imudata_contention*)arg;
+		double start = test_seconds();
+		for(int sample=0; bench->samples>sample; ++sample)
+		{
+			int16_t value = (sample &0x3FFF);
+			bench->data->Push(value, value, value);
+		}
+		bench->pushduration = test_seconds() - start;
+		bench->done = true;
+		return(NULL);
+	}
+	static void* Reader(void* arg)
+	{
+		test_imudata_contention* bench = ((test_imudata_contention**)arg)[0];
+		int reader = (((test_imudata_contention**)arg)[1] == NULL ?0 :1);
+		while(!bench->done)
+		{
+			rpiScope::IMU_Vector* value = bench->data->vector();
+			if(value->X != value->Y || value->Y != value->Z)
+			{
+				__sync_fetch_and_add(&bench->torn, 1);
+			}
+			delete(value);
+			++bench->reads[reader];
+		}
+		return(NULL);
+	}
+	void Run(const char* name)
+	{
+		this->done = false;
+		this->reads[0] = this->reads[1] = 0;
+		this->torn = 0;
+		void* readerargs[2][2] = {{this,NULL},{this,this}};
+		pthread_t producer, readers[2];
+		double start = test_seconds();
+		pthread_create(&readers[0], NULL, Reader, &readerargs[0][0]);
+		pthread_create(&readers[1], NULL, Reader, &readerargs[1][0]);
+		pthread_create(&producer, NULL, Producer, this);
+		pthread_join(producer, NULL);
+		pthread_join(readers[0], NULL);
+		pthread_join(readers[1], NULL);
+		double duration = test_seconds() - start;
+		fprintf(stdout, "IMUdata:\t%-12s\t%.2f Mpush/s\t%.2f Mread/s (2 readers)\t%lu torn\n"
+			, name, this->samples / this->pushduration /1e6, (this->reads[0] + this->reads[1]) / duration /1e6, this->torn);
+	}
+};
+
+int test_imudata(int argc, char* argv[], char* envp[])
+{
+	//	parameters may be unused
+	(void)argc;
+	(void)argv;
+	(void)envp;
+	int failed = 0;
+
+	//	running sum against recalculated window average, including resize
+	rpiScope::IMU_Data data;
+	std::deque<int> history;
+	size_t windows[] = {32, 4, 300, 5, 257, 1, 1024};
+	int sample = 0;
+	for(size_t resize=0; sizeof(windows)/sizeof(windows[0])>resize; ++resize)
+	{
+		data.LPF_resize(windows[resize]);
+		for(int count=0; 1500>count; ++count, ++sample)
+		{
+			int16_t value = (int16_t)((sample *7919) %65536 -32768);
+			data.Push(value, -value/2, 1);
+			history.push_back(value);
+			while(IMU_BUFFER_SIZE < history.size())
+			{
+				history.pop_front();
+			}
+			size_t window = (windows[resize] < history.size() ?windows[resize] :history.size());
+			double sum = 0;
+			for(size_t pos=history.size() -window; history.size()>pos; ++pos)
+			{
+				sum += history[pos];
+			}
+			rpiScope::IMU_Vector* value3 = data.vector();
+			if(1e-9 < fabs(value3->X - sum /window) || value != data.rawX() || 1.0 != value3->Z)
+			{
+				fprintf(stdout, "IMUdata:\twindow %lu sample %d average %f expected %f\n", (unsigned long)windows[resize], sample, value3->X, sum /window);
+				++failed;
+				count = 1500;
+				resize = sizeof(windows);
+			}
+			delete(value3);
+		}
+	}
+
+	//	reader position, continuous and after overrun
+	uint64_t position = data.Pushed() -10;
+	rpiScope::IMU_Sample samples[IMU_BUFFER_SIZE];
+	if(10 != data.Read(&samples[0], IMU_BUFFER_SIZE, position) || data.Pushed() != position || samples[9].X != data.rawX())
+	{
+		fprintf(stdout, "IMUdata:\tRead of 10 latest samples failed\n");
+		++failed;
+	}
+	position = 0;
+	if(IMU_BUFFER_SIZE -1 != data.Read(&samples[0], IMU_BUFFER_SIZE, position) || data.Pushed() != position)
+	{
+		fprintf(stdout, "IMUdata:\tRead after overrun should return the samples not overwritten\n");
+		++failed;
+	}
+
+	//	IIR step response, y(n) = 1000*(1-(1-alpha)^n)
+	rpiScope::IMU_Data iir;
+	iir.LPF_IIR(0.125);
+	iir.Push(0, 0, 0);
+	for(int count=1; 200>count; ++count)
+	{
+		iir.Push(1000, -1000, 0);
+		rpiScope::IMU_Vector* value3 = iir.vector();
+		double expected = 1000.0 *(1.0 -pow(1.0 -0.125, count));
+		if(1e-6 < fabs(value3->X -expected) || 1e-6 < fabs(value3->Y +expected))
+		{
+			fprintf(stdout, "IMUdata:\tIIR sample %d value %f expected %f\n", count, value3->X, expected);
+			++failed;
+			count = 200;
+		}
+		delete(value3);
+	}
+
+	//	FIR against direct convolution, unity gain of low pass taps
+	double taps[IMU_FIR_MAXTAPS];
+	size_t ntaps = rpiScope::IMU_Data::LPF_lowpass(&taps[0], 31, 0.1);
+	double gain = 0.0;
+	for(size_t tap=0; ntaps>tap; ++tap)
+	{
+		gain += taps[tap];
+	}
+	if(31 != ntaps || 1e-12 < fabs(gain -1.0) || 1e-12 < fabs(taps[0] -taps[30]) || taps[15] <= taps[14])
+	{
+		fprintf(stdout, "IMUdata:\tlow pass taps not symmetric or gain %f\n", gain);
+		++failed;
+	}
+	if(rpiScope::IMU_Data::LPF_lowpass(&taps[0], IMU_FIR_MAXTAPS +1, 0.1) || data.LPF_FIR(&taps[0], IMU_FIR_MAXTAPS +1))
+	{
+		fprintf(stdout, "IMUdata:\tFIR with too many taps accepted\n");
+		++failed;
+	}
+	rpiScope::IMU_Data fir;
+	fir.LPF_FIR(&taps[0], ntaps);
+	std::deque<int> recent;
+	for(int count=0; 2000>count; ++count)
+	{
+		int16_t value = (int16_t)((count *7919) %4096 -2048);
+		fir.Push(value, 100, value);
+		recent.push_front(value);
+		double expected = 0.0;
+		for(size_t tap=0; ntaps>tap; ++tap)
+		{
+			expected += taps[tap] *(tap < recent.size() ?recent[tap] :recent.back());
+		}
+		rpiScope::IMU_Vector* value3 = fir.vector();
+		if(1e-9 < fabs(value3->X -expected) || 1e-9 < fabs(value3->Y -100.0))
+		{
+			fprintf(stdout, "IMUdata:\tFIR sample %d value %f expected %f\n", count, value3->X, expected);
+			++failed;
+			count = 2000;
+		}
+		delete(value3);
+	}
+	//	back to moving average, window recalculated from ring
+	fir.LPF_resize(3);
+	fir.Push(30, 30, 30);
+	rpiScope::IMU_Vector* average = fir.vector();
+	if(1e-9 < fabs(average->X -(30.0 +recent[0] +recent[1]) /3.0))
+	{
+		fprintf(stdout, "IMUdata:\tmoving average after FIR %f\n", average->X);
+		++failed;
+	}
+	delete(average);
+
+	//	cost per sample and per read, independent of moving average window
+	const char* filtername[] = {"average 4", "average 1000", "IIR", "FIR 31 taps"};
+	double readcost[4];
+	for(int filter=0; 4>filter; ++filter)
+	{
+		rpiScope::IMU_Data bench;
+		if(0 == filter || 1 == filter)
+			bench.LPF_resize(0 == filter ?4 :1000);
+		else if(2 == filter)
+			bench.LPF_IIR(0.05);
+		else
+			bench.LPF_FIR(&taps[0], ntaps);
+		double start = test_seconds();
+		for(int count=0; 1000000>count; ++count)
+		{
+			bench.Push((int16_t)count, 0, 0);
+		}
+		double pushtime = test_seconds() -start;
+		double sum = 0.0;
+		start = test_seconds();
+		for(int count=0; 1000000>count; ++count)
+		{
+			rpiScope::IMU_Vector* value3 = bench.vector();
+			sum += value3->X;
+			delete(value3);
+		}
+		readcost[filter] = test_seconds() -start;
+		fprintf(stdout, "IMUdata:\t%-12s\t%6.1f ns/push\t%6.1f ns/read\t(%g)\n", filtername[filter], pushtime *1e3, readcost[filter] *1e3, sum /1e6);
+	}
+	if(readcost[1] > 3.0 *readcost[0] +0.05)
+	{
+		fprintf(stdout, "IMUdata:\treading window 1000 is slower than window 4\n");
+		++failed;
+	}
+
+	//	batch conversion against per sample path (register pair, IMU_Vector, scaled)
+	{
+		const size_t convertsamples = 1000000;
+		const double fullscale = 0.061 /1000;
+		unsigned char* raw = new unsigned char[convertsamples *6];
+		float* batch = new float[convertsamples *3];
+		double* single = new double[convertsamples *3];
+		for(size_t pos=0; convertsamples *6>pos; ++pos)
+		{
+			raw[pos] = (unsigned char)((pos *2654435761u) >>13);
+		}
+		//	touch output pages before timing
+		memset(&batch[0], 0x00, convertsamples *3 *sizeof(float));
+		memset(&single[0], 0x00, convertsamples *3 *sizeof(double));
+		rpiScope::IMU_MARGdata marg;
+		marg.SetFullScale(8.75 /1000, fullscale, 0.14 /1000);
+		for(int bigendian=0; 2>bigendian; ++bigendian)
+		{
+			double start = test_seconds();
+			for(size_t pos=0; convertsamples>pos; ++pos)
+			{
+				const unsigned char* buffer = &raw[pos *6];
+				int16_t value[3];
+				for(int axis=0; 3>axis; ++axis)
+				{
+					if(bigendian)
+						value[axis] = (int16_t)((buffer[axis*2] <<8) | buffer[axis*2+1]);
+					else
+						value[axis] = (int16_t)((buffer[axis*2+1] <<8) | buffer[axis*2]);
+				}
+				rpiScope::IMU_Vector value3(value[0], value[1], value[2], fullscale);
+				single[pos] = value3.scaledX();
+				single[convertsamples +pos] = value3.scaledY();
+				single[2*convertsamples +pos] = value3.scaledZ();
+			}
+			double singletime = test_seconds() -start;
+			start = test_seconds();
+			marg.ConvertAcceleration(&raw[0], convertsamples, 0 != bigendian, &batch[0], &batch[convertsamples], &batch[2*convertsamples]);
+			double batchtime = test_seconds() -start;
+			size_t mismatch = 0;
+			for(size_t pos=0; convertsamples *3>pos; ++pos)
+			{
+				if(1e-6 *fabs(single[pos]) +1e-12 < fabs(batch[pos] -single[pos]))
+					++mismatch;
+			}
+			fprintf(stdout, "IMUdata:\tconvert %s\t%6.2f ns/sample per sample\t%6.2f ns/sample batch\t%zu mismatch\n", (bigendian ?"big endian" :"little endian"), singletime *1e3, batchtime *1e3, mismatch);
+			if(0 != mismatch)
+				++failed;
+		}
+		//	tail handling, count not multiple of SIMD width
+		float tail[3][13];
+		rpiScope::IMU_Data::Convert(&raw[6], 13, false, 2.0f, &tail[0][0], &tail[1][0], &tail[2][0]);
+		if(tail[0][12] != 2.0f *(int16_t)((raw[6+72+1] <<8) | raw[6+72]) || tail[2][12] != 2.0f *(int16_t)((raw[6+76+1] <<8) | raw[6+76]))
+		{
+			fprintf(stdout, "IMUdata:\tconvert tail samples wrong\n");
+			++failed;
+		}
+		delete[](raw);
+		delete[](batch);
+		delete[](single);
+	}
+
+	//	read and fuse cycle without heap allocation
+	{
+		rpiScope::IMU_MARGdata marg(8);
+		marg.SetFullScale(8.75 /1000, 0.061 /1000, 0.14 /1000);
+		rpiScope::IMU_Vector acc, gyro, mag, euler, fusion;
+		unsigned long before = test_allocations.load();
+		for(int count=0; 1000>count; ++count)
+		{
+			marg.PushGyroscope((int16_t)(count %50), 3, -7);
+			marg.PushAcceleration(120, (int16_t)(-count %300), 16000);
+			marg.PushMagnetometer(2000, -1500, (int16_t)(count %400));
+			marg.Acceleration(acc);
+			marg.Gyroscope(gyro);
+			marg.Magnetometer(mag);
+			marg.Orientation(euler);
+			marg.Fusion3D(fusion);
+		}
+		unsigned long cycles = test_allocations.load() -before;
+		//	pointer API allocates the result only
+		before = test_allocations.load();
+		rpiScope::IMU_Vector* pointer = marg.Fusion3D();
+		unsigned long single = test_allocations.load() -before;
+		fprintf(stdout, "IMUdata:\t%lu allocations in 1000 read/fuse cycles, %lu by Fusion3D()\n", cycles, single);
+		if(0 != cycles || 1 != single || pointer->X != fusion.X || pointer->Y != fusion.Y || pointer->Z != fusion.Z || pointer->FullScale != fusion.FullScale)
+		{
+			fprintf(stdout, "IMUdata:\tread/fuse cycle allocates or differs from pointer API\n");
+			++failed;
+		}
+		delete(pointer);
+	}
+
+	//	Madgwick filter, integration step from time stamps
+	{
+		//	nominal rate 1000Hz for first sample (1ms), then samples 5ms and 15ms apart, 90dps yaw for 1.001s
+		rpiScope::IMU_AHRS ahrs(1000.0, 0.0);
+		uint64_t timestamp = 5000000;
+		for(int count=0; 100>=count; ++count)
+		{
+			ahrs.Update(0.0,0.0,M_PI/2, 0.0,0.0,1.0, 0.0,0.0,0.0, timestamp);
+			timestamp += (count &1 ?15000 :5000);
+		}
+		rpiScope::IMU_Vector euler;
+		ahrs.Euler(euler);
+		fprintf(stdout, "IMUdata:\tAHRS yaw %f after 1.001s at 90dps\n", euler.Z);
+		if(0.01 < fabs(euler.Z -90.09) || 101 != ahrs.Updates())
+		{
+			fprintf(stdout, "IMUdata:\tAHRS did not integrate by time stamps\n");
+			++failed;
+		}
+		//	two sensors fused in parallel threads, independent state
+		test_imudata_ahrs tube, mount;
+		tube.roll = 30.0;
+		mount.roll = -10.0;
+		pthread_t thread[2];
+		pthread_create(&thread[0], NULL, test_imudata_ahrs::Fuse, &tube);
+		pthread_create(&thread[1], NULL, test_imudata_ahrs::Fuse, &mount);
+		pthread_join(thread[0], NULL);
+		pthread_join(thread[1], NULL);
+		rpiScope::IMU_Vector tubeeuler, mounteuler;
+		tube.ahrs.Euler(tubeeuler);
+		mount.ahrs.Euler(mounteuler);
+		fprintf(stdout, "IMUdata:\tAHRS roll %f and %f\n", tubeeuler.X, mounteuler.X);
+		if(0.1 < fabs(tubeeuler.X -30.0) || 0.1 < fabs(mounteuler.X +10.0) || 0.1 < fabs(tubeeuler.Y) || 0.1 < fabs(mounteuler.Y))
+		{
+			fprintf(stdout, "IMUdata:\tAHRS instances did not converge independently\n");
+			++failed;
+		}
+	}
+
+	//	contention benchmark, ring buffer against deque with mutex
+	test_imudata_contention<test_imudata_deque> reference;
+	reference.data = new test_imudata_deque();
+	reference.samples = 2000000;
+	reference.Run("deque+mutex");
+	test_imudata_contention<rpiScope::IMU_Data> ring;
+	ring.data = new rpiScope::IMU_Data();
+	ring.samples = 2000000;
+	ring.Run("ring");
+	if(0 != ring.torn)
+	{
+		fprintf(stdout, "IMUdata:\ttorn reads from ring buffer\n");
+		++failed;
+	}
+	delete(reference.data);
+	delete(ring.data);
+
+	fprintf(stdout, "IMUdata:\t%s\n", (0 == failed ?"OK" :"FAILED"));
+	return(0 == failed ?0 :1);
+}
+
+int test_imureplay(int argc, char* argv[], char* envp[])
+{
+	//	parameters may be unused
+	(void)argc;
+	(void)argv;
+	(void)envp;
+	int failed = 0;
+
+	//	recorded session, 100Hz, sensor rolling +-20 degrees once a minute
+	const size_t samples = 1000000;
+	const double rate = 100.0;
+	rpiScope::IMU_LogHeader header;
+	memset(&header, 0x00, sizeof(header));
+	header.SampleRate = rate;
+	header.FullScaleGyroscope = 8.75 /1000;
+	header.FullScaleAcceleration = 0.061 /1000;
+	header.FullScaleMagnetometer = 0.14 /1000;
+	rpiScope::IMU_LogRecord* records = new rpiScope::IMU_LogRecord[samples];
+	double* truth = new double[samples];
+	memset(records, 0x00, samples *sizeof(rpiScope::IMU_LogRecord));
+	for(size_t pos=0; samples>pos; ++pos)
+	{
+		double time = pos /rate;
+		double roll = 20.0 *std::sin(2.0 *M_PI *time /60.0);
+		double rollrate = 20.0 *2.0 *M_PI /60.0 *std::cos(2.0 *M_PI *time /60.0);
+		double radroll = roll *M_PI /180.0;
+		truth[pos] = roll;
+		records[pos].Timestamp = 1000000 +(uint64_t)(pos *1000000 /rate);
+		records[pos].Gyroscope.X = (int16_t)round(rollrate /header.FullScaleGyroscope);
+		records[pos].Acceleration.Y = (int16_t)round(std::sin(radroll) /header.FullScaleAcceleration);
+		records[pos].Acceleration.Z = (int16_t)round(std::cos(radroll) /header.FullScaleAcceleration);
+		records[pos].Magnetometer.X = (int16_t)round(0.4 /header.FullScaleMagnetometer);
+		records[pos].Magnetometer.Y = (int16_t)round(-0.3 *std::sin(radroll) /header.FullScaleMagnetometer);
+		records[pos].Magnetometer.Z = (int16_t)round(-0.3 *std::cos(radroll) /header.FullScaleMagnetometer);
+	}
+	char logfile[] = "/tmp/test_imureplay.XXXXXX";
+	int fd = mkstemp(&logfile[0]);
+	if(0 > fd)
+	{
+		perror("test_imureplay log file");
+		return(1);
+	}
+	close(fd);
+	rpiScope::IMU_Replay replay;
+	if(!rpiScope::IMU_Replay::Write(&logfile[0], header, records, samples) || !replay.Open(&logfile[0]) || samples != replay.Samples())
+	{
+		fprintf(stdout, "IMUreplay:\twriting and opening log failed\n");
+		++failed;
+	}
+	if(replay.Open("/proc/self/cmdline"))
+	{
+		fprintf(stdout, "IMUreplay:\tlog without header accepted\n");
+		++failed;
+	}
+	replay.Open(&logfile[0]);
+	unlink(&logfile[0]);
+
+	//	Madgwick, single thread against shards with warm-up
+	rpiScope::IMU_Vector* single = new rpiScope::IMU_Vector[samples];
+	rpiScope::IMU_Vector* sharded = new rpiScope::IMU_Vector[samples];
+	const size_t warmup = 3000;
+	replay.SetFusion(rpiScope::IMU_ReplayMadgwick);
+	replay.SetGain(0.1);
+	replay.SetThreads(1);
+	replay.Run(&single[0]);
+	double singlerate = replay.SamplesPerSecond();
+	//	at least 4 shards, also on single core machines
+	int threads = (4 < sysconf(_SC_NPROCESSORS_ONLN) ?sysconf(_SC_NPROCESSORS_ONLN) :4);
+	replay.SetThreads(threads);
+	replay.SetWarmup(warmup);
+	replay.Run(&sharded[0]);
+	double shardedrate = replay.SamplesPerSecond();
+	double shardmismatch = 0.0;
+	double trackingerror = 0.0;
+	for(size_t pos=warmup; samples>pos; ++pos)
+	{
+		shardmismatch = fmax(shardmismatch, fmax(fabs(single[pos].X -sharded[pos].X), fabs(single[pos].Y -sharded[pos].Y)));
+		trackingerror = fmax(trackingerror, fabs(sharded[pos].X -truth[pos]));
+	}
+	fprintf(stdout, "IMUreplay:\tMadgwick\t%.2f Msamples/s 1 thread\t%.2f Msamples/s %d threads\t%.1f hours/s\n"
+		, singlerate /1e6, shardedrate /1e6, replay.ThreadsUsed(), shardedrate /rate /3600);
+	fprintf(stdout, "IMUreplay:\tMadgwick\tshards differ %g degrees, roll error %g degrees\n", shardmismatch, trackingerror);
+	if(1e-3 < shardmismatch || 1.0 < trackingerror)
+	{
+		fprintf(stdout, "IMUreplay:\tsharded Madgwick replay differs from single thread or truth\n");
+		++failed;
+	}
+
+	//	Fusion3D, warm-up of low pass window gives same results
+	replay.SetFusion(rpiScope::IMU_ReplayFusion3D);
+	replay.SetLPF(16);
+	replay.SetThreads(1);
+	replay.Run(&single[0]);
+	singlerate = replay.SamplesPerSecond();
+	replay.SetThreads(threads);
+	replay.SetWarmup(16);
+	replay.Run(&sharded[0]);
+	shardedrate = replay.SamplesPerSecond();
+	size_t different = 0;
+	for(size_t pos=0; samples>pos; ++pos)
+	{
+		if(single[pos].X != sharded[pos].X || single[pos].Y != sharded[pos].Y || single[pos].Z != sharded[pos].Z)
+			++different;
+	}
+	fprintf(stdout, "IMUreplay:\tFusion3D\t%.2f Msamples/s 1 thread\t%.2f Msamples/s %d threads\t%zu different\n"
+		, singlerate /1e6, shardedrate /1e6, replay.ThreadsUsed(), different);
+	if(0 != different)
+	{
+		fprintf(stdout, "IMUreplay:\tsharded Fusion3D replay differs from single thread\n");
+		++failed;
+	}
+
+	delete[](single);
+	delete[](sharded);
+	delete[](records);
+	delete[](truth);
+	fprintf(stdout, "IMUreplay:\t%s\n", (0 == failed ?"OK" :"FAILED"));
+	return(0 == failed ?0 :1);
+}
+
+static long test_residentpages(void)
+{
+	long size = 0, resident = 0;
+	FILE* statm = fopen("/proc/self/statm", "r");
+	if(NULL != statm)
+	{
+		if(2 != fscanf(statm, "%ld %ld", &size, &resident))
+			resident = 0;
+		fclose(statm);
+	}
+	return(resident);
+}
+int test_telescope(int argc, char* argv[], char* envp[])
+{
+	//	parameters may be unused
+	(void)argc;
+	(void)argv;
+	(void)envp;
+	int failed = 0;
+	piScope::MHTelescope* scope = new piScope::MHTelescope("test_telescope");
+
+	//	empty history
+	double RA = 0, DEC = 0;
+	if(0 != scope->GetOrientationCount() || scope->GetOrientation(&RA, &DEC))
+	{
+		fprintf(stdout, "Telescope:\tempty orientation history not detected\n");
+		++failed;
+	}
+
+	//	soak, multi-night session at 100Hz, queried once a second
+	const uint64_t samples = 10000000;
+	const uint64_t interval = 10000;	//	micro seconds
+	const uint64_t query = 100;
+	uint64_t now = (uint64_t)time(NULL) *1000000;
+	uint64_t start = now - samples *interval;
+	long resident = test_residentpages();	//	first call pages in stdio
+	unsigned long pushallocations = 0, firstquery = 0, lastquery = 0;
+	size_t maxcount = 0;
+	double elapsed = test_seconds();
+	for(uint64_t pos=0; samples>pos; ++pos)
+	{
+		double noise = (pos &1 ?0.001 :-0.001);
+		unsigned long before = test_allocations.load();
+		scope->PushOrientation(0.5 +noise, 0.25 -noise, 1.5 +noise, start +pos *interval, piScope::OrientationFlag_ACCEL | piScope::OrientationFlag_GYRO);
+		pushallocations += test_allocations.load() -before;
+		if(0 != (pos +1) %query)
+			continue;
+		size_t count = scope->GetOrientationCount();
+		if(maxcount < count)
+			maxcount = count;
+		before = test_allocations.load();
+		piScope::MHAstroVector* vec = scope->GetOrientation();
+		delete(vec);
+		unsigned long allocations = test_allocations.load() -before;
+		if(0 == firstquery)
+			firstquery = allocations;
+		lastquery = allocations;
+		if(0 != firstquery && firstquery != allocations)
+		{
+			fprintf(stdout, "Telescope:\tquery %llu allocated %lu instead of %lu\n", (unsigned long long)pos, allocations, firstquery);
+			++failed;
+			break;
+		}
+		//	resident memory after first hour
+		if(360000 == pos +1)
+			resident = test_residentpages();
+	}
+	elapsed = test_seconds() -elapsed;
+	long growth = test_residentpages() -resident;
+	fprintf(stdout, "Telescope:\t%llu samples in %f s\tmax %zu in history\t%lu allocations per query\t%ld pages growth\n"
+		, (unsigned long long)samples, elapsed, maxcount, lastquery, growth);
+	if(0 != pushallocations)
+	{
+		fprintf(stdout, "Telescope:\t%lu allocations pushing orientation\n", pushallocations);
+		++failed;
+	}
+	if(TELESCOPE_ORIENTATION_SIZE < maxcount)
+	{
+		fprintf(stdout, "Telescope:\torientation history not bounded\n");
+		++failed;
+	}
+	if(0 < growth)
+	{
+		fprintf(stdout, "Telescope:\tresident memory grew by %ld pages\n", growth);
+		++failed;
+	}
+
+	//	average of recent samples
+	piScope::MHAstroVector* vec = scope->GetOrientation();
+	fprintf(stdout, "Telescope:\taverage %f,%f,%f of %zu samples\n", vec->GetX(), vec->GetY(), vec->GetZ(), scope->GetOrientationCount());
+	if(piScope::VectorType_LocalRPY != vec->GetType() || 1e-6 < fabs(vec->GetX() -0.5) || 1e-6 < fabs(vec->GetY() -0.25) || 1e-6 < fabs(vec->GetZ() -1.5))
+	{
+		fprintf(stdout, "Telescope:\taverage orientation wrong\n");
+		++failed;
+	}
+	delete(vec);
+
+	//	outdated samples removed, minimum of 100 kept
+	scope->ClearOrientation();
+	for(uint64_t pos=0; 500>pos; ++pos)
+	{
+		scope->PushOrientation(1.0, 1.0, 1.0, now -(1000 -pos) *1000000, 0);
+	}
+	delete(scope->GetOrientation());
+	if(100 != scope->GetOrientationCount())
+	{
+		fprintf(stdout, "Telescope:\t%zu outdated samples kept\n", scope->GetOrientationCount());
+		++failed;
+	}
+	scope->ClearOrientation();
+	vec = scope->GetOrientation();
+	if(0 != scope->GetOrientationCount() || piScope::VectorType_INVALID != vec->GetType())
+	{
+		fprintf(stdout, "Telescope:\tclearing orientation history failed\n");
+		++failed;
+	}
+	delete(vec);
+
+	//	running statistics against exact mean and deviation of window, after many wraps
+	{
+		const size_t pushed = 50 *TELESCOPE_ORIENTATION_SIZE +37;
+		double* roll = new double[pushed];
+		double* yaw = new double[pushed];
+		uint32_t seed = 12345;
+		for(size_t pos=0; pushed>pos; ++pos)
+		{
+			seed = seed *1103515245 +12345;
+			double noise = ((seed >>8) %10000) /10000.0 -0.5;
+			roll[pos] = 0.75 +0.006 *noise;
+			yaw[pos] = -2.0 +0.01 *noise;
+			scope->PushOrientation(roll[pos], 0.3, yaw[pos], now -(pushed -pos) *1000, 0);
+		}
+		piScope::MHOrientationEstimate estimate;
+		unsigned long before = test_allocations.load();
+		bool valid = scope->GetOrientation(&estimate);
+		unsigned long allocations = test_allocations.load() -before;
+		double sinroll = 0, cosroll = 0, sinyaw = 0, cosyaw = 0;
+		for(size_t pos=pushed -estimate.Count; pushed>pos; ++pos)
+		{
+			sinroll += sin(roll[pos]);
+			cosroll += cos(roll[pos]);
+			sinyaw += sin(yaw[pos]);
+			cosyaw += cos(yaw[pos]);
+		}
+		double meanroll = atan2(sinroll, cosroll);
+		double meanyaw = atan2(sinyaw, cosyaw);
+		double devroll = sqrt(-2.0 *log(hypot(sinroll, cosroll) /estimate.Count));
+		double devyaw = sqrt(-2.0 *log(hypot(sinyaw, cosyaw) /estimate.Count));
+		fprintf(stdout, "Telescope:\testimate %zu samples roll %f+-%f yaw %f+-%f pitch deviation %g\n"
+			, estimate.Count, estimate.Roll, estimate.RollDeviation, estimate.Yaw, estimate.YawDeviation, estimate.PitchDeviation);
+		if(!valid || TELESCOPE_ORIENTATION_SIZE != estimate.Count || 0 != allocations
+			|| 1e-12 < fabs(estimate.Roll -meanroll) || 1e-12 < fabs(estimate.Yaw -meanyaw) || 1e-12 < fabs(estimate.Pitch -0.3)
+			|| 1e-9 < fabs(estimate.RollDeviation -devroll) || 1e-9 < fabs(estimate.YawDeviation -devyaw) || 1e-6 < estimate.PitchDeviation)
+		{
+			fprintf(stdout, "Telescope:\trunning statistics differ from exact (mean %f,%f deviation %f,%f)\n", meanroll, meanyaw, devroll, devyaw);
+			++failed;
+		}
+		//	query cost independent of history length
+		double rate[2];
+		for(int full=0; 2>full; ++full)
+		{
+			scope->ClearOrientation();
+			size_t count = (full ?TELESCOPE_ORIENTATION_SIZE :100);
+			for(size_t pos=0; count>pos; ++pos)
+			{
+				scope->PushOrientation(roll[pos], 0.3, yaw[pos], now, 0);
+			}
+			const int queries = 1000000;
+			double elapsed = test_seconds();
+			for(int query=0; queries>query; ++query)
+			{
+				scope->GetOrientation(&estimate);
+			}
+			rate[full] = queries /(test_seconds() -elapsed);
+		}
+		fprintf(stdout, "Telescope:\t%.0f queries/s with 100 samples\t%.0f queries/s with %d samples\n", rate[0], rate[1], TELESCOPE_ORIENTATION_SIZE);
+		delete[](roll);
+		delete[](yaw);
+	}
+
+	//	wrap heavy data, pointing north (yaw across -PI/PI) with roll around zero
+	{
+		scope->ClearOrientation();
+		const double truthyaw = M_PI -0.002;
+		const size_t updates = 2000000;
+		double windowsum = 0;
+		uint32_t seed = 54321;
+		double elapsed = test_seconds();
+		for(size_t pos=0; updates>pos; ++pos)
+		{
+			seed = seed *1103515245 +12345;
+			double noise = ((seed >>8) %10000) /10000.0 -0.5;
+			double yaw = remainder(truthyaw +0.03 *noise, 2.0 *M_PI);
+			scope->PushOrientation(0.004 *noise, 0.5, yaw, now, 0);
+			if(updates -TELESCOPE_ORIENTATION_SIZE <= pos)
+				windowsum += yaw;
+		}
+		elapsed = test_seconds() -elapsed;
+		piScope::MHOrientationEstimate estimate;
+		scope->GetOrientation(&estimate);
+		double circular = fabs(remainder(estimate.Yaw -truthyaw, 2.0 *M_PI));
+		double arithmetic = fabs(remainder(windowsum /TELESCOPE_ORIENTATION_SIZE -truthyaw, 2.0 *M_PI));
+		fprintf(stdout, "Telescope:\twrapping yaw error %g rad circular, %g rad arithmetic\t%.1f ns per update\t%zu samples kept\n"
+			, circular, arithmetic, elapsed *1e9 /updates, estimate.Count);
+		if(0.001 < circular || 0.001 < fabs(estimate.Roll) || TELESCOPE_ORIENTATION_SIZE != estimate.Count || 0.02 < estimate.YawDeviation)
+		{
+			fprintf(stdout, "Telescope:\tcircular mean not stable across wrap\n");
+			++failed;
+		}
+	}
+
+	delete(scope);
+
+	//	adaptive poll rate, simulated clock
+	{
+		piScope::MHPollScheduler scheduler;
+		scheduler.SetSensorInterval(4);
+		uint64_t now = 1000000000;
+		//	still, idle after TELESCOPE_POLL_IDLEAFTER seconds
+		uint64_t period = 0;
+		uint64_t idlesince = 0;
+		while(now < (TELESCOPE_POLL_IDLEAFTER +10) *1000000000ULL)
+		{
+			period = scheduler.Update(now, true, 0.01, true);
+			if(0 == idlesince && piScope::PollState_IDLE == scheduler.GetState())
+				idlesince = now;
+			now += period;
+		}
+		double idleafter = (idlesince -1000000000.0) /1e9;
+		if(piScope::PollState_IDLE != scheduler.GetState() || 1000000000 /TELESCOPE_POLL_IDLE != period || 1.0 < fabs(idleafter -TELESCOPE_POLL_IDLEAFTER))
+		{
+			fprintf(stdout, "Telescope:\tnot idle after %f s without motion\n", idleafter);
+			++failed;
+		}
+		//	single spike wakes up, but does not count as slewing
+		scheduler.Update(now, true, 1.0, false);
+		now += 20000000;
+		period = scheduler.Update(now, true, 0.01, false);
+		now += period;
+		if(piScope::PollState_TRACKING != scheduler.GetState() || 1000000000 /TELESCOPE_POLL_TRACKING != period)
+		{
+			fprintf(stdout, "Telescope:\tspike not handled as tracking (state %d)\n", scheduler.GetState());
+			++failed;
+		}
+		//	consecutive motion, slewing at sensor rate until hold time passed
+		for(int sample=0; TELESCOPE_POLL_SLEWSAMPLES>sample; ++sample)
+		{
+			period = scheduler.Update(now, true, 1.0, false);
+			now += period;
+		}
+		if(piScope::PollState_SLEWING != scheduler.GetState() || 4000000 != period)
+		{
+			fprintf(stdout, "Telescope:\tnot slewing at sensor rate (state %d, period %llu)\n", scheduler.GetState(), (unsigned long long)period);
+			++failed;
+		}
+		uint64_t stopped = now;
+		while(piScope::PollState_SLEWING == scheduler.GetState() && now < stopped +10000000000ULL)
+		{
+			now += scheduler.Update(now, true, 0.01, true);
+		}
+		double hold = (now -stopped) /1e9;
+		if(piScope::PollState_TRACKING != scheduler.GetState() || 0.1 < fabs(hold -TELESCOPE_POLL_SLEWHOLD))
+		{
+			fprintf(stdout, "Telescope:\tslewing not left after %f s\n", hold);
+			++failed;
+		}
+		//	failing polls, exponential backoff from sensor period up to maximum, then resume
+		uint64_t expected = 4000000;
+		for(int failure=0; 10>failure; ++failure)
+		{
+			period = scheduler.Update(now, false, 0, false);
+			now += period;
+			if(period != expected || piScope::PollState_BACKOFF != scheduler.GetState())
+			{
+				fprintf(stdout, "Telescope:\tbackoff %llu ns, expected %llu ns\n", (unsigned long long)period, (unsigned long long)expected);
+				++failed;
+				break;
+			}
+			expected = (expected *2 > TELESCOPE_POLL_BACKOFF *1000000ULL ?TELESCOPE_POLL_BACKOFF *1000000ULL :expected *2);
+		}
+		period = scheduler.Update(now, true, 0.01, true);
+		piScope::MHPollStatistics statistics;
+		scheduler.GetStatistics(statistics);
+		if(piScope::PollState_TRACKING != statistics.State || 10 != statistics.Failures || period != statistics.Period || 6 != statistics.Transitions)
+		{
+			fprintf(stdout, "Telescope:\tbackoff not resumed (state %d, %llu transitions)\n", statistics.State, (unsigned long long)statistics.Transitions);
+			++failed;
+		}
+
+		//	one hour, 5 minutes slewing, against fixed 100Hz polling
+		piScope::MHPollScheduler night;
+		night.SetSensorInterval(4);
+		uint64_t polls = 0;
+		for(now=1000000000; 3601000000000ULL>now; ++polls)
+		{
+			bool slewing = (600000000000ULL <= now && 900000000000ULL > now);
+			now += night.Update(now, true, (slewing ?0.5 :0.01), !slewing);
+		}
+		night.GetStatistics(statistics);
+		fprintf(stdout, "Telescope:\tadaptive %llu polls per hour (%.0f%% of 100Hz)\ttracking %.0fs slewing %.0fs idle %.0fs\n"
+			, (unsigned long long)polls, polls *100.0 /360000
+			, statistics.Time[piScope::PollState_TRACKING] /1e9, statistics.Time[piScope::PollState_SLEWING] /1e9, statistics.Time[piScope::PollState_IDLE] /1e9);
+		if(polls > 360000 /4)
+		{
+			fprintf(stdout, "Telescope:\tadaptive polling saves too little\n");
+			++failed;
+		}
+	}
+
+	fprintf(stdout, "Telescope:\t%s\n", (0 == failed ?"OK" :"FAILED"));
+	return(0 == failed ?0 :1);
+}
+
+typedef struct test_pacer_thread
+{
+	int policy;
+	int cpu;
+	rpiScope::Thread_Pacer* pacer;
+	int periods;
+	double elapsed;
+}	test_pacer_thread;
+static void* test_pacer_polling(void* data)
+{
+	test_pacer_thread* thread = (test_pacer_thread*)data;
+	struct sched_param param;
+	pthread_getschedparam(pthread_self(), &thread->policy, &param);
+	thread->cpu = sched_getcpu();
+	//	polling loop with varying work, shorter than period
+	double start = test_seconds();
+	thread->pacer->Start();
+	for(int period=0; thread->periods>period; ++period)
+	{
+		double busy = test_seconds() +(period %5) *100e-6;
+		while(busy > test_seconds());
+		thread->pacer->Wait();
+	}
+	thread->elapsed = test_seconds() -start;
+	return(NULL);
+}
+typedef struct test_pacer_recording
+{
+	rpiScope::Metrics_Histogram* histogram;
+	uint64_t records;
+	double seconds;
+}	test_pacer_recording;
+static void* test_pacer_recorder(void* data)
+{
+	test_pacer_recording* recording = (test_pacer_recording*)data;
+	double start = test_seconds();
+	for(uint64_t value=0; recording->records>value; ++value)
+		recording->histogram->Record(value &0xFFFF);
+	recording->seconds = test_seconds() -start;
+	return(NULL);
+}
+int test_pacer(int argc, char* argv[], char* envp[])
+{
+	//	parameters may be unused
+	(void)argc;
+	(void)argv;
+	(void)envp;
+	int failed = 0;
+	char summary[400];
+
+	//	real time thread, falls back to default scheduling without privileges
+	rpiScope::Thread_Config config;
+	config.Priority = 10;
+	config.CPU = 0;
+	config.LockMemory = false;
+	rpiScope::Thread_Pacer pacer(1000000);
+	test_pacer_thread thread;
+	memset(&thread, 0x00, sizeof(thread));
+	thread.pacer = &pacer;
+	thread.periods = 1000;
+	pthread_t handle;
+	pthread_attr_t attributes;
+	int rc = rpiScope::Thread_Create(&handle, &attributes, config, test_pacer_polling, &thread);
+	if(0 != rc)
+	{
+		fprintf(stdout, "Pacer:\tthread creation failed (%d)\n", rc);
+		return(1);
+	}
+	pthread_join(handle, NULL);
+	pthread_attr_destroy(&attributes);
+	rpiScope::Thread_Jitter jitter;
+	pacer.Snapshot(jitter);
+	rpiScope::Thread_Pacer::Format(jitter, &summary[0], sizeof(summary));
+	fprintf(stdout, "Pacer:\t%s on CPU %d\t%d periods in %f s\n", (SCHED_FIFO == thread.policy ?"SCHED_FIFO" :"SCHED_OTHER"), thread.cpu, thread.periods, thread.elapsed);
+	fprintf(stdout, "Pacer:\t%s\n", &summary[0]);
+	if(0 != thread.cpu)
+	{
+		fprintf(stdout, "Pacer:\tthread not pinned to CPU 0\n");
+		++failed;
+	}
+	//	absolute deadlines, work does not add up
+	if(thread.elapsed < 0.999 || thread.elapsed > 1.1)
+	{
+		fprintf(stdout, "Pacer:\tpaced loop drifted\n");
+		++failed;
+	}
+	uint64_t counted = 0;
+	for(int bucket=0; THREAD_JITTER_BUCKETS>bucket; ++bucket)
+		counted += jitter.Bucket[bucket];
+	if((uint64_t)thread.periods -1 != jitter.Periods || counted != jitter.Periods || jitter.MinPeriod > jitter.MaxPeriod || 1000000 != jitter.Target)
+	{
+		fprintf(stdout, "Pacer:\tjitter histogram inconsistent\n");
+		++failed;
+	}
+
+	//	relative sleeping for comparison
+	double start = test_seconds();
+	for(int period=0; thread.periods>period; ++period)
+	{
+		double busy = test_seconds() +(period %5) *100e-6;
+		while(busy > test_seconds());
+		usleep(1000);
+	}
+	fprintf(stdout, "Pacer:\tusleep loop %d periods in %f s\n", thread.periods, test_seconds() -start);
+
+	//	missed deadlines skipped, phase kept
+	pacer.Reset();
+	pacer.Start();
+	pacer.Wait();
+	usleep(5500);
+	bool kept = pacer.Wait();
+	pacer.Snapshot(jitter);
+	//	late deadline served, following 4 skipped
+	fprintf(stdout, "Pacer:\t%llu overruns after 5.5 periods\n", (unsigned long long)jitter.Overruns);
+	if(kept || 4 != jitter.Overruns)
+	{
+		fprintf(stdout, "Pacer:\tmissed deadlines not detected\n");
+		++failed;
+	}
+	//	changed period, target of histogram follows
+	pacer.SetPeriod(2000000);
+	pacer.Wait();
+	pacer.Wait();
+	pacer.Snapshot(jitter);
+	if(2000000 != jitter.Target || 1 != jitter.Periods || jitter.MinPeriod < 1900000)
+	{
+		fprintf(stdout, "Pacer:\tperiod change not applied (%llu)\n", (unsigned long long)jitter.MinPeriod);
+		++failed;
+	}
+
+	//	histogram buckets, relative error bounded
+	for(uint64_t value=1; (uint64_t)1 <<62 > value; value = value *3 /2 +1)
+	{
+		size_t index = rpiScope::Metrics_Histogram::Index(value);
+		uint64_t lowest = rpiScope::Metrics_Histogram::Lowest(index);
+		uint64_t highest = rpiScope::Metrics_Histogram::Highest(index);
+		if(METRICS_BUCKETS <= index || lowest > value || highest < value || (highest -lowest) *METRICS_SUBBUCKETS > lowest)
+		{
+			fprintf(stdout, "Pacer:\thistogram bucket %zu [%llu,%llu] wrong for %llu\n", index, (unsigned long long)lowest, (unsigned long long)highest, (unsigned long long)value);
+			++failed;
+			break;
+		}
+	}
+	rpiScope::Metrics_Histogram* histogram = new rpiScope::Metrics_Histogram;
+	rpiScope::Metrics_HistogramSnapshot* snapshot = new rpiScope::Metrics_HistogramSnapshot;
+	for(uint64_t value=1; 100000>=value; ++value)
+		histogram->Record(value);
+	histogram->Snapshot(*snapshot);
+	rpiScope::Metrics_Loop::Format("uniform", *snapshot, &summary[0], sizeof(summary));
+	fprintf(stdout, "Pacer:\t%s\n", &summary[0]);
+	if(100000 != snapshot->Count || 1 != snapshot->Min || 100000 != snapshot->Max || 50000.5 != snapshot->Mean()
+		|| 50000 *0.07 < fabs(snapshot->Percentile(50.0) -50000.0) || 99000 *0.07 < fabs(snapshot->Percentile(99.0) -99000.0))
+	{
+		fprintf(stdout, "Pacer:\thistogram percentiles wrong\n");
+		++failed;
+	}
+
+	//	single writer against snapshots from other thread, counts never behind
+	histogram->Reset();
+	test_pacer_recording writer;
+	writer.histogram = histogram;
+	writer.records = 5000000;
+	writer.seconds = 0.0;
+	pthread_t writing;
+	pthread_create(&writing, NULL, test_pacer_recorder, &writer);
+	uint64_t lastcount = 0, snapshots = 0, behind = 0;
+	do
+	{
+		histogram->Snapshot(*snapshot);
+		uint64_t counted = 0;
+		for(size_t index=0; METRICS_BUCKETS>index; ++index)
+			counted += snapshot->Bucket[index];
+		if(counted < snapshot->Count || lastcount > snapshot->Count)
+			++behind;
+		lastcount = snapshot->Count;
+		++snapshots;
+	}	while(writer.records > lastcount);
+	pthread_join(writing, NULL);
+	fprintf(stdout, "Pacer:\t%.1f ns per record\t%llu snapshots while recording\n", writer.seconds *1e9 /writer.records, (unsigned long long)snapshots);
+	if(0 != behind)
+	{
+		fprintf(stdout, "Pacer:\t%llu inconsistent snapshots\n", (unsigned long long)behind);
+		++failed;
+	}
+	delete(snapshot);
+	delete(histogram);
+
+	//	periodic dump into log file
+	{
+		char logname[] = "/tmp/test_pacer.XXXXXX";
+		int fd = mkstemp(&logname[0]);
+		close(fd);
+		piScope::MHLogFile* log = new piScope::MHLogFile(&logname[0], 8, "test_pacer");
+		rpiScope::Metrics_Loop* metrics = new rpiScope::Metrics_Loop;
+		for(int loop=0; 1000>loop; ++loop)
+		{
+			metrics->Loop(loop *1000000ULL +1);
+			metrics->ReadDuration.Record(200000 +loop);
+			metrics->Reads.Add();
+		}
+		int written = log->printMetrics(8, "IMU", *metrics);
+		int filtered = log->printMetrics(9, "IMU", *metrics);
+		delete(log);
+		delete(metrics);
+		char content[4096] = {0};
+		FILE* file = fopen(&logname[0], "r");
+		size_t length = (NULL != file ?fread(&content[0], 1, sizeof(content) -1, file) :0);
+		if(NULL != file)
+			fclose(file);
+		unlink(&logname[0]);
+		if(0 >= written || 0 != filtered || 0 == length || NULL == strstr(&content[0], "reads=1000") || NULL == strstr(&content[0], "period[ns] n=999 min=1000000"))
+		{
+			fprintf(stdout, "Pacer:\tmetrics dump into log file missing\n%s", &content[0]);
+			++failed;
+		}
+	}
+
+	fprintf(stdout, "Pacer:\t%s\n", (0 == failed ?"OK" :"FAILED"));
+	return(0 == failed ?0 :1);
+}
+
+//	location publishing anchors late, like a refresh that read the longitude before it changed
+class test_astrotime_location : public piScope::MHLocation
+{
+	public:
+		test_astrotime_location(double lat, double lon, double height, const char* name) : piScope::MHLocation(lat, lon, height, name) {}
+		piScope::MHSiderealAnchor Anchor(void) const
+		{
+			piScope::MHSiderealAnchor anchor;
+			this->SiderealCache.Read(anchor);
+			return(anchor);
+		}
+		void Publish(const piScope::MHSiderealAnchor& anchor)
+		{
+			this->SiderealCache.Write(anchor);
+		}
+};
+
+int test_astrotime(int argc, char* argv[], char* envp[])
+{
+	//	parameters may be unused
+	(void)argc;
+	(void)argv;
+	(void)envp;
+	int failed = 0;
+
+	//	Meeus, Astronomical Algorithms, example 12.a: 1987-04-10 0h UT, GMST 13h10m46.3668s
+	piScope::MHAstroTime meeus(545011200);
+	double gmst = meeus.GetAngleMST() * (EARTH_SECONDSPERDAY / FULLCIRCLE_DEGREE);
+	double expected = 13*3600 + 10*60 + 46.3668;
+	if(0.001 < fabs(gmst - expected) || 1e-9 < fabs(meeus.GetJulianDate() - 2446895.5) || 1e-9 < fabs(meeus.GetJulianDate(true) - 46895.0))
+	{
+		fprintf(stdout, "AstroTime:\tMeeus 12.a GMST %.4fs expected %.4fs, JD %.6f\n", gmst, expected, meeus.GetJulianDate());
+		++failed;
+	}
+	fprintf(stdout, "AstroTime:\tMeeus 12.a\tGMST %.4fs\t%+.4fs\n", gmst, gmst - expected);
+	//	example 12.b: 1987-04-10 19h21m00s UT, GMST 8h34m57.0896s
+	meeus.Set(545080860);
+	gmst = meeus.GetAngleMST() * (EARTH_SECONDSPERDAY / FULLCIRCLE_DEGREE);
+	expected = 8*3600 + 34*60 + 57.0896;
+	if(0.001 < fabs(gmst - expected) || 8*3600 + 34*60 + 57 != meeus.Get(1))
+	{
+		fprintf(stdout, "AstroTime:\tMeeus 12.b GMST %.4fs expected %.4fs\n", gmst, expected);
+		++failed;
+	}
+	fprintf(stdout, "AstroTime:\tMeeus 12.b\tGMST %.4fs\t%+.4fs\n", gmst, gmst - expected);
+
+	//	sub-second resolution, IMU time stamp in micro seconds is not truncated to whole seconds
+	uint64_t imustamp = (uint64_t)545080860 * 1000000 + 500000;
+	meeus.SetJ2000(J2000_UNIXUS2NS(imustamp));
+	double advance = meeus.GetAngleMST() * (EARTH_SECONDSPERDAY / FULLCIRCLE_DEGREE) - gmst;
+	if(1e-6 < fabs(advance - 0.5 * 1.00273790935) || 545080860 != meeus.Get() || 1e-9 < fabs(meeus.GetJulianDate() - 2446896.30625 - 0.5 / EARTH_SECONDSPERDAY))
+	{
+		fprintf(stdout, "AstroTime:\t0.5s advance GMST %.9fs, UTC %ld\n", advance, (long)meeus.Get());
+		++failed;
+	}
+	fprintf(stdout, "AstroTime:\t0.5s UT\t%.6fs GMST\t%.2f arcsec (lost by whole seconds)\n", advance, advance * 15);
+	//	one nano second still changes the angle today
+	piScope::MHAstroTime now(1);
+	double before = piScope::MHAstroTime::AngleGMST(now.GetJ2000());
+	double after = piScope::MHAstroTime::AngleGMST(now.GetJ2000() + 1000);
+	if(!(after > before) || 1e-7 < fabs((after - before) * 3600 - 1e-6 * 15.04107))
+	{
+		fprintf(stdout, "AstroTime:\t1us GMST step %.3e arcsec\n", (after - before) * 3600);
+		++failed;
+	}
+	//	negative time stamps before J2000.0 and whole UTC seconds
+	meeus.SetJ2000(-1);
+	if(J2000_EPOCH_UT -1 != meeus.Get() || 280.46061837 <= meeus.GetAngleMST())
+	{
+		fprintf(stdout, "AstroTime:\tJ2000.0 -1ns UTC %ld GMST %.9f\n", (long)meeus.Get(), meeus.GetAngleMST());
+		++failed;
+	}
+	//	local sidereal time adds east longitude
+	piScope::MHLocation here(TESTLOCATION);
+	piScope::MHAstroTime local(545080860, &here);
+	double lmst = local.GetAngleMST(false) - local.GetAngleMST(true);
+	if(1e-9 < fabs(fmod(lmst + FULLCIRCLE_DEGREE, FULLCIRCLE_DEGREE) - here.GetLongitude()))
+	{
+		fprintf(stdout, "AstroTime:\tLMST-GMST %.9f for longitude %.9f\n", lmst, here.GetLongitude());
+		++failed;
+	}
+	//	vector time stamp
+	piScope::MHAstroVector vector(piScope::VectorType_LocalRPY, 0,0,0, 0, &here);
+	if(J2000_UNIXUS2NS(imustamp) != vector.SetTimeJ2000(J2000_UNIXUS2NS(imustamp))->GetJ2000())
+	{
+		fprintf(stdout, "AstroTime:\tvector time stamp lost resolution\n");
+		++failed;
+	}
+	//	hour angle of vector uses local sidereal time
+	vector.Set(piScope::VectorType_LocalRPY, 0,0,DEG2RAD(10.0), 0);
+	vector.SetTime(545080860);
+	double hourangle = local.GetAngleMST(false) - 10.0;
+	if(1e-9 < fabs(vector.GetLocalSiderealAngle() - (0 > hourangle ?hourangle +360 :hourangle)))
+	{
+		fprintf(stdout, "AstroTime:\tvector hour angle %.9f expected %.9f\n", vector.GetLocalSiderealAngle(), hourangle);
+		++failed;
+	}
+	//	macro wraps far time stamps without loops
+	double macro;
+	J2000_UTC2LMST(545080860, macro, 0);
+	if(0.01 < fabs(macro - (8*3600 + 34*60 + 57.0896)))
+	{
+		fprintf(stdout, "AstroTime:\tJ2000_UTC2LMST %.4fs\n", macro);
+		++failed;
+	}
+
+	//	batch conversion of 100k time stamps and longitudes, +-50 years around J2000.0
+	const size_t objects = 100000;
+	int64_t* stamps = new int64_t[objects];
+	double* longitudes = new double[objects];
+	double* ra = new double[objects];
+	double* lmstbatch = new double[objects];
+	double* hourangles = new double[objects];
+	uint64_t seed = 42;
+	for(size_t index=0; objects>index; ++index)
+	{
+		seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+		stamps[index] = (int64_t)(seed >> 1) % (18262 * TIME_NSPERDAY) * (0 != (seed &1) ?1 :-1);
+		longitudes[index] = (double)(seed >> 40) / (1 << 24) * 360.0 - 180.0;
+		ra[index] = (double)((seed >> 16) &0xFFFFFF) / (1 << 24) * 360.0;
+	}
+	piScope::MHAstroTime::AngleLMST(stamps, longitudes, lmstbatch, objects);
+	double worst = 0;
+	for(size_t index=0; objects>index; ++index)
+	{
+		double scalar = fmod(piScope::MHAstroTime::AngleGMST(stamps[index]) + longitudes[index] + 360.0, 360.0);
+		double error = fabs(lmstbatch[index] - scalar);
+		error = (180 < error ?360 - error :error);
+		worst = (error > worst ?error :worst);
+		if(!(0 <= lmstbatch[index] && 360 > lmstbatch[index]))
+			worst = 360;
+	}
+	piScope::MHAstroTime::HourAngle(lmstbatch, ra, hourangles, objects);
+	for(size_t index=0; objects>index; ++index)
+	{
+		double expected = fmod(lmstbatch[index] - ra[index] + 360.0, 360.0);
+		if(1e-9 < fabs(hourangles[index] - expected))
+			worst = 360;
+	}
+	if(1e-8 < worst)
+	{
+		fprintf(stdout, "AstroTime:\tbatch LMST differs %.3e degrees from scalar\n", worst);
+		++failed;
+	}
+	fprintf(stdout, "AstroTime:\tbatch LMST\t%.1e arcsec worst difference to scalar (+-50 years)\n", worst * 3600);
+
+	//	benchmark, one object at a time against batch
+	int rounds = 20;
+	double sink = 0;
+	double start = test_seconds();
+	for(int round=0; rounds>round; ++round)
+	{
+		for(size_t index=0; objects>index; ++index)
+		{
+			double angle = piScope::MHAstroTime::AngleGMST(stamps[index]) + longitudes[index] - ra[index];
+			angle = fmod(angle, 360.0);
+			hourangles[index] = (0 > angle ?angle + 360.0 :angle);
+		}
+		sink += hourangles[round];
+	}
+	double scalarrate = rounds * objects / (test_seconds() - start);
+	start = test_seconds();
+	for(int round=0; rounds>round; ++round)
+	{
+		piScope::MHAstroTime::AngleLMST(stamps, longitudes, lmstbatch, objects);
+		piScope::MHAstroTime::HourAngle(lmstbatch, ra, hourangles, objects);
+		sink += hourangles[round];
+	}
+	double batchrate = rounds * objects / (test_seconds() - start);
+	//	catalog re-projection every second, one LMST for all objects
+	start = test_seconds();
+	for(int round=0; rounds>round; ++round)
+	{
+		piScope::MHAstroTime::HourAngle(local.GetAngleMST(false) + round * 0.004178, ra, hourangles, objects);
+		sink += hourangles[round];
+	}
+	double catalog = (test_seconds() - start) / rounds;
+	if(0.1 < catalog || !(batchrate > 0.8 * scalarrate) || sink != sink)
+	{
+		fprintf(stdout, "AstroTime:\tbatch %.0f conversions/s, scalar %.0f conversions/s, catalog %.3fms\n", batchrate, scalarrate, catalog *1000);
+		++failed;
+	}
+	fprintf(stdout, "AstroTime:\thour angle\t%.2f Mconversions/s scalar\t%.2f Mconversions/s batch\t%.2fms per %zu object catalog\n"
+		, scalarrate /1e6, batchrate /1e6, catalog *1000, objects);
+
+	//	LMST interpolation cache of location, tracking loop at 1kHz for one hour
+	piScope::MHLocation observer(TESTLOCATION);
+	int64_t tracking = now.GetJ2000();
+	unsigned long refreshs = observer.GetSiderealRefreshs();
+	double cacheworst = 0;
+	for(int64_t step=0; 3600000>step; ++step)
+	{
+		int64_t ns = tracking + step * 1000000;
+		double direct = DEGREE_WRAP(piScope::MHAstroTime::AngleGMST(ns) + observer.GetLongitude());
+		double error = fabs(observer.GetAngleLMST(ns) - direct);
+		error = (180 < error ?360 - error :error);
+		cacheworst = (error > cacheworst ?error :cacheworst);
+	}
+	refreshs = observer.GetSiderealRefreshs() - refreshs;
+	//	random access over +-50 years refreshes every time, still exact
+	for(size_t index=0; objects>index; ++index)
+	{
+		double direct = DEGREE_WRAP(piScope::MHAstroTime::AngleGMST(stamps[index]) + observer.GetLongitude());
+		double error = fabs(observer.GetAngleLMST(stamps[index]) - direct);
+		error = (180 < error ?360 - error :error);
+		cacheworst = (error > cacheworst ?error :cacheworst);
+	}
+	if(1e-9 < cacheworst || 3600 / SIDEREAL_CACHE_SPAN +1 < refreshs)
+	{
+		fprintf(stdout, "AstroTime:\tLMST cache differs %.3e degrees, %lu refreshs for one hour\n", cacheworst, refreshs);
+		++failed;
+	}
+	//	new longitude invalidates anchors
+	double lmstbefore = observer.GetAngleLMST(tracking);
+	observer.Set(observer.GetLatitude(), observer.GetLongitude() + 1.0, observer.GetHeight());
+	double shift = observer.GetAngleLMST(tracking) - lmstbefore;
+	if(1e-9 < fabs((0 > shift ?shift + 360 :shift) - 1.0))
+	{
+		fprintf(stdout, "AstroTime:\tLMST cache kept old longitude, shift %.9f degrees\n", shift);
+		++failed;
+	}
+	//	anchor of old longitude published after the change is not used
+	test_astrotime_location late(TESTLOCATION);
+	lmstbefore = late.GetAngleLMST(tracking);
+	piScope::MHSiderealAnchor stale = late.Anchor();
+	late.Set(late.GetLatitude(), late.GetLongitude() + 1.0, late.GetHeight());
+	late.Publish(stale);
+	shift = late.GetAngleLMST(tracking) - lmstbefore;
+	if(1e-9 < fabs((0 > shift ?shift + 360 :shift) - 1.0))
+	{
+		fprintf(stdout, "AstroTime:\tLMST from anchor published with old longitude, shift %.9f degrees\n", shift);
+		++failed;
+	}
+	//	lookup cost, cached against direct polynomial
+	rounds = 2000000;
+	start = test_seconds();
+	for(int round=0; rounds>round; ++round)
+	{
+		sink += observer.GetAngleLMST(tracking + (int64_t)round * 1000000);
+	}
+	double cached = (test_seconds() - start) / rounds;
+	start = test_seconds();
+	for(int round=0; rounds>round; ++round)
+	{
+		sink += DEGREE_WRAP(piScope::MHAstroTime::AngleGMST(tracking + (int64_t)round * 1000000) + observer.GetLongitude());
+	}
+	double direct = (test_seconds() - start) / rounds;
+	if(!(cached < direct) || sink != sink)
+	{
+		fprintf(stdout, "AstroTime:\tLMST cache %.1fns per lookup, direct %.1fns\n", cached *1e9, direct *1e9);
+		++failed;
+	}
+	fprintf(stdout, "AstroTime:\tLMST cache\t%.1fns cached\t%.1fns direct\t%.1e arcsec worst\t%lu refreshs per hour\n"
+		, cached *1e9, direct *1e9, cacheworst *3600, refreshs);
+
+	//	Meeus, example 13.b: Venus at Washington 1987-04-10 19h21m00s UT, A=68.0337 (from south) h=15.1249
+	piScope::MHLocation washington(LATLON_DMS2DEG(38,55,17), -LATLON_DMS2DEG(77,3,56), 0, "USNO");
+	piScope::MHTransform horizon(&washington);
+	int64_t venustime = J2000_UTC2NS(545080860);
+	double venusra = (23 + 9/60.0 + 16.641/3600) * 15;
+	double venusdec = -LATLON_DMS2DEG(6,43,11.61);
+	double azimuth, altitude;
+	horizon.Equatorial2Horizontal(venusra, venusdec, venustime, &azimuth, &altitude);
+	double backra, backdec;
+	horizon.Horizontal2Equatorial(azimuth, altitude, venustime, &backra, &backdec);
+	//	apparent sidereal time as Meeus, azimuth and altitude given to 0.0001 degrees
+	if(0.0002 < fabs(azimuth - (68.0337 + 180)) || 0.0002 < fabs(altitude - 15.1249) || 1e-9 < fabs(backra - venusra) || 1e-9 < fabs(backdec - venusdec))
+	{
+		fprintf(stdout, "AstroTime:\tMeeus 13.b A=%.4f h=%.4f, back %.9f %.9f\n", azimuth -180, altitude, backra, backdec);
+		++failed;
+	}
+	fprintf(stdout, "AstroTime:\tMeeus 13.b\tA %.4f (%+.1f arcsec)\th %.4f (%+.1f arcsec)\n"
+		, azimuth -180, (azimuth -180 -68.0337) *3600, altitude, (altitude -15.1249) *3600);
+	//	zenith is LMST and latitude, celestial pole above north point at latitude
+	double zenithra, zenithdec, polera, poledec, ha, hadec;
+	horizon.Horizontal2Equatorial(0, 90, venustime, &zenithra, &zenithdec);
+	horizon.Horizontal2Equatorial(0, washington.GetLatitude(), venustime, &polera, &poledec);
+	horizon.Horizontal2HourAngle(azimuth, altitude, &ha, &hadec);
+	//	apparent local sidereal time, mean plus equation of equinoxes
+	piScope::MHPrecession apparent;
+	double last = DEGREE_WRAP(washington.GetAngleLMST(venustime) + apparent.GetEquationOfEquinoxes(venustime));
+	double expectedha = DEGREE_WRAP(last - venusra);
+	if(1e-9 < fabs(zenithra - last) || 1e-9 < fabs(zenithdec - washington.GetLatitude())
+		|| 1e-9 < fabs(poledec - 90) || 1e-9 < fabs(ha - expectedha) || 1e-9 < fabs(hadec - venusdec))
+	{
+		fprintf(stdout, "AstroTime:\tzenith %.9f %.9f, pole %.9f, hour angle %.9f expected %.9f\n", zenithra, zenithdec, poledec, ha, expectedha);
+		++failed;
+	}
+	//	telescope orientation, optical axis pointing at Venus
+	horizon.Orientation2Equatorial(0.3, DEG2RAD(altitude), DEG2RAD(azimuth), venustime, &backra, &backdec);
+	if(1e-9 < fabs(backra - venusra) || 1e-9 < fabs(backdec - venusdec))
+	{
+		fprintf(stdout, "AstroTime:\torientation %.9f %.9f\n", backra, backdec);
+		++failed;
+	}
+
+	//	batch of pointing vectors against single conversions
+	double* x = new double[objects];
+	double* y = new double[objects];
+	double* z = new double[objects];
+	double* outx = new double[objects];
+	double* outy = new double[objects];
+	double* outz = new double[objects];
+	for(size_t index=0; objects>index; ++index)
+	{
+		//	random directions above horizon, azimuth and altitude reused from catalog
+		double az = ra[index];
+		double alt = DEGREE_WRAP(longitudes[index]) / 4;
+		longitudes[index] = alt;
+		x[index] = cos(DEG2RAD(alt)) * sin(DEG2RAD(az));
+		y[index] = cos(DEG2RAD(alt)) * cos(DEG2RAD(az));
+		z[index] = sin(DEG2RAD(alt));
+	}
+	horizon.Convert(x, y, z, outx, outy, outz, objects, venustime);
+	horizon.Horizontal2Equatorial(ra, longitudes, lmstbatch, hourangles, objects, venustime);
+	worst = 0;
+	for(size_t index=0; objects>index; ++index)
+	{
+		double singlera, singledec;
+		horizon.Horizontal2Equatorial(ra[index], longitudes[index], venustime, &singlera, &singledec);
+		double error = fabs(lmstbatch[index] - singlera);
+		error = (180 < error ?360 - error :error) * cos(DEG2RAD(singledec));
+		error = fmax(error, fabs(hourangles[index] - singledec));
+		error = fmax(error, fabs(RAD2DEG(asin(outz[index])) - singledec));
+		worst = fmax(worst, error);
+	}
+	if(1e-9 < worst)
+	{
+		fprintf(stdout, "AstroTime:\tbatch transform differs %.3e degrees\n", worst);
+		++failed;
+	}
+	//	throughput, cached rotation against matrices built for every object
+	rounds = 20;
+	start = test_seconds();
+	for(int round=0; rounds>round; ++round)
+	{
+		for(size_t index=0; objects>index; ++index)
+		{
+			piScope::MHRotation sidereal = piScope::MHRotation::AxisZ(DEG2RAD(piScope::MHAstroTime::AngleGMST(venustime + round) + washington.GetLongitude()));
+			piScope::MHRotation rotation = sidereal.Multiply(washington.GetHorizon2Equator());
+			double in[3] = { x[index], y[index], z[index] };
+			double out[3];
+			rotation.Rotate(&in[0], &out[0]);
+			outx[index] = out[0];
+		}
+		sink += outx[round];
+	}
+	double unbatched = rounds * objects / (test_seconds() - start);
+	start = test_seconds();
+	for(int round=0; rounds>round; ++round)
+	{
+		horizon.Convert(x, y, z, outx, outy, outz, objects, venustime + round);
+		sink += outx[round];
+	}
+	double vectors = rounds * objects / (test_seconds() - start);
+	start = test_seconds();
+	for(int round=0; rounds>round; ++round)
+	{
+		horizon.Horizontal2Equatorial(ra, longitudes, lmstbatch, hourangles, objects, venustime + round);
+		sink += hourangles[round];
+	}
+	double angles = rounds * objects / (test_seconds() - start);
+	if(!(vectors > unbatched) || sink != sink)
+	{
+		fprintf(stdout, "AstroTime:\ttransform %.0f vectors/s batch, %.0f vectors/s unbatched\n", vectors, unbatched);
+		++failed;
+	}
+	fprintf(stdout, "AstroTime:\ttransform\t%.2f Mvectors/s unbatched\t%.2f Mvectors/s batch\t%.2f Mangles/s batch (az/alt to ra/dec)\n"
+		, unbatched /1e6, vectors /1e6, angles /1e6);
+
+	//	Meeus, example 22.a: 1987-04-10 0h TD, delta psi -3.788", delta epsilon +9.443", epsilon0 2326'27.407"
+	piScope::MHNutation nutation = piScope::MHPrecession::Nutation((2446895.5 - J2000_EPOCH_JD) / 36525);
+	if(0.001 < fabs(nutation.Longitude + 3.788) || 0.001 < fabs(nutation.Obliquity - 9.443)
+		|| 0.001 < fabs(nutation.MeanObliquity - LATLON_DMS2DEG(23,26,27.407)) *3600)
+	{
+		fprintf(stdout, "AstroTime:\tMeeus 22.a nutation %.4f\" %.4f\" obliquity 23deg26'%.4f\"\n", nutation.Longitude, nutation.Obliquity, (nutation.MeanObliquity -23) *3600 -26*60);
+		++failed;
+	}
+	fprintf(stdout, "AstroTime:\tMeeus 22.a\tdelta psi %.4f\"\tdelta epsilon %.4f\"\tepsilon0 23deg26'%.4f\"\n"
+		, nutation.Longitude, nutation.Obliquity, (nutation.MeanObliquity -23) *3600 -26*60);
+	//	Meeus, example 21.b: theta Persei J2000 2h44m12.975s +4913'39.90" to 2h46m11.331s +4920'54.54" at 2028-11-13.19 TD
+	double persei[3], precessed[3];
+	double perseira = (2 + 44/60.0 + 12.975/3600) * 15;
+	double perseidec = LATLON_DMS2DEG(49,13,39.90);
+	persei[0] = cos(DEG2RAD(perseidec)) * cos(DEG2RAD(perseira));
+	persei[1] = cos(DEG2RAD(perseidec)) * sin(DEG2RAD(perseira));
+	persei[2] = sin(DEG2RAD(perseidec));
+	piScope::MHPrecession::Precession((2462088.69 - J2000_EPOCH_JD) / 36525).Rotate(&persei[0], &precessed[0]);
+	double precessedra = DEGREE_WRAP(RAD2DEG(atan2(precessed[1], precessed[0])));
+	double precesseddec = RAD2DEG(asin(precessed[2]));
+	double errorra = (precessedra - (2 + 46/60.0 + 11.331/3600) * 15) *3600 /15;
+	double errordec = (precesseddec - LATLON_DMS2DEG(49,20,54.54)) *3600;
+	if(0.002 < fabs(errorra) || 0.01 < fabs(errordec))
+	{
+		fprintf(stdout, "AstroTime:\tMeeus 21.b %+.4fs %+.4f\"\n", errorra, errordec);
+		++failed;
+	}
+	fprintf(stdout, "AstroTime:\tMeeus 21.b\tRA %+.4fs\tDEC %+.4f\"\n", errorra, errordec);
+	//	cache per minute against direct calculation, one hour of tracking
+	piScope::MHPrecession equinox;
+	int64_t persei2028 = (int64_t)((2462088.69 - J2000_EPOCH_JD) * 86400) * TIME_NSPERSECOND;
+	double precessionworst = 0;
+	for(int64_t second=0; 3600>second; ++second)
+	{
+		int64_t ns = persei2028 + second * TIME_NSPERSECOND;
+		double t = J2000_NS2DAYS(ns) / 36525;
+		piScope::MHRotation direct = piScope::MHPrecession::NutationMatrix(piScope::MHPrecession::Nutation(t)).Multiply(piScope::MHPrecession::Precession(t));
+		const piScope::MHRotation& cached = equinox.J20002Date(ns);
+		for(int row=0; 3>row; ++row)
+			for(int column=0; 3>column; ++column)
+				precessionworst = fmax(precessionworst, fabs(cached.M[row][column] - direct.M[row][column]));
+	}
+	unsigned long precessionrefreshs = equinox.Refreshs;
+	//	back and forth, J2000 of date and inverse
+	double back[3];
+	equinox.J20002Date(persei2028).Rotate(&persei[0], &precessed[0]);
+	equinox.Date2J2000(persei2028).Rotate(&precessed[0], &back[0]);
+	precessionworst = fmax(precessionworst, fabs(back[0] - persei[0]) + fabs(back[1] - persei[1]) + fabs(back[2] - persei[2]));
+	//	matrix entries are radians of rotation, 0.0001 arcsec = 4.8e-10
+	if(4.8e-10 < precessionworst || 3600 / PRECESSION_CACHE_SPAN +1 < precessionrefreshs)
+	{
+		fprintf(stdout, "AstroTime:\tprecession cache differs %.3e, %lu refreshs per hour\n", precessionworst, precessionrefreshs);
+		++failed;
+	}
+	//	J2000 catalog to horizon and back, pointing of telescope at J2000 target
+	piScope::MHTransform fixed(&washington, true);
+	fixed.Equatorial2Horizontal(perseira, perseidec, venustime, &azimuth, &altitude);
+	fixed.Horizontal2Equatorial(azimuth, altitude, venustime, &backra, &backdec);
+	double ofdatera, ofdatedec;
+	horizon.Horizontal2Equatorial(azimuth, altitude, venustime, &ofdatera, &ofdatedec);
+	//	1987 is 12.7 years before J2000, precession about 50" per year in longitude
+	double precession = fabs(ofdatera - perseira) *3600;
+	if(1e-9 < fabs(backra - perseira) || 1e-9 < fabs(backdec - perseidec) || 400 > precession || 1000 < precession)
+	{
+		fprintf(stdout, "AstroTime:\tJ2000 transform %.9f %.9f, precession %.1f\"\n", backra, backdec, precession);
+		++failed;
+	}
+	//	J2000 vectors validate as directions
+	piScope::MHVector3D j2000(piScope::VectorType_J2000, persei[0], persei[1], persei[2], 1.0);
+	piScope::MHVector3D j2000invalid(piScope::VectorType_J2000, 0, 0, 0, 1.0);
+	if(!j2000.Validate(true) || j2000invalid.Validate(true))
+	{
+		fprintf(stdout, "AstroTime:\tJ2000 vector validation\n");
+		++failed;
+	}
+	//	catalog of 100k J2000 objects to date, matrix per object against cached matrix
+	rounds = 10;
+	start = test_seconds();
+	for(int round=0; 2>round; ++round)
+	{
+		for(size_t index=0; objects>index; ++index)
+		{
+			double t = J2000_NS2DAYS(persei2028 + index * 1000000) / 36525;
+			piScope::MHRotation rotation = piScope::MHPrecession::NutationMatrix(piScope::MHPrecession::Nutation(t)).Multiply(piScope::MHPrecession::Precession(t));
+			double in[3] = { x[index], y[index], z[index] };
+			double out[3];
+			rotation.Rotate(&in[0], &out[0]);
+			outx[index] = out[0];
+		}
+		sink += outx[round];
+	}
+	double uncached = 2 * objects / (test_seconds() - start);
+	start = test_seconds();
+	for(int round=0; rounds>round; ++round)
+	{
+		equinox.J20002Date(persei2028 + (int64_t)round * 1000000000).Rotate(x, y, z, outx, outy, outz, objects);
+		sink += outx[round];
+	}
+	double cachedrate = rounds * objects / (test_seconds() - start);
+	start = test_seconds();
+	for(int round=0; rounds>round; ++round)
+	{
+		fixed.ConvertInverse(x, y, z, outx, outy, outz, objects, persei2028 + (int64_t)round * 1000000000);
+		sink += outx[round];
+	}
+	double horizonrate = rounds * objects / (test_seconds() - start);
+	if(!(cachedrate > 100 * uncached) || sink != sink)
+	{
+		fprintf(stdout, "AstroTime:\tprecession %.0f objects/s cached, %.0f objects/s uncached\n", cachedrate, uncached);
+		++failed;
+	}
+	fprintf(stdout, "AstroTime:\tprecession\t%.3f Mobjects/s per object matrix\t%.1f Mobjects/s cached\t%.1f Mobjects/s J2000 to horizon\t%lu refreshs per hour\n"
+		, uncached /1e6, cachedrate /1e6, horizonrate /1e6, precessionrefreshs);
+
+	delete[](x);
+	delete[](y);
+	delete[](z);
+	delete[](outx);
+	delete[](outy);
+	delete[](outz);
+
+	delete[](stamps);
+	delete[](longitudes);
+	delete[](ra);
+	delete[](lmstbatch);
+	delete[](hourangles);
+
+	fprintf(stdout, "AstroTime:\t%s\n", (0 == failed ?"OK" :"FAILED"));
+	return(0 == failed ?0 :1);
+}
+
+int main(int argc, char* argv[], char* envp[])
+{
+	//	parameters may be unused
+	(void)argc;
+	(void)envp;
+	//	programm greeting
+	std::cout << argv[0] << "\t" << "(build " << __DATE__ << ")" << std::endl;
+
+	// prepare signal handling
+	{
+#		ifdef WIN32
+		if (!SetConsoleCtrlHandler((PHANDLER_ROUTINE)signal_handler, TRUE))
+		{
+			std::cerr << "SetConsoleCtrlHandler failed" << std::endl;
+			return 127;
+		}
+#		else
+		//	ignore SIGPIPE
+		signal(SIGPIPE, SIG_IGN);
+		signal(SIGINT, signal_handler);
+		signal(SIGTERM, signal_handler);
+		signal(SIGQUIT, signal_handler);
+		//	?keep running after SIGHUP
+		//signal(SIGHUP,signal_handler);
+#		endif
+	}
+
+#	if defined(__TEST_I2CSENSOR__)
+		test_i2csensor(argc, argv, envp);
+#	elif defined(__TEST_VECTOR__)
+		test_vector(argc, argv, envp);
+#	elif defined(__TEST_RTIMULIB__)
+		test_rtimulib(argc, argv, envp);
+#	elif defined(__TEST_I2CBUS__)
+		int rc = test_i2cbus(argc, argv, envp);
+#	elif defined(__TEST_IMUDATA__)
+		int rc = test_imudata(argc, argv, envp);
+#	elif defined(__TEST_IMUREPLAY__)
+		int rc = test_imureplay(argc, argv, envp);
+#	elif defined(__TEST_TELESCOPE__)
+		int rc = test_telescope(argc, argv, envp);
+#	elif defined(__TEST_PACER__)
+		int rc = test_pacer(argc, argv, envp);
+#	elif defined(__TEST_ASTROTIME__)
+		int rc = test_astrotime(argc, argv, envp);
+#	else
+	int rc = 0;
+	for(int pos = 1; argc > pos; ++pos)
+	{
+		if(0 != strncmp(argv[pos],"--test",6))
+		{
+			//	not a program call
+		}
+		else if(NULL != strstr(argv[pos],"i2csensor"))
+		{
+			test_i2csensor(argc, argv, envp);
+		}
+		else if(NULL != strstr(argv[pos],"vector"))
+		{
+			test_vector(argc, argv, envp);
+		}
+		else if(NULL != strstr(argv[pos],"rtimulib"))
+		{
+			test_rtimulib(argc, argv, envp);
+		}
+		else if(NULL != strstr(argv[pos],"i2cbus"))
+		{
+			rc |= test_i2cbus(argc, argv, envp);
+		}
+		else if(NULL != strstr(argv[pos],"imudata"))
+		{
+			rc |= test_imudata(argc, argv, envp);
+		}
+		else if(NULL != strstr(argv[pos],"imureplay"))
+		{
+			rc |= test_imureplay(argc, argv, envp);
+		}
+		else if(NULL != strstr(argv[pos],"telescope"))
+		{
+			rc |= test_telescope(argc, argv, envp);
+		}
+		else if(NULL != strstr(argv[pos],"pacer"))
+		{
+			rc |= test_pacer(argc, argv, envp);
+		}
+		else if(NULL != strstr(argv[pos],"astrotime"))
+		{
+			rc |= test_astrotime(argc, argv, envp);
+		}
+	}
+#	endif // defined(__TEST_I2CSENSOR__) || defined(__TEST_VECTOR__) || defined(__TEST_RTIMULIB__) || defined(__TEST_I2CBUS__) || defined(__TEST_IMUDATA__) || defined(__TEST_IMUREPLAY__) || defined(__TEST_TELESCOPE__) || defined(__TEST_PACER__) || defined(__TEST_ASTROTIME__)
+
+	//	done
+	fprintf(stdout, "Bye.\n");
+#	if defined(__TEST_I2CSENSOR__) || defined(__TEST_VECTOR__) || defined(__TEST_RTIMULIB__)
+	return(0);
+#	else
+	return(rc);
+#	endif
+
 }